@@ -0,0 +1,37 @@
+; Demonstrate that JMP ($xxFF) wraps around within the page
+;
+; The NMOS 6502 doesn't carry into the high byte of the pointer, so
+; JMP ($xxFF) takes the low byte of its target from $xxFF and the high byte
+; from $xx00, not from the start of the next page.
+;
+; Returns with ERROR = 0 if the test passes, ERROR = 1 if the test fails
+;
+; Two (additional) memory locations are used: ERROR and VECTOR. VECTOR must
+; be at the end of a page ($xxFF), and along with $xx00 and the byte after
+; it, must be in RAM that isn't part of this program
+;
+TEST: LDA #1
+     STA ERROR       ; Store 1 in ERROR until test passes
+     LDA #<GOOD
+     STA VECTOR      ; Low byte of the target
+     LDA #>GOOD
+     STA VECTOR-$FF  ; High byte of the target, where the 6502 takes it from
+     LDA #>BAD
+     STA VECTOR+1    ; High byte of the target, had the pointer carried
+     LDX #0
+LOOP: JMP (VECTOR)
+BACK: INX
+     BNE LOOP        ; Jump through the vector 256 times, so that a
+                     ; recompiler translates the jump as well
+     LDA #0
+     STA ERROR       ; All tests pass, so store 0 in ERROR
+DONE: RTS
+;
+; Where the jump goes if it wraps around
+;
+GOOD: JMP BACK
+     .res $100-3     ; Put BAD exactly a page after GOOD
+;
+; Where the jump goes if the pointer carries into the next page
+;
+BAD:  RTS           ; ERROR is still 1
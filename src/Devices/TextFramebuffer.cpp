@@ -0,0 +1,47 @@
+#include "Devices/TextFramebuffer.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+Devices::TextFramebuffer::TextFramebuffer(uint8_t *memory, uint16_t base) :
+	m_Memory(memory),
+	m_Base(base),
+	m_DirtyRows(0)
+{
+	if ((unsigned int)base + FRAMEBUFFER_SIZE > 0x10000)
+		throw std::out_of_range("framebuffer does not fit in the address space");
+
+	Invalidate();
+}
+
+void Devices::TextFramebuffer::DumpText(std::ostream &out) const
+{
+	char line[FRAMEBUFFER_WIDTH + 1];
+	line[FRAMEBUFFER_WIDTH] = '\n';
+
+	for (unsigned int row = 0; row < FRAMEBUFFER_HEIGHT; row++) {
+		const uint8_t *cells = GetRow(row);
+		for (unsigned int col = 0; col < FRAMEBUFFER_WIDTH; col++) {
+			uint8_t c = cells[col];
+			if (c == 0x00)
+				line[col] = ' ';
+			else if ((c < 0x20) || (c > 0x7e))
+				line[col] = '.';
+			else
+				line[col] = (char)c;
+		}
+		out.write(line, sizeof(line));
+	}
+}
+
+void Devices::TextFramebuffer::DumpText(const std::string &filename) const
+{
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.good())
+		throw std::runtime_error("could not open " + filename);
+
+	DumpText(file);
+
+	if (!file.good())
+		throw std::runtime_error("could not write " + filename);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// Standard libs
+#include <stdint.h>
+#include <string.h>
+
+#include <ostream>
+#include <string>
+
+#define FRAMEBUFFER_BASE 0xE000 //!< Default guest address of the text framebuffer
+#define FRAMEBUFFER_WIDTH 80 //!< Text framebuffer width, in characters/columns
+#define FRAMEBUFFER_HEIGHT 25 //!< Text framebuffer height, in characters/rows
+#define FRAMEBUFFER_SIZE (FRAMEBUFFER_WIDTH*FRAMEBUFFER_HEIGHT) //!< Size of the text framebuffer, in bytes
+
+namespace Devices {
+	/** \class TextFramebuffer
+	* The System65 80x25 text mode display.
+	*
+	* The framebuffer is a block of FRAMEBUFFER_SIZE bytes in the guest address
+	* space, starting at the mapped base address, holding one character per cell
+	* in row-major order. The guest displays text simply by storing characters
+	* there; there is no polling or host callback involved.
+	*
+	* The character data itself lives in the VM's memory (the framebuffer is
+	* handed a pointer to it), so guest reads need no special handling. Guest
+	* writes are routed here through System65::Memory_Write(), which marks the
+	* written row in a dirty-row bitmap. The renderer calls TakeDirtyRows() once
+	* per frame and only redraws the rows that were touched.
+	*
+	* In headless mode the current contents can be dumped as plain text with
+	* DumpText(), which makes screen output easy to compare in tests.
+	*/
+	class TextFramebuffer
+	{
+	public:
+		/** Maps the framebuffer.
+		*
+		* \param[in] memory Pointer to the start of the VM's 64KB memory
+		* \param[in] base Guest address the framebuffer starts at; the
+		* framebuffer must fit below 0x10000.
+		*/
+		TextFramebuffer(uint8_t *memory, uint16_t base = FRAMEBUFFER_BASE);
+
+		/** Returns the guest address the framebuffer starts at. */
+		uint16_t GetBase(void) const { return m_Base; }
+
+		/** Returns whether a guest address falls inside the framebuffer. */
+		bool Contains(uint16_t addr) const { return ((unsigned int)(uint16_t)(addr - m_Base) < FRAMEBUFFER_SIZE); }
+
+		/** Notes that the guest wrote to <tt>addr</tt>.
+		*
+		* \param[in] addr Guest address that was written; must be inside the
+		* framebuffer.
+		*/
+		void MarkWritten(uint16_t addr) { m_DirtyRows |= (uint32_t)1 << ((uint16_t)(addr - m_Base) / FRAMEBUFFER_WIDTH); }
+
+		/** Returns the bitmap of rows written since the last TakeDirtyRows(),
+		* without clearing it.
+		*/
+		uint32_t GetDirtyRows(void) const { return m_DirtyRows; }
+
+		/** Returns the bitmap of rows written since the last call and clears it.
+		*
+		* Bit <tt>n</tt> is set if row <tt>n</tt> has been written to.
+		*/
+		uint32_t TakeDirtyRows(void)
+		{
+			uint32_t rows = m_DirtyRows;
+			m_DirtyRows = 0;
+			return rows;
+		}
+
+		/** Marks every row dirty, e.g. after the framebuffer has been moved or
+		* memory has been loaded behind its back.
+		*/
+		void Invalidate(void) { m_DirtyRows = ((uint32_t)1 << FRAMEBUFFER_HEIGHT) - 1; }
+
+		/** Returns a pointer to the FRAMEBUFFER_WIDTH characters of a row. */
+		const uint8_t *GetRow(unsigned int row) const { return m_Memory + m_Base + row*FRAMEBUFFER_WIDTH; }
+
+		/** Writes the framebuffer contents as FRAMEBUFFER_HEIGHT lines of text.
+		*
+		* Unprintable characters are written as <tt>.</tt>, except for 0x00
+		* which is written as a space.
+		*
+		* \param[in] out Stream to write to
+		*/
+		void DumpText(std::ostream &out) const;
+
+		/** Writes the framebuffer contents to a text file.
+		*
+		* \param[in] filename Path of the file to (over)write
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void DumpText(const std::string &filename) const;
+
+	protected:
+	private:
+		uint8_t *m_Memory; //!< Pointer to the VM's memory
+		uint16_t m_Base; //!< Guest address the framebuffer starts at
+		uint32_t m_DirtyRows; //!< Bitmap of rows written since the last TakeDirtyRows()
+	};
+}
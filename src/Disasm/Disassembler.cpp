@@ -0,0 +1,173 @@
+#include "Disasm/Disassembler.hpp"
+
+#include <string.h>
+
+#include "System65/System65.hpp"
+
+namespace {
+	const char hexdigits[] = "0123456789ABCDEF";
+
+	char *PutHex(char *out, unsigned int val, unsigned int digits)
+	{
+		while (digits--)
+			*out++ = hexdigits[(val >> (digits*4)) & 0x0F];
+		return out;
+	}
+
+	char *PutString(char *out, const char *str)
+	{
+		while (*str)
+			*out++ = *str++;
+		return out;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Free functions
+//------------------------------------------------------------------------------
+
+unsigned int Disasm::FormatInstruction(uint16_t addr, const uint8_t *bytes, unsigned int avail, char *out)
+{
+	const OpcodeInfo &op = Opcodes[bytes[0]];
+	unsigned int length = op.length;
+	bool valid = (op.mnemonic != NULL) && (length <= avail);
+	if (!valid)
+		length = 1;
+
+	memset(out, ' ', DISASM_LINE_LENGTH);
+	out[DISASM_LINE_LENGTH] = '\0';
+
+	PutHex(out, addr, 4);
+	for (unsigned int i = 0; i < length; i++)
+		PutHex(out + 6 + i*3, bytes[i], 2);
+
+	char *p = out + 16;
+	if (!valid) {
+		p = PutString(p, ".byte $");
+		PutHex(p, bytes[0], 2);
+		return length;
+	}
+
+	p = PutString(p, op.mnemonic);
+	*p++ = ' ';
+	unsigned int zp = bytes[1];
+	unsigned int abs = (length == 3) ? (bytes[1] | (bytes[2] << 8)) : 0;
+	switch (op.mode) {
+	case ADDR_IMP:
+		break;
+	case ADDR_ACC:
+		*p++ = 'a';
+		break;
+	case ADDR_IMM:
+		p = PutString(p, "#$");
+		p = PutHex(p, zp, 2);
+		break;
+	case ADDR_ZPG:
+	case ADDR_ZPX:
+	case ADDR_ZPY:
+		*p++ = '$';
+		p = PutHex(p, zp, 2);
+		if (op.mode == ADDR_ZPX)
+			p = PutString(p, ",x");
+		else if (op.mode == ADDR_ZPY)
+			p = PutString(p, ",y");
+		break;
+	case ADDR_ABS:
+	case ADDR_ABX:
+	case ADDR_ABY:
+		*p++ = '$';
+		p = PutHex(p, abs, 4);
+		if (op.mode == ADDR_ABX)
+			p = PutString(p, ",x");
+		else if (op.mode == ADDR_ABY)
+			p = PutString(p, ",y");
+		break;
+	case ADDR_IND:
+		p = PutString(p, "($");
+		p = PutHex(p, abs, 4);
+		*p++ = ')';
+		break;
+	case ADDR_IZX:
+		p = PutString(p, "($");
+		p = PutHex(p, zp, 2);
+		p = PutString(p, ",x)");
+		break;
+	case ADDR_IZY:
+		p = PutString(p, "($");
+		p = PutHex(p, zp, 2);
+		p = PutString(p, "),y");
+		break;
+	case ADDR_REL:
+		*p++ = '$';
+		p = PutHex(p, (uint16_t)(addr + 2 + (int8_t)zp), 4);
+		break;
+	}
+
+	return length;
+}
+
+void Disasm::DisassembleImage(const uint8_t *image, size_t size, uint16_t base, std::string &out)
+{
+	char line[DISASM_LINE_LENGTH + 1];
+	out.reserve(out.size() + size*(DISASM_LINE_LENGTH + 1));
+
+	size_t offs = 0;
+	while (offs < size) {
+		size_t avail = size - offs;
+		offs += FormatInstruction((uint16_t)(base + offs), image + offs, (avail > 3) ? 3 : (unsigned int)avail, line);
+
+		// Drop the padding
+		size_t len = DISASM_LINE_LENGTH;
+		while ((len > 0) && (line[len - 1] == ' '))
+			len--;
+		out.append(line, len);
+		out.push_back('\n');
+	}
+}
+
+//------------------------------------------------------------------------------
+// Public
+//------------------------------------------------------------------------------
+
+Disasm::Disassembler::Disassembler(System65 &sys) :
+	m_System(sys),
+	m_Cache(0x10000)
+{
+	for (Entry &e : m_Cache)
+		e.length = 0;
+}
+
+const char *Disasm::Disassembler::GetLine(uint16_t addr, unsigned int *length)
+{
+	const Entry &e = Lookup(addr);
+	if (length)
+		*length = e.length;
+	return e.text;
+}
+
+unsigned int Disasm::Disassembler::GetLength(uint16_t addr)
+{
+	return Lookup(addr).length;
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+const Disasm::Disassembler::Entry &Disasm::Disassembler::Lookup(uint16_t addr)
+{
+	// An instruction is at most 3 bytes, so it spans at most these two pages
+	uint16_t last = (uint16_t)(addr + 2);
+	uint32_t stamp = m_System.GetPageWriteCount((uint8_t)(addr >> 8)) + m_System.GetPageWriteCount((uint8_t)(last >> 8));
+
+	Entry &e = m_Cache[addr];
+	if ((e.length == 0) || (e.stamp != stamp)) {
+		uint8_t bytes[3];
+		for (unsigned int i = 0; i < 3; i++)
+			bytes[i] = m_System.PeekByte((uint16_t)(addr + i));
+		e.length = (uint8_t)FormatInstruction(addr, bytes, 3, e.text);
+		e.stamp = stamp;
+	}
+
+	return e;
+}
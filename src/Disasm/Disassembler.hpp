@@ -0,0 +1,93 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Project libs
+#include "Disasm/Opcodes.hpp"
+
+class System65;
+
+/** \file Disassembler.hpp
+ * Interface for the \ref Disasm::Disassembler class.
+ */
+
+#define DISASM_LINE_LENGTH 27 //!< Length of a disassembled line, not including the terminator
+
+namespace Disasm {
+	/** Disassembles one instruction.
+	 *
+	 * The line is laid out as <tt>AAAA  B0 B1 B2  mne operand</tt>, padded
+	 * with spaces to DISASM_LINE_LENGTH characters. Opcodes that System65
+	 * doesn't implement, and instructions cut short by <tt>avail</tt>, are
+	 * shown as a single <tt>.byte</tt>.
+	 *
+	 * \param[in] addr Address of the instruction
+	 * \param[in] bytes Bytes of the instruction, starting with the opcode
+	 * \param[in] avail Number of bytes that can be read from <tt>bytes</tt>
+	 * \param[out] out Buffer of at least DISASM_LINE_LENGTH + 1 characters;
+	 * the line is NUL-terminated
+	 *
+	 * \return Number of bytes the line covers
+	 */
+	unsigned int FormatInstruction(uint16_t addr, const uint8_t *bytes, unsigned int avail, char *out);
+
+	/** Disassembles a whole image, one line per instruction.
+	 *
+	 * \param[in] image Bytes to disassemble
+	 * \param[in] size Number of bytes in <tt>image</tt>
+	 * \param[in] base Address that the image is loaded at
+	 * \param[out] out String to append the listing to
+	 */
+	void DisassembleImage(const uint8_t *image, size_t size, uint16_t base, std::string &out);
+
+	/** \class Disassembler
+	 * Disassembles VM memory, caching the result for each address.
+	 *
+	 * Each cached line remembers how many times the pages it was decoded
+	 * from had been written to (see System65::GetPageWriteCount()). A line is
+	 * only decoded again once one of those pages has been written since, so
+	 * for code that isn't self-modifying, every address is decoded once and
+	 * a redraw of the disassembly panel is just a handful of lookups.
+	 *
+	 * \note This reads VM memory, so the caller should hold the same lock as
+	 * for any other access to the VM.
+	 */
+	class Disassembler
+	{
+	public:
+		/** Sets up an empty cache for <tt>sys</tt>. */
+		Disassembler(System65 &sys);
+
+		/** Returns the disassembly of the instruction at <tt>addr</tt>.
+		 *
+		 * \param[in] addr Address of the instruction
+		 * \param[out] length If not NULL, receives the length of the
+		 * instruction in bytes
+		 *
+		 * \return The line, valid until the next call
+		 */
+		const char *GetLine(uint16_t addr, unsigned int *length = NULL);
+
+		/** Returns the length in bytes of the instruction at <tt>addr</tt>. */
+		unsigned int GetLength(uint16_t addr);
+
+	private:
+		/** A cached line. */
+		struct Entry {
+			uint32_t stamp; //!< Sum of the write counts of the pages it was decoded from
+			uint8_t length; //!< Length of the instruction in bytes, or 0 if not decoded yet
+			char text[DISASM_LINE_LENGTH + 1]; //!< The line itself
+		};
+
+		System65 &m_System; //!< VM to read from
+		std::vector<Entry> m_Cache; //!< One entry per address
+
+		/** Returns the entry for <tt>addr</tt>, decoding it if it's stale. */
+		const Entry &Lookup(uint16_t addr);
+	};
+}
@@ -0,0 +1,264 @@
+#include "Disasm/Opcodes.hpp"
+
+#include <stddef.h>
+
+namespace Disasm {
+	const OpcodeInfo Opcodes[256] = {
+		{ "brk", ADDR_IMP, 1, 7 }, // 0x00
+		{ "ora", ADDR_IZX, 2, 6 }, // 0x01
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x02
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x03
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x04
+		{ "ora", ADDR_ZPG, 2, 3 }, // 0x05
+		{ "asl", ADDR_ZPG, 2, 5 }, // 0x06
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x07
+		{ "php", ADDR_IMP, 1, 3 }, // 0x08
+		{ "ora", ADDR_IMM, 2, 2 }, // 0x09
+		{ "asl", ADDR_ACC, 1, 2 }, // 0x0A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x0B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x0C
+		{ "ora", ADDR_ABS, 3, 4 }, // 0x0D
+		{ "asl", ADDR_ABS, 3, 6 }, // 0x0E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x0F
+		{ "bpl", ADDR_REL, 2, 2 }, // 0x10
+		{ "ora", ADDR_IZY, 2, 5 }, // 0x11
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x12
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x13
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x14
+		{ "ora", ADDR_ZPX, 2, 4 }, // 0x15
+		{ "asl", ADDR_ZPX, 2, 6 }, // 0x16
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x17
+		{ "clc", ADDR_IMP, 1, 2 }, // 0x18
+		{ "ora", ADDR_ABY, 3, 4 }, // 0x19
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x1A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x1B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x1C
+		{ "ora", ADDR_ABX, 3, 4 }, // 0x1D
+		{ "asl", ADDR_ABX, 3, 7 }, // 0x1E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x1F
+		{ "jsr", ADDR_ABS, 3, 6 }, // 0x20
+		{ "and", ADDR_IZX, 2, 6 }, // 0x21
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x22
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x23
+		{ "bit", ADDR_ZPG, 2, 3 }, // 0x24
+		{ "and", ADDR_ZPG, 2, 3 }, // 0x25
+		{ "rol", ADDR_ZPG, 2, 5 }, // 0x26
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x27
+		{ "plp", ADDR_IMP, 1, 4 }, // 0x28
+		{ "and", ADDR_IMM, 2, 2 }, // 0x29
+		{ "rol", ADDR_ACC, 1, 2 }, // 0x2A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x2B
+		{ "bit", ADDR_ABS, 3, 4 }, // 0x2C
+		{ "and", ADDR_ABS, 3, 4 }, // 0x2D
+		{ "rol", ADDR_ABS, 3, 6 }, // 0x2E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x2F
+		{ "bmi", ADDR_REL, 2, 2 }, // 0x30
+		{ "and", ADDR_IZY, 2, 5 }, // 0x31
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x32
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x33
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x34
+		{ "and", ADDR_ZPX, 2, 4 }, // 0x35
+		{ "rol", ADDR_ZPX, 2, 6 }, // 0x36
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x37
+		{ "sec", ADDR_IMP, 1, 2 }, // 0x38
+		{ "and", ADDR_ABY, 3, 4 }, // 0x39
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x3A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x3B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x3C
+		{ "and", ADDR_ABX, 3, 4 }, // 0x3D
+		{ "rol", ADDR_ABX, 3, 7 }, // 0x3E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x3F
+		{ "rti", ADDR_IMP, 1, 6 }, // 0x40
+		{ "eor", ADDR_IZX, 2, 6 }, // 0x41
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x42
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x43
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x44
+		{ "eor", ADDR_ZPG, 2, 3 }, // 0x45
+		{ "lsr", ADDR_ZPG, 2, 5 }, // 0x46
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x47
+		{ "pha", ADDR_IMP, 1, 3 }, // 0x48
+		{ "eor", ADDR_IMM, 2, 2 }, // 0x49
+		{ "lsr", ADDR_ACC, 1, 2 }, // 0x4A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x4B
+		{ "jmp", ADDR_ABS, 3, 3 }, // 0x4C
+		{ "eor", ADDR_ABS, 3, 4 }, // 0x4D
+		{ "lsr", ADDR_ABS, 3, 6 }, // 0x4E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x4F
+		{ "bvc", ADDR_REL, 2, 2 }, // 0x50
+		{ "eor", ADDR_IZY, 2, 5 }, // 0x51
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x52
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x53
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x54
+		{ "eor", ADDR_ZPX, 2, 4 }, // 0x55
+		{ "lsr", ADDR_ZPX, 2, 6 }, // 0x56
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x57
+		{ "cli", ADDR_IMP, 1, 2 }, // 0x58
+		{ "eor", ADDR_ABY, 3, 4 }, // 0x59
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x5A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x5B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x5C
+		{ "eor", ADDR_ABX, 3, 4 }, // 0x5D
+		{ "lsr", ADDR_ABX, 3, 7 }, // 0x5E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x5F
+		{ "rts", ADDR_IMP, 1, 6 }, // 0x60
+		{ "adc", ADDR_IZX, 2, 6 }, // 0x61
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x62
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x63
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x64
+		{ "adc", ADDR_ZPG, 2, 3 }, // 0x65
+		{ "ror", ADDR_ZPG, 2, 5 }, // 0x66
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x67
+		{ "pla", ADDR_IMP, 1, 4 }, // 0x68
+		{ "adc", ADDR_IMM, 2, 2 }, // 0x69
+		{ "ror", ADDR_ACC, 1, 2 }, // 0x6A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x6B
+		{ "jmp", ADDR_IND, 3, 5 }, // 0x6C
+		{ "adc", ADDR_ABS, 3, 4 }, // 0x6D
+		{ "ror", ADDR_ABS, 3, 6 }, // 0x6E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x6F
+		{ "bvs", ADDR_REL, 2, 2 }, // 0x70
+		{ "adc", ADDR_IZY, 2, 5 }, // 0x71
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x72
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x73
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x74
+		{ "adc", ADDR_ZPX, 2, 4 }, // 0x75
+		{ "ror", ADDR_ZPX, 2, 6 }, // 0x76
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x77
+		{ "sei", ADDR_IMP, 1, 2 }, // 0x78
+		{ "adc", ADDR_ABY, 3, 4 }, // 0x79
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x7A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x7B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x7C
+		{ "adc", ADDR_ABX, 3, 4 }, // 0x7D
+		{ "ror", ADDR_ABX, 3, 7 }, // 0x7E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x7F
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x80
+		{ "sta", ADDR_IZX, 2, 6 }, // 0x81
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x82
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x83
+		{ "sty", ADDR_ZPG, 2, 3 }, // 0x84
+		{ "sta", ADDR_ZPG, 2, 3 }, // 0x85
+		{ "stx", ADDR_ZPG, 2, 3 }, // 0x86
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x87
+		{ "dey", ADDR_IMP, 1, 2 }, // 0x88
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x89
+		{ "txa", ADDR_IMP, 1, 2 }, // 0x8A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x8B
+		{ "sty", ADDR_ABS, 3, 4 }, // 0x8C
+		{ "sta", ADDR_ABS, 3, 4 }, // 0x8D
+		{ "stx", ADDR_ABS, 3, 4 }, // 0x8E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x8F
+		{ "bcc", ADDR_REL, 2, 2 }, // 0x90
+		{ "sta", ADDR_IZY, 2, 6 }, // 0x91
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x92
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x93
+		{ "sty", ADDR_ZPX, 2, 4 }, // 0x94
+		{ "sta", ADDR_ZPX, 2, 4 }, // 0x95
+		{ "stx", ADDR_ZPY, 2, 4 }, // 0x96
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x97
+		{ "tya", ADDR_IMP, 1, 2 }, // 0x98
+		{ "sta", ADDR_ABY, 3, 5 }, // 0x99
+		{ "txs", ADDR_IMP, 1, 2 }, // 0x9A
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x9B
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x9C
+		{ "sta", ADDR_ABX, 3, 5 }, // 0x9D
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x9E
+		{ NULL, ADDR_IMP, 1, 2 }, // 0x9F
+		{ "ldy", ADDR_IMM, 2, 2 }, // 0xA0
+		{ "lda", ADDR_IZX, 2, 6 }, // 0xA1
+		{ "ldx", ADDR_IMM, 2, 2 }, // 0xA2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xA3
+		{ "ldy", ADDR_ZPG, 2, 3 }, // 0xA4
+		{ "lda", ADDR_ZPG, 2, 3 }, // 0xA5
+		{ "ldx", ADDR_ZPG, 2, 3 }, // 0xA6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xA7
+		{ "tay", ADDR_IMP, 1, 2 }, // 0xA8
+		{ "lda", ADDR_IMM, 2, 2 }, // 0xA9
+		{ "tax", ADDR_IMP, 1, 2 }, // 0xAA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xAB
+		{ "ldy", ADDR_ABS, 3, 4 }, // 0xAC
+		{ "lda", ADDR_ABS, 3, 4 }, // 0xAD
+		{ "ldx", ADDR_ABS, 3, 4 }, // 0xAE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xAF
+		{ "bcs", ADDR_REL, 2, 2 }, // 0xB0
+		{ "lda", ADDR_IZY, 2, 5 }, // 0xB1
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xB2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xB3
+		{ "ldy", ADDR_ZPX, 2, 4 }, // 0xB4
+		{ "lda", ADDR_ZPX, 2, 4 }, // 0xB5
+		{ "ldx", ADDR_ZPY, 2, 4 }, // 0xB6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xB7
+		{ "clv", ADDR_IMP, 1, 2 }, // 0xB8
+		{ "lda", ADDR_ABY, 3, 4 }, // 0xB9
+		{ "tsx", ADDR_IMP, 1, 2 }, // 0xBA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xBB
+		{ "ldy", ADDR_ABX, 3, 4 }, // 0xBC
+		{ "lda", ADDR_ABX, 3, 4 }, // 0xBD
+		{ "ldx", ADDR_ABY, 3, 4 }, // 0xBE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xBF
+		{ "cpy", ADDR_IMM, 2, 2 }, // 0xC0
+		{ "cmp", ADDR_IZX, 2, 6 }, // 0xC1
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xC2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xC3
+		{ "cpy", ADDR_ZPG, 2, 3 }, // 0xC4
+		{ "cmp", ADDR_ZPG, 2, 3 }, // 0xC5
+		{ "dec", ADDR_ZPG, 2, 5 }, // 0xC6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xC7
+		{ "iny", ADDR_IMP, 1, 2 }, // 0xC8
+		{ "cmp", ADDR_IMM, 2, 2 }, // 0xC9
+		{ "dex", ADDR_IMP, 1, 2 }, // 0xCA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xCB
+		{ "cpy", ADDR_ABS, 3, 4 }, // 0xCC
+		{ "cmp", ADDR_ABS, 3, 4 }, // 0xCD
+		{ "dec", ADDR_ABS, 3, 6 }, // 0xCE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xCF
+		{ "bne", ADDR_REL, 2, 2 }, // 0xD0
+		{ "cmp", ADDR_IZY, 2, 5 }, // 0xD1
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xD2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xD3
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xD4
+		{ "cmp", ADDR_ZPX, 2, 4 }, // 0xD5
+		{ "dec", ADDR_ZPX, 2, 6 }, // 0xD6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xD7
+		{ "cld", ADDR_IMP, 1, 2 }, // 0xD8
+		{ "cmp", ADDR_ABY, 3, 4 }, // 0xD9
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xDA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xDB
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xDC
+		{ "cmp", ADDR_ABX, 3, 4 }, // 0xDD
+		{ "dec", ADDR_ABX, 3, 7 }, // 0xDE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xDF
+		{ "cpx", ADDR_IMM, 2, 2 }, // 0xE0
+		{ "sbc", ADDR_IZX, 2, 6 }, // 0xE1
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xE2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xE3
+		{ "cpx", ADDR_ZPG, 2, 3 }, // 0xE4
+		{ "sbc", ADDR_ZPG, 2, 3 }, // 0xE5
+		{ "inc", ADDR_ZPG, 2, 5 }, // 0xE6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xE7
+		{ "inx", ADDR_IMP, 1, 2 }, // 0xE8
+		{ "sbc", ADDR_IMM, 2, 2 }, // 0xE9
+		{ "nop", ADDR_IMP, 1, 2 }, // 0xEA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xEB
+		{ "cpx", ADDR_ABS, 3, 4 }, // 0xEC
+		{ "sbc", ADDR_ABS, 3, 4 }, // 0xED
+		{ "inc", ADDR_ABS, 3, 6 }, // 0xEE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xEF
+		{ "beq", ADDR_REL, 2, 2 }, // 0xF0
+		{ "sbc", ADDR_IZY, 2, 5 }, // 0xF1
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xF2
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xF3
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xF4
+		{ "sbc", ADDR_ZPX, 2, 4 }, // 0xF5
+		{ "inc", ADDR_ZPX, 2, 6 }, // 0xF6
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xF7
+		{ "sed", ADDR_IMP, 1, 2 }, // 0xF8
+		{ "sbc", ADDR_ABY, 3, 4 }, // 0xF9
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xFA
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xFB
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xFC
+		{ "sbc", ADDR_ABX, 3, 4 }, // 0xFD
+		{ "inc", ADDR_ABX, 3, 7 }, // 0xFE
+		{ NULL, ADDR_IMP, 1, 2 }, // 0xFF
+	};
+}
\ No newline at end of file
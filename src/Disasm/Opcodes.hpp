@@ -0,0 +1,42 @@
+#pragma once
+
+// Standard libs
+#include <stdint.h>
+
+/** \file Opcodes.hpp
+ * Static description of the 6502 instruction set.
+ */
+
+namespace Disasm {
+	/** Addressing modes, as far as decoding is concerned. */
+	enum AddressMode {
+		ADDR_IMP, //!< Implied; no operand
+		ADDR_ACC, //!< Accumulator, e.g. <tt>asl a</tt>
+		ADDR_IMM, //!< Immediate byte
+		ADDR_ZPG, //!< Zero page
+		ADDR_ZPX, //!< Zero page indexed by X
+		ADDR_ZPY, //!< Zero page indexed by Y
+		ADDR_ABS, //!< Absolute
+		ADDR_ABX, //!< Absolute indexed by X
+		ADDR_ABY, //!< Absolute indexed by Y
+		ADDR_IND, //!< Indirect; only used by JMP
+		ADDR_IZX, //!< Indexed indirect, <tt>($nn,x)</tt>
+		ADDR_IZY, //!< Indirect indexed, <tt>($nn),y</tt>
+		ADDR_REL //!< Relative branch target
+	};
+
+	/** Description of a single opcode. */
+	struct OpcodeInfo {
+		const char *mnemonic; //!< Lower-case mnemonic, or NULL if the opcode isn't implemented by System65
+		uint8_t mode; //!< Addressing mode, from AddressMode
+		uint8_t length; //!< Length of the instruction in bytes, including the opcode
+		uint8_t cycles; //!< Base cycle count, without page-crossing or branch penalties
+	};
+
+	/** Description of every opcode, indexed by opcode byte.
+	 *
+	 * Only the documented NMOS 6502 opcodes that System65::Dispatch() handles
+	 * have a mnemonic; the rest are treated as one-byte instructions.
+	 */
+	extern const OpcodeInfo Opcodes[256];
+}
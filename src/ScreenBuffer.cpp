@@ -0,0 +1,29 @@
+#include "ScreenBuffer.hpp"
+
+//------------------------------------------------------------------------------
+// Public
+//------------------------------------------------------------------------------
+
+ScreenBuffer::ScreenBuffer()
+{
+	memset(m_Cells, ' ', sizeof(m_Cells));
+	Invalidate();
+}
+
+void ScreenBuffer::Invalidate(void)
+{
+	for (unsigned int y = 0; y < EMUSCREEN_HEIGHT; y++) {
+		for (unsigned int w = 0; w < DIRTY_WORDS; w++) {
+			unsigned int first = w << 6;
+			unsigned int count = EMUSCREEN_WIDTH - first;
+			m_Dirty[y][w] = (count >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1);
+		}
+	}
+	m_DirtyRows = ((uint32_t)1 << EMUSCREEN_HEIGHT) - 1;
+}
+
+void ScreenBuffer::ClearDirty(void)
+{
+	memset(m_Dirty, 0, sizeof(m_Dirty));
+	m_DirtyRows = 0;
+}
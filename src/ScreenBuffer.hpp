@@ -0,0 +1,136 @@
+#ifndef SCREENBUFFER_HPP
+#define SCREENBUFFER_HPP
+
+// Standard libs
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif // _MSC_VER
+
+/** \file ScreenBuffer.hpp
+ * Interface for the \ref ScreenBuffer class.
+ */
+
+#define TEXCHAR_WIDTH 8 //!< Width of a single glyph on the texture sheet
+#define TEXCHAR_HEIGHT 12 //!< Height of a single glyph on the texture sheet
+#define TEXCHAR_CELLS 16 //!< Number of cells in either direction on the texture sheet
+#define SCREEN_WIDTH 80 //!< Monitor width, in characters/columns
+#define SCREEN_HEIGHT 25 //!< Monitor height, in characters/rows
+#define EMUSCREEN_WIDTH 112 //!< Width of the entire emulator screen, in characters/columns
+#define EMUSCREEN_HEIGHT 29 //!< Height of the entire emulator screen, in characters/rows
+
+/**
+ * The character grid for the emulator screen.
+ *
+ * This class holds the character that is currently shown in each cell of the
+ * emulator screen, along with a dirty map that records which cells have
+ * changed since the last time the screen was presented. Writing the same
+ * character that a cell already holds does not mark it dirty, so callers can
+ * redraw freely and the frontend only has to re-encode the cells that really
+ * changed.
+ *
+ * The dirty map is kept as one bit per cell, plus one bit per row so that clean
+ * rows can be skipped without looking at their cells.
+ *
+ * \note This class is not thread-safe; it is meant to be owned by the render
+ * thread.
+ */
+
+class ScreenBuffer
+{
+	public:
+		/** Creates a blank screen; every cell is set to ' ' and marked dirty. */
+		ScreenBuffer();
+
+		/** Sets the character in a cell.
+		 *
+		 * The cell is only marked dirty if <tt>c</tt> differs from the
+		 * character it already holds. Out-of-range coordinates are ignored.
+		 *
+		 * \param[in] c Character to put in the cell
+		 * \param[in] x Column of the cell
+		 * \param[in] y Row of the cell
+		 */
+		void SetChar(char c, unsigned int x, unsigned int y)
+		{
+			if ((x >= EMUSCREEN_WIDTH) || (y >= EMUSCREEN_HEIGHT))
+				return;
+			if (m_Cells[y][x] == (uint8_t)c)
+				return;
+			m_Cells[y][x] = (uint8_t)c;
+			m_Dirty[y][x >> 6] |= (uint64_t)1 << (x & 63);
+			m_DirtyRows |= (uint32_t)1 << y;
+		}
+
+		/** Returns the character in a cell. */
+		uint8_t GetChar(unsigned int x, unsigned int y) const { return m_Cells[y][x]; }
+
+		/** Returns a pointer to the characters of a row. */
+		const uint8_t *GetRow(unsigned int y) const { return m_Cells[y]; }
+
+		/** Returns whether any cell has changed since the last ClearDirty(). */
+		bool IsDirty(void) const { return (m_DirtyRows != 0); }
+
+		/** Returns whether any cell in row <tt>y</tt> has changed. */
+		bool IsRowDirty(unsigned int y) const { return ((m_DirtyRows >> y) & 1) != 0; }
+
+		/** Returns whether the cell at <tt>x</tt>,<tt>y</tt> has changed. */
+		bool IsCellDirty(unsigned int x, unsigned int y) const { return ((m_Dirty[y][x >> 6] >> (x & 63)) & 1) != 0; }
+
+		/** Marks every cell dirty, forcing a full redraw on the next frame. */
+		void Invalidate(void);
+
+		/** Marks every cell clean; call after the changes have been presented. */
+		void ClearDirty(void);
+
+		/** Calls <tt>func(x, y, c)</tt> for each dirty cell, row by row.
+		 *
+		 * The dirty map is not modified; call ClearDirty() afterwards.
+		 *
+		 * \param[in] func Callable taking the column, row and character
+		 */
+		template <typename Func>
+		void ForEachDirty(Func func) const
+		{
+			uint32_t rows = m_DirtyRows;
+			while (rows) {
+				unsigned int y = CountTrailingZeros(rows);
+				rows &= rows - 1;
+				for (unsigned int w = 0; w < DIRTY_WORDS; w++) {
+					uint64_t bits = m_Dirty[y][w];
+					while (bits) {
+						unsigned int x = (w << 6) + CountTrailingZeros(bits);
+						bits &= bits - 1;
+						func(x, y, m_Cells[y][x]);
+					}
+				}
+			}
+		}
+
+	protected:
+	private:
+		static const unsigned int DIRTY_WORDS = (EMUSCREEN_WIDTH + 63) / 64; //!< Number of 64-bit words in a row of the dirty map
+
+		uint8_t m_Cells[EMUSCREEN_HEIGHT][EMUSCREEN_WIDTH]; //!< Character in each cell, indexed [row][column]
+		uint64_t m_Dirty[EMUSCREEN_HEIGHT][DIRTY_WORDS]; //!< Dirty bit for each cell, indexed [row][column/64]
+		uint32_t m_DirtyRows; //!< Dirty bit for each row
+
+		/** Returns the index of the lowest set bit; <tt>v</tt> must be non-zero. */
+		static unsigned int CountTrailingZeros(uint64_t v)
+		{
+#ifdef _MSC_VER
+			// _BitScanForward64() isn't available on 32-bit targets
+			unsigned long n;
+			if (_BitScanForward(&n, (unsigned long)v))
+				return (unsigned int)n;
+			_BitScanForward(&n, (unsigned long)(v >> 32));
+			return (unsigned int)n + 32;
+#else
+			return (unsigned int)__builtin_ctzll(v);
+#endif // _MSC_VER
+		}
+};
+
+#endif // SCREENBUFFER_HPP
@@ -0,0 +1,285 @@
+#include "SoftwareRenderer.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define SOFTRENDER_SSE2
+	#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Local helpers
+//------------------------------------------------------------------------------
+
+namespace {
+	/** Builds a pixel from its components. */
+	uint32_t MakePixel(uint8_t r, uint8_t g, uint8_t b)
+	{
+		uint8_t bytes[4] = { r, g, b, 0 };
+		uint32_t px;
+		memcpy(&px, bytes, sizeof(px));
+		return px;
+	}
+
+	uint32_t ReadLE32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+	uint16_t ReadLE16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+	void WriteBE32(std::ostream &out, uint32_t val)
+	{
+		char bytes[4] = { (char)(val >> 24), (char)(val >> 16), (char)(val >> 8), (char)val };
+		out.write(bytes, 4);
+	}
+
+	/** CRC-32 as used by PNG chunks. */
+	uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t len)
+	{
+		static uint32_t table[256];
+		static bool init = false;
+		if (!init) {
+			for (uint32_t n = 0; n < 256; n++) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+				table[n] = c;
+			}
+			init = true;
+		}
+
+		crc = ~crc;
+		while (len--)
+			crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	/** Writes a PNG chunk, including its length and CRC. */
+	void WritePNGChunk(std::ostream &out, const char *type, const std::vector<uint8_t> &data)
+	{
+		WriteBE32(out, (uint32_t)data.size());
+		out.write(type, 4);
+		if (!data.empty())
+			out.write(reinterpret_cast<const char*>(data.data()), data.size());
+		uint32_t crc = Crc32(0, reinterpret_cast<const uint8_t*>(type), 4);
+		crc = Crc32(crc, data.data(), data.size());
+		WriteBE32(out, crc);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Public
+//------------------------------------------------------------------------------
+
+SoftwareRenderer::SoftwareRenderer(const std::string &fontfile) :
+	m_Glyphs(256*GLYPH_PIXELS),
+	m_Pixels(FB_WIDTH*FB_HEIGHT, MakePixel(0, 0, 0))
+{
+	LoadFont(fontfile);
+}
+
+void SoftwareRenderer::Update(ScreenBuffer &screen)
+{
+	if (!screen.IsDirty())
+		return;
+
+	screen.ForEachDirty([this](unsigned int x, unsigned int y, uint8_t c) {
+		DrawGlyph(x, y, c);
+	});
+	screen.ClearDirty();
+}
+
+void SoftwareRenderer::Redraw(const ScreenBuffer &screen)
+{
+	for (unsigned int y = 0; y < EMUSCREEN_HEIGHT; y++) {
+		const uint8_t *row = screen.GetRow(y);
+		for (unsigned int x = 0; x < EMUSCREEN_WIDTH; x++)
+			DrawGlyph(x, y, row[x]);
+	}
+}
+
+void SoftwareRenderer::WriteImage(const std::string &filename, ImageFormat format) const
+{
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.good())
+		throw std::runtime_error("could not open " + filename);
+
+	if (format == IMAGE_PPM)
+		WritePPM(file);
+	else
+		WritePNG(file);
+
+	if (!file.good())
+		throw std::runtime_error("could not write " + filename);
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void SoftwareRenderer::DrawGlyph(unsigned int x, unsigned int y, uint8_t c)
+{
+	const uint32_t *src = &m_Glyphs[c*GLYPH_PIXELS];
+	uint32_t *dst = &m_Pixels[(y*TEXCHAR_HEIGHT)*FB_WIDTH + x*TEXCHAR_WIDTH];
+
+	// A glyph row is 8 pixels, or 32 bytes: two SSE2 registers.
+	for (unsigned int row = 0; row < TEXCHAR_HEIGHT; row++) {
+#ifdef SOFTRENDER_SSE2
+		__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), hi);
+#else
+		memcpy(dst, src, TEXCHAR_WIDTH*sizeof(uint32_t));
+#endif // SOFTRENDER_SSE2
+		src += TEXCHAR_WIDTH;
+		dst += FB_WIDTH;
+	}
+}
+
+void SoftwareRenderer::LoadFont(const std::string &fontfile)
+{
+	std::ifstream file(fontfile, std::ios::binary);
+	if (!file.good())
+		throw std::runtime_error("could not open " + fontfile);
+
+	std::vector<uint8_t> bmp((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if ((bmp.size() < 54) || (bmp[0] != 'B') || (bmp[1] != 'M'))
+		throw std::runtime_error(fontfile + " is not a BMP file");
+
+	uint32_t dataoffs = ReadLE32(&bmp[10]);
+	uint32_t hdrsize = ReadLE32(&bmp[14]);
+	int32_t width = (int32_t)ReadLE32(&bmp[18]);
+	int32_t height = (int32_t)ReadLE32(&bmp[22]);
+	uint16_t bpp = ReadLE16(&bmp[28]);
+	uint32_t compression = ReadLE32(&bmp[30]);
+	uint32_t colorsused = ReadLE32(&bmp[46]);
+
+	bool topdown = (height < 0);
+	if (topdown)
+		height = -height;
+
+	// BI_BITFIELDS is only accepted for 32-bit images with the usual masks
+	if ((compression != 0) && !((compression == 3) && (bpp == 32)))
+		throw std::runtime_error(fontfile + " is compressed");
+	if ((bpp != 1) && (bpp != 4) && (bpp != 8) && (bpp != 24) && (bpp != 32))
+		throw std::runtime_error(fontfile + " has an unsupported bit depth");
+	if ((width < TEXCHAR_WIDTH*TEXCHAR_CELLS) || (height < TEXCHAR_HEIGHT*TEXCHAR_CELLS))
+		throw std::runtime_error(fontfile + " is too small for a font atlas");
+
+	// Palette, for the indexed formats
+	std::vector<uint32_t> palette;
+	if (bpp <= 8) {
+		uint32_t count = colorsused ? colorsused : (1u << bpp);
+		size_t paloffs = 14 + hdrsize;
+		if (paloffs + count*4 > bmp.size())
+			throw std::runtime_error(fontfile + " has a truncated palette");
+		for (uint32_t i = 0; i < count; i++) {
+			const uint8_t *e = &bmp[paloffs + i*4];
+			palette.push_back(MakePixel(e[2], e[1], e[0]));
+		}
+		palette.resize(256, MakePixel(0, 0, 0));
+	}
+
+	size_t stride = ((width*bpp + 31) / 32) * 4;
+	if (dataoffs + stride*height > bmp.size())
+		throw std::runtime_error(fontfile + " has truncated pixel data");
+
+	// Cut the atlas up into contiguous glyphs
+	for (unsigned int py = 0; py < TEXCHAR_HEIGHT*TEXCHAR_CELLS; py++) {
+		const uint8_t *row = &bmp[dataoffs + stride*(topdown ? py : (height - 1 - py))];
+		for (unsigned int px = 0; px < TEXCHAR_WIDTH*TEXCHAR_CELLS; px++) {
+			uint32_t pixel;
+			switch (bpp) {
+			case 1:
+				pixel = palette[(row[px >> 3] >> (7 - (px & 7))) & 1]; break;
+			case 4:
+				pixel = palette[(row[px >> 1] >> ((px & 1) ? 0 : 4)) & 0x0F]; break;
+			case 8:
+				pixel = palette[row[px]]; break;
+			case 24:
+				pixel = MakePixel(row[px*3 + 2], row[px*3 + 1], row[px*3]); break;
+			default: // 32
+				pixel = MakePixel(row[px*4 + 2], row[px*4 + 1], row[px*4]); break;
+			}
+
+			unsigned int glyph = (py / TEXCHAR_HEIGHT)*TEXCHAR_CELLS + (px / TEXCHAR_WIDTH);
+			m_Glyphs[glyph*GLYPH_PIXELS + (py % TEXCHAR_HEIGHT)*TEXCHAR_WIDTH + (px % TEXCHAR_WIDTH)] = pixel;
+		}
+	}
+}
+
+void SoftwareRenderer::WritePPM(std::ostream &out) const
+{
+	std::string header = "P6\n" + std::to_string(FB_WIDTH) + " " + std::to_string(FB_HEIGHT) + "\n255\n";
+	out.write(header.data(), header.size());
+
+	std::vector<uint8_t> rgb(FB_WIDTH*FB_HEIGHT*3);
+	uint8_t *dst = rgb.data();
+	for (uint32_t px : m_Pixels) {
+		memcpy(dst, &px, 3);
+		dst += 3;
+	}
+	out.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+}
+
+void SoftwareRenderer::WritePNG(std::ostream &out) const
+{
+	static const char signature[8] = { (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.write(signature, sizeof(signature));
+
+	// IHDR: 8-bit RGB, no interlacing
+	std::vector<uint8_t> ihdr = {
+		(uint8_t)(FB_WIDTH >> 24), (uint8_t)(FB_WIDTH >> 16), (uint8_t)(FB_WIDTH >> 8), (uint8_t)FB_WIDTH,
+		(uint8_t)(FB_HEIGHT >> 24), (uint8_t)(FB_HEIGHT >> 16), (uint8_t)(FB_HEIGHT >> 8), (uint8_t)FB_HEIGHT,
+		8, 2, 0, 0, 0
+	};
+	WritePNGChunk(out, "IHDR", ihdr);
+
+	// Raw scanlines, each prefixed with filter type 0
+	std::vector<uint8_t> raw;
+	raw.reserve(FB_HEIGHT*(1 + FB_WIDTH*3));
+	for (unsigned int y = 0; y < FB_HEIGHT; y++) {
+		raw.push_back(0);
+		const uint32_t *row = &m_Pixels[y*FB_WIDTH];
+		for (unsigned int x = 0; x < FB_WIDTH; x++) {
+			uint8_t bytes[4];
+			memcpy(bytes, &row[x], 4);
+			raw.insert(raw.end(), bytes, bytes + 3);
+		}
+	}
+
+	// zlib stream made of stored (uncompressed) deflate blocks; dumps are
+	// meant to be written fast, not small.
+	std::vector<uint8_t> idat = { 0x78, 0x01 };
+	idat.reserve(raw.size() + (raw.size() / 65535 + 1)*5 + 6);
+	size_t pos = 0;
+	do {
+		size_t len = std::min<size_t>(raw.size() - pos, 65535);
+		bool last = (pos + len == raw.size());
+		idat.push_back(last ? 1 : 0);
+		idat.push_back((uint8_t)len);
+		idat.push_back((uint8_t)(len >> 8));
+		idat.push_back((uint8_t)~len);
+		idat.push_back((uint8_t)(~len >> 8));
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+	} while (pos < raw.size());
+
+	uint32_t s1 = 1, s2 = 0;
+	for (uint8_t b : raw) {
+		s1 = (s1 + b) % 65521;
+		s2 = (s2 + s1) % 65521;
+	}
+	uint32_t adler = (s2 << 16) | s1;
+	idat.push_back((uint8_t)(adler >> 24));
+	idat.push_back((uint8_t)(adler >> 16));
+	idat.push_back((uint8_t)(adler >> 8));
+	idat.push_back((uint8_t)adler);
+	WritePNGChunk(out, "IDAT", idat);
+
+	WritePNGChunk(out, "IEND", std::vector<uint8_t>());
+}
@@ -0,0 +1,105 @@
+#ifndef SOFTWARERENDERER_HPP
+#define SOFTWARERENDERER_HPP
+
+// Standard libs
+#include <stdint.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Project libs
+#include "ScreenBuffer.hpp"
+
+/** \file SoftwareRenderer.hpp
+ * Interface for the \ref SoftwareRenderer class.
+ */
+
+/**
+ * Renders the emulator screen into memory without a GPU or a window.
+ *
+ * This class draws a \ref ScreenBuffer into a CPU-side 32-bit framebuffer
+ * using the same font atlas as the SFML frontend, and can write the result out
+ * as a PPM or PNG image. It has no dependency on SFML, so it works on machines
+ * without a display.
+ *
+ * When the font is loaded, each glyph of the atlas is copied into its own
+ * contiguous 8x12 block, so that drawing a character is just twelve 32-byte
+ * row copies (done with SSE2 when the compiler targets it). Only the cells
+ * that are dirty in the ScreenBuffer are redrawn by Update().
+ *
+ * \note The font atlas must be an uncompressed 1, 4, 8, 24 or 32-bit BMP of
+ * TEXCHAR_CELLS x TEXCHAR_CELLS glyphs.
+ */
+
+class SoftwareRenderer
+{
+	public:
+		/** Image formats that can be written. */
+		enum ImageFormat {
+			IMAGE_PPM, //!< Binary (P6) portable pixmap
+			IMAGE_PNG //!< PNG, stored uncompressed
+		};
+
+		/** Loads the font atlas and sets up a black framebuffer.
+		 *
+		 * \param[in] fontfile Path to the font atlas BMP
+		 *
+		 * \throws std::runtime_error if the font can't be loaded
+		 */
+		SoftwareRenderer(const std::string &fontfile = "font_82.bmp");
+
+		/** Draws the cells of <tt>screen</tt> that are dirty and marks them
+		 * clean.
+		 *
+		 * \param[in,out] screen Screen to draw from
+		 */
+		void Update(ScreenBuffer &screen);
+
+		/** Draws every cell of <tt>screen</tt>, regardless of its dirty map.
+		 *
+		 * \param[in] screen Screen to draw from
+		 */
+		void Redraw(const ScreenBuffer &screen);
+
+		/** Writes the framebuffer to an image file.
+		 *
+		 * \param[in] filename Path of the file to (over)write
+		 * \param[in] format Format of the image
+		 *
+		 * \throws std::runtime_error if the file can't be written
+		 */
+		void WriteImage(const std::string &filename, ImageFormat format) const;
+
+		/** Returns the framebuffer width, in pixels. */
+		unsigned int GetWidth(void) const { return FB_WIDTH; }
+
+		/** Returns the framebuffer height, in pixels. */
+		unsigned int GetHeight(void) const { return FB_HEIGHT; }
+
+		/** Returns the framebuffer; each pixel is 4 bytes in R, G, B, X order. */
+		const uint32_t *GetPixels(void) const { return m_Pixels.data(); }
+
+	protected:
+	private:
+		static const unsigned int FB_WIDTH = EMUSCREEN_WIDTH*TEXCHAR_WIDTH; //!< Framebuffer width, in pixels
+		static const unsigned int FB_HEIGHT = EMUSCREEN_HEIGHT*TEXCHAR_HEIGHT; //!< Framebuffer height, in pixels
+		static const unsigned int GLYPH_PIXELS = TEXCHAR_WIDTH*TEXCHAR_HEIGHT; //!< Number of pixels in one glyph
+
+		std::vector<uint32_t> m_Glyphs; //!< Each glyph as a contiguous TEXCHAR_WIDTH x TEXCHAR_HEIGHT block
+		std::vector<uint32_t> m_Pixels; //!< The framebuffer, FB_WIDTH x FB_HEIGHT
+
+		/** Draws glyph <tt>c</tt> into the cell at <tt>x</tt>,<tt>y</tt>. */
+		void DrawGlyph(unsigned int x, unsigned int y, uint8_t c);
+
+		/** Loads a BMP font atlas into m_Glyphs. */
+		void LoadFont(const std::string &fontfile);
+
+		/** Writes the framebuffer as a binary PPM. */
+		void WritePPM(std::ostream &out) const;
+
+		/** Writes the framebuffer as a PNG. */
+		void WritePNG(std::ostream &out) const;
+};
+
+#endif // SOFTWARERENDERER_HPP
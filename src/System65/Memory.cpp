@@ -2,16 +2,37 @@
 
 // Memory management
 
+// The text framebuffer is backed by m_Memory like everything else, so reads
+// only need it to pass the bounds check. Writes also mark the row it's on dirty
+// so the renderer knows what to redraw. Every write bumps the write count of
+// its page, which the disassembler uses to tell when code may have changed.
+// While a trace is recording, writes are also logged for the trace frame.
+
 uint8_t SYSTEM65CORE System65::Memory_Read(uint16_t addr) {
-	if (Memory_BoundsCheck(addr))
+	if (Memory_BoundsCheck(addr) || m_Framebuffer->Contains(addr))
 		return (*m_Memory)[addr];
 	else
 		return 0;
 }
 
 void SYSTEM65CORE System65::Memory_Write(uint16_t addr, uint8_t val) {
-	if (Memory_BoundsCheck(addr))
-		(*m_Memory)[addr] = val;
+	if (m_Framebuffer->Contains(addr))
+		m_Framebuffer->MarkWritten(addr);
+	else if (!Memory_BoundsCheck(addr))
+		return;
+
+	(*m_Memory)[addr] = val;
+	m_PageWrites[addr >> 8]++;
+
+	if (m_WriteLogEnabled) {
+		if (m_TraceFrame.writecount < TRACE_MAX_FRAME_WRITES) {
+			Trace::MemoryWrite &w = m_TraceFrame.writes[m_TraceFrame.writecount++];
+			w.addr = addr;
+			w.val = val;
+		} else {
+			m_TraceFrame.overflow = true;
+		}
+	}
 }
 
 void SYSTEM65CORE System65::Memory_Write(uint16_t addr, uint16_t val) {
@@ -6,6 +6,10 @@
 
 System65::System65(unsigned int memsize) :
 	m_CycleCount(0),
+	m_InstructionCount(0),
+	m_TraceFrameCount(0),
+	m_TraceFullFrame(false),
+	m_WriteLogEnabled(false),
 	m_StackBase(STACK_BASE),
 	m_GenerateInterrupt(false),
 	m_NMInterrupt(false),
@@ -28,9 +32,10 @@ System65::System65(unsigned int memsize) :
 
 	m_Memory = std::make_unique<std::vector<uint8_t>>(MAX_MEM_SIZE);
 
-	//m_Trace = std::make_unique<Trace::BinaryRecord>();
+	m_Framebuffer = std::make_unique<Devices::TextFramebuffer>(m_Memory->data());
+	memset(m_PageWrites, 0, sizeof(m_PageWrites));
 
-	m_TraceMemory = std::make_shared<std::vector<uint8_t>>(MAX_MEM_SIZE);
+	memset(&m_TraceFrame, 0, sizeof(m_TraceFrame));
 }
 
 System65::~System65()
@@ -104,6 +109,10 @@ void System65::Tick(unsigned int cycleLimit)
 
 void System65::Interrupt(bool nmi)
 {
+	// A trace can't work out when the interrupt came from the CPU state, so
+	// it's noted on the frame that takes it
+	if (m_WriteLogEnabled)
+		m_TraceFrame.interrupt = nmi ? TRACE_INTERRUPT_NMI : TRACE_INTERRUPT_IRQ;
 	Helper_SetInterrupt(nmi, false);
 }
 
@@ -112,6 +121,11 @@ void System65::SetStackBasePage(uint8_t base)
 	m_StackBase = (uint16_t)base << 8;
 }
 
+void System65::MapFramebuffer(uint16_t base)
+{
+	m_Framebuffer = std::make_unique<Devices::TextFramebuffer>(m_Memory->data(), base);
+}
+
 void System65::SetInterruptVector(uint16_t ivec)
 {
 	Memory_Write(0xFFFE,ivec);
@@ -511,11 +525,8 @@ void SYSTEM65CORE System65::Dispatch(void)
 
 		m_InstructionCount++;
 
-		// Copy memory for the snapshot
-		//for (unsigned i = 0; i < MAX_MEM_SIZE; i++)
-		//	(*m_TraceMemory)[i] = Memory_Read(i);
-
-		//m_Trace->Snap(m_InstructionCount, a, x, y, pf, s, pc, m_TraceMemory);
+		if (m_Trace)
+			RecordFrame();
 
 		// 0x3264 is the value of pc if the functional test passes
 		//if (pc == 0x3264)
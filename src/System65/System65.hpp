@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <climits>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
@@ -25,7 +26,9 @@
 #include <yaml-cpp/yaml.h>
 
 // Project libs
-#include <Trace/BinaryRecord.hpp>
+#include <Devices/TextFramebuffer.hpp>
+#include <Trace/AsyncRecord.hpp>
+#include <Trace/BinaryPlayback.hpp>
 
 /** \file System65.hpp
  * Interface for the \ref System65 class.
@@ -41,6 +44,7 @@
 #define MAX_MEM_SIZE 0x10000 //!< Maximum number of bytes available for system memory; 64KB for just about every kind of 6502.
 #define STACK_BASE 0x0100 //!< Base address for the stack
 #define CODE_BASE 0x0200 //!< Base address for code
+#define TRACE_MAX_REPORTED_DIFFS 32 //!< Most differing bytes of memory listed when a played back trace diverges
 
 /** Function macro to assert the correct decoding of an instruction */
 #define ASSERT_INSN(byte) assert((Memory_Read(pc) == byte) && "Instruction incorrectly decoded, check memory access")
@@ -317,6 +321,40 @@ class System65
 		* anything) will be ignored. */
 		void SYSTEM65CORE Memory_Write(uint16_t addr, uint16_t val);
 
+		/** Returns how many times a page of memory has been written to.
+		 *
+		 * The count only ever goes up (until it wraps), so anything derived
+		 * from the contents of a page, such as disassembly, can remember the
+		 * count and know it's stale once it changes.
+		 *
+		 * \param[in] page Page number, i.e. the upper byte of the address
+		 */
+		uint32_t GetPageWriteCount(uint8_t page) const { return m_PageWrites[page]; }
+
+		//----------------------------------------------------------------------
+		// Devices
+		//----------------------------------------------------------------------
+
+		/** Moves the text framebuffer to a new base address.
+		 *
+		 * The framebuffer is always mapped; by default it starts at
+		 * FRAMEBUFFER_BASE. Its contents are whatever memory holds at the new
+		 * location, and every row is marked dirty.
+		 *
+		 * \param[in] base Guest address for the framebuffer to start at
+		 *
+		 * \throws std::out_of_range if the framebuffer would extend past the
+		 * end of the address space
+		 */
+		void MapFramebuffer(uint16_t base);
+
+		/** Returns the text framebuffer device.
+		 *
+		 * \note The framebuffer is part of the VM state, so the caller should
+		 * have the same locking in place as for any other access.
+		 */
+		Devices::TextFramebuffer &GetFramebuffer(void) { return *m_Framebuffer; }
+
 		//----------------------------------------------------------------------
 
 		/** Generates an external interrupt
@@ -360,17 +398,32 @@ class System65
 		 * you can leave the number parameter out and call EndRecordTrace() when
 		 * you finish.
 		 *
-		 * \param[in] filename Path to the file to record the trace to; an empty
-		 * filename will return immediately.
+		 * The first frame stores all of memory; after that, each frame stores
+		 * only the writes that Memory_Write() logged during the instruction.
+		 * Frames are encoded and written by a background thread, so the VM
+		 * only pays for copying each frame into a queue.
+		 *
+		 * \param[in] filename Path to the file to record the trace to, without
+		 * the extension; an empty filename will return immediately. A name
+		 * ending in ".yml" or ".yaml" records a readable YAML trace instead of
+		 * a binary one (see \ref Trace::Yaml).
 		 * \param[in] instructioncount Number of instructions to record to the
 		 * trace file; a value of 0 will return without creating a trace file.
+		 * \param[in] backpressure What to do when the writer thread falls
+		 * behind; by default the VM waits for it.
+		 *
+		 * \throws std::runtime_error if the trace file can't be created
 		 */
-		void StartRecordTrace(std::string filename = "trace.yml", unsigned int instructioncount = UINT_MAX);
+		void StartRecordTrace(std::string filename = "trace", unsigned int instructioncount = UINT_MAX,
+			Trace::AsyncRecord::Backpressure backpressure = Trace::AsyncRecord::BACKPRESSURE_BLOCK);
 
 		/** Ends a currently-recording trace.
 		 *
 		 * This method will end a trace recording regardless of how many instructions
-		 * are left.
+		 * are left. It waits for the writer thread to write out every queued
+		 * frame.
+		 *
+		 * \throws std::runtime_error if the trace couldn't be written
 		 */
 		void EndRecordTrace(void);
 
@@ -380,6 +433,41 @@ class System65
 		 */
 		bool IsTraceRunning(void);
 
+		/** Plays back a trace file, checking the emulator against it.
+		 *
+		 * The machine is loaded with the state in the first frame of the
+		 * trace, then runs alongside the rest of it. After each recorded
+		 * frame, the registers are compared, along with every address that
+		 * either the trace or the emulator wrote during the frame; when frames
+		 * are missing from the trace, all of memory is compared instead.
+		 * Playback stops at the first frame that doesn't match, and a report of
+		 * the differing registers and memory is printed to <tt>std::cerr</tt>.
+		 *
+		 * When the trace has keyframes and more than one thread is allowed,
+		 * the trace is split into segments at the keyframes instead. Each
+		 * segment starts from its keyframe and is played back by its own
+		 * machine, with the same configuration as this one, on a worker
+		 * thread. Every segment stops at its own first mismatch, and the
+		 * reports are printed in frame order. This machine is left alone in
+		 * that case.
+		 *
+		 * \param[in] filename Path to the trace file; the extension can be
+		 * left out.
+		 * \param[in] instructioncount Number of instructions to play back; a
+		 * value of 0 plays back until the end of the trace.
+		 * \param[in] threads Most worker threads to use; a value of 0 uses one
+		 * per hardware thread.
+		 *
+		 * \return Whether every frame matched
+		 *
+		 * \throws std::runtime_error if the trace can't be read, or a trace is
+		 * being recorded
+		 *
+		 * \note State that isn't in the trace, such as a pending interrupt,
+		 * starts out clear in every segment.
+		 */
+		bool PlayTrace(std::string filename, unsigned int instructioncount = 0, unsigned int threads = 1);
+
 		/** Resets the cycle counter. */
 		void ResetCycleCount(void) { m_CycleCount = 0; }
 
@@ -427,9 +515,22 @@ class System65
 		unsigned int m_InstructionCount; //!< Tracks the number of instructions retired (executed) so far.
 
 		std::unique_ptr<std::vector<uint8_t>> m_Memory; //!< System memory for this system \note Access to this memory is gated through Memory_Read() and Memory_Write().
-		std::shared_ptr<std::vector<uint8_t>> m_TraceMemory; //!< A "filtered" copy of memory for the tracing system
+		std::unique_ptr<Trace::AsyncRecord> m_Trace; //!< Trace object for recording a CPU trace
+		unsigned int m_TraceFrameCount; //!< Instruction count at which the running trace ends
+		bool m_TraceFullFrame; //!< Whether the next frame has to store all of memory instead of the write log
+
+		/** Frame being built for the trace.
+		 *
+		 * While a trace is running, Memory_Write() appends each write here;
+		 * RecordFrame() fills in the registers, pushes a copy to m_Trace and
+		 * empties the log.
+		 */
+		Trace::Frame m_TraceFrame;
+		bool m_WriteLogEnabled; //!< Whether Memory_Write() logs to m_TraceFrame
+
+		std::unique_ptr<Devices::TextFramebuffer> m_Framebuffer; //!< Text framebuffer mapped into the address space
 
-		std::unique_ptr<Trace::BinaryRecord> m_Trace; //!< Trace object for recording a CPU trace
+		uint32_t m_PageWrites[MAX_MEM_SIZE >> 8]; //!< Number of writes to each page of memory \see GetPageWriteCount
 
 		std::clock_t m_CStart; //!< Starting clock for measuing execution speed
 		std::clock_t m_CStop; //!< Ending clock for measuring execution speed
@@ -535,17 +636,40 @@ class System65
 
 		std::string m_TraceFilename; //!< Filename for the trace file to be written/read
 
-		/** Records a frame of execution.
+		/** Plays back part of a trace.
+		 *
+		 * The machine is loaded with <tt>start</tt> and <tt>memory</tt>, then
+		 * checked against each frame that <tt>playback</tt> returns, up to
+		 * frame <tt>last</tt>.
+		 *
+		 * \param[in] playback Trace, positioned just after <tt>start</tt>
+		 * \param[in] start Registers to start from
+		 * \param[in] memory All of memory to start from
+		 * \param[in] last Number of the last frame to check
+		 * \param[out] frames Receives the number of frames that matched
+		 * \param[out] report Receives the report if a frame doesn't match
 		 *
-		 * This method should be called before execution begins.
+		 * \return Number of the first frame that doesn't match, or 0 if they
+		 * all do
+		 */
+		uint32_t PlaySegment(Trace::BinaryPlayback &playback, const Trace::FrameView &start, const uint8_t *memory,
+			uint32_t last, uint64_t &frames, std::ostream &report);
+
+		/** Writes how the machine differs from a frame of a trace.
+		 *
+		 * \param[in] frame Frame from the trace
+		 * \param[in] expected Memory as the trace has it
+		 * \param[out] out Stream to write the report to
+		 */
+		void ReportDivergence(const Trace::FrameView &frame, const std::vector<uint8_t> &expected, std::ostream &out);
+
+		/** Records a frame of execution.
 		 *
-		 * \param[in] frameNumber The current instruction count
-		 * \param[in] oldMemory Memory state from the last frame, after
-		 * execution; if this is null, the entire current memory state will be
-		 * stored
-		 * \param[in] newMemory Memory state from the current frame, after execution
+		 * This method should be called once an instruction has retired, i.e.
+		 * just before the next one is fetched. The frame number is the current
+		 * instruction count.
 		 */
-		void RecordFrame(unsigned int frameNumber, uint8_t oldMemory[0x10000], uint8_t newMemory[0x10000]);
+		void RecordFrame(void);
 
 		/** Runs a single instruction.
 		 *
@@ -0,0 +1,149 @@
+#include "System65Silt/CodeArena.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#ifndef WIN32
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif // WIN32
+
+namespace {
+	/** Rounds <tt>val</tt> up to a multiple of <tt>align</tt>, which must be a power of 2. */
+	size_t RoundUp(size_t val, size_t align)
+	{
+		return (val + align - 1) & ~(align - 1);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Public
+//------------------------------------------------------------------------------
+CodeArena::CodeArena(size_t size) :
+	m_Used(0),
+	m_Sealed(0),
+	m_Committed(0)
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	::GetSystemInfo(&info);
+	m_PageSize = info.dwPageSize;
+#else
+	m_PageSize = (size_t)::sysconf(_SC_PAGESIZE);
+#endif // WIN32
+	assert(CODEARENA_COMMIT % m_PageSize == 0);
+
+	// Only address space is taken here; memory is committed as it's used
+	m_Size = RoundUp(size, CODEARENA_COMMIT);
+#ifdef WIN32
+	m_Base = static_cast<uint8_t *>(::VirtualAlloc(NULL, m_Size, MEM_RESERVE, PAGE_NOACCESS));
+	if (m_Base == NULL)
+		throw std::bad_alloc();
+#else
+	void *ptr = ::mmap(NULL, m_Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (ptr == MAP_FAILED)
+		throw std::bad_alloc();
+	m_Base = static_cast<uint8_t *>(ptr);
+#endif // WIN32
+}
+
+CodeArena::~CodeArena()
+{
+#ifdef WIN32
+	::VirtualFree(m_Base, 0, MEM_RELEASE);
+#else
+	::munmap(m_Base, m_Size);
+#endif // WIN32
+}
+
+uint8_t *CodeArena::Alloc(size_t size)
+{
+	size_t offset = RoundUp(m_Used, CODEARENA_ALIGN);
+	if ((offset > m_Size) || (size > m_Size - offset))
+		return NULL;
+	size_t end = offset + size;
+
+	// The new code may share the last sealed page with older code
+	if (offset < m_Sealed) {
+		size_t page = offset & ~(m_PageSize - 1);
+		Protect(page, m_Sealed - page, false);
+		m_Sealed = page;
+	}
+
+	if (end > m_Committed) {
+		size_t commit = RoundUp(end, CODEARENA_COMMIT);
+#ifdef WIN32
+		if (::VirtualAlloc(m_Base + m_Committed, commit - m_Committed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+			throw std::bad_alloc();
+#else
+		if (::mprotect(m_Base + m_Committed, commit - m_Committed, PROT_READ | PROT_WRITE) != 0)
+			throw std::bad_alloc();
+#endif // WIN32
+		m_Committed = commit;
+	}
+
+	m_Used = end;
+	return m_Base + offset;
+}
+
+void CodeArena::Write(uint8_t *ptr, const void *data, size_t size)
+{
+	size_t offset = (size_t)(ptr - m_Base);
+	assert(offset + size <= m_Used);
+
+	for (size_t page = offset & ~(m_PageSize - 1); (page < offset + size) && (page < m_Sealed); page += m_PageSize) {
+		if (std::find(m_Unsealed.begin(), m_Unsealed.end(), page) == m_Unsealed.end()) {
+			Protect(page, m_PageSize, false);
+			m_Unsealed.push_back(page);
+		}
+	}
+	memcpy(ptr, data, size);
+}
+
+void CodeArena::Seal(void)
+{
+	for (size_t i = 0; i < m_Unsealed.size(); i++)
+		Protect(m_Unsealed[i], m_PageSize, true);
+	m_Unsealed.clear();
+
+	size_t end = RoundUp(m_Used, m_PageSize);
+	if (end <= m_Sealed)
+		return;
+
+	Protect(m_Sealed, end - m_Sealed, true);
+	m_Sealed = end;
+}
+
+void CodeArena::Reset(void)
+{
+	if (m_Sealed > 0)
+		Protect(0, m_Sealed, false);
+	m_Unsealed.clear();
+	m_Sealed = 0;
+	m_Used = 0;
+}
+
+//------------------------------------------------------------------------------
+// Protected
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void CodeArena::Protect(size_t offset, size_t size, bool executable)
+{
+#ifdef WIN32
+	DWORD old;
+	if (!::VirtualProtect(m_Base + offset, size, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &old))
+		throw std::runtime_error("could not change the protection of generated code");
+	if (executable)
+		::FlushInstructionCache(::GetCurrentProcess(), m_Base + offset, size);
+#else
+	if (::mprotect(m_Base + offset, size, executable ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE)) != 0)
+		throw std::runtime_error("could not change the protection of generated code");
+#endif // WIN32
+}
@@ -0,0 +1,121 @@
+#ifndef CODEARENA_HPP
+#define CODEARENA_HPP
+
+#ifdef WIN32
+	#include <windows.h>
+#endif // WIN32
+
+// Standard libs
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#define CODEARENA_ALIGN 16 //!< Alignment of each allocation, in bytes
+#define CODEARENA_COMMIT (64 * 1024) //!< Bytes committed at a time as the arena fills
+
+/** \file CodeArena.hpp
+ * Interface for the \ref CodeArena class.
+ */
+
+/** \class CodeArena
+ * A region of memory that generated code is written to and run from.
+ *
+ * The whole region is reserved up front, so the code lives in one block of
+ * address space, and committed CODEARENA_COMMIT bytes at a time as Alloc()
+ * hands it out from the front. Nothing is freed on its own; when the arena
+ * is full, Reset() throws everything away at once.
+ *
+ * No page is ever writable and executable at the same time. Pages that
+ * Alloc() hands out are writable, and stay that way until Seal() makes
+ * everything written since the last call executable with a single
+ * protection change. The last page can hold code that has been sealed and
+ * room for more, so the next Alloc() makes it writable again, which
+ * unseals the code already on it as well; call Seal() before running
+ * anything.
+ *
+ * Code that has already been sealed can be changed with Write(), which
+ * makes just the pages it touches writable until the next Seal().
+ */
+class CodeArena
+{
+public:
+	/** Reserves the arena.
+	 *
+	 * \param[in] size Size of the arena, in bytes; rounded up to a whole
+	 * number of pages
+	 *
+	 * \throws std::bad_alloc if the address space can't be reserved
+	 */
+	CodeArena(size_t size);
+
+	/** Releases the arena, and any code in it. */
+	~CodeArena();
+
+	CodeArena(const CodeArena&) = delete;
+	CodeArena &operator=(const CodeArena&) = delete;
+
+	/** Allocates CODEARENA_ALIGN-aligned, writable space for code.
+	 *
+	 * \param[in] size Size of the code, in bytes
+	 *
+	 * \return Pointer to the space, or NULL if the arena is full
+	 *
+	 * \throws std::bad_alloc if the memory can't be committed
+	 * \throws std::runtime_error if the protection can't be changed
+	 */
+	uint8_t *Alloc(size_t size);
+
+	/** Writes over code that may already have been sealed.
+	 *
+	 * The pages written to are writable until the next Seal().
+	 *
+	 * \param[in] ptr Where to write, inside space from Alloc()
+	 * \param[in] data Bytes to write
+	 * \param[in] size Number of bytes to write
+	 *
+	 * \throws std::runtime_error if the protection can't be changed
+	 */
+	void Write(uint8_t *ptr, const void *data, size_t size);
+
+	/** Makes everything allocated or written since the last call executable.
+	 *
+	 * Does nothing if there's nothing new.
+	 *
+	 * \throws std::runtime_error if the protection can't be changed
+	 */
+	void Seal(void);
+
+	/** Throws away everything allocated, making the whole arena free.
+	 *
+	 * \throws std::runtime_error if the protection can't be changed
+	 */
+	void Reset(void);
+
+	/** Returns the number of bytes allocated so far, including padding. */
+	size_t GetUsed(void) const { return m_Used; }
+
+	/** Returns the size of the arena, in bytes. */
+	size_t GetSize(void) const { return m_Size; }
+
+protected:
+private:
+	uint8_t *m_Base; //!< Start of the arena
+	size_t m_Size; //!< Size of the arena
+	size_t m_PageSize; //!< Host page size
+	size_t m_Used; //!< Bytes allocated
+	size_t m_Sealed; //!< Bytes at the start of the arena that are executable; always a whole number of pages
+	size_t m_Committed; //!< Bytes at the start of the arena that are backed by memory
+	std::vector<size_t> m_Unsealed; //!< Offsets of the pages below m_Sealed that Write() made writable
+
+	/** Changes the protection of a range of whole pages.
+	 *
+	 * \param[in] offset Start of the range, in bytes from m_Base
+	 * \param[in] size Size of the range, in bytes
+	 * \param[in] executable true for read/execute, false for read/write
+	 */
+	void Protect(size_t offset, size_t size, bool executable);
+};
+
+#endif // CODEARENA_HPP
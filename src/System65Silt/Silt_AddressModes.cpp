@@ -2,55 +2,174 @@
 
 uint16_t System65Silt::Addr_ABS(uint8_t *in)
 {
-	return 0;
+	return (uint16_t)(in[1] | (in[2] << 8));
 }
 
 uint16_t System65Silt::Addr_ABX(uint8_t *in)
 {
-	return 0;
+	return (uint16_t)((in[1] | (in[2] << 8)) + m_Register.x);
 }
 
 uint16_t System65Silt::Addr_ABY(uint8_t *in)
 {
-	return 0;
+	return (uint16_t)((in[1] | (in[2] << 8)) + m_Register.y);
 }
 
 uint16_t System65Silt::Addr_IMM(uint8_t *in)
 {
-	return 0;
+	return (uint16_t)((in - m_Memory) + 1);
 }
 
 uint16_t System65Silt::Addr_IND(uint8_t *in)
 {
-	return 0;
+	// The NMOS 6502 doesn't carry into the high byte of the pointer
+	uint16_t ptr = Addr_ABS(in);
+	return (uint16_t)(m_Memory[ptr] | (m_Memory[(ptr & 0xFF00) | ((ptr + 1) & 0xFF)] << 8));
 }
 
 uint16_t System65Silt::Addr_INX(uint8_t *in)
 {
-	return 0;
+	uint8_t zp = (uint8_t)(in[1] + m_Register.x);
+	return (uint16_t)(m_Memory[zp] | (m_Memory[(uint8_t)(zp + 1)] << 8));
 }
 
 uint16_t System65Silt::Addr_INY(uint8_t *in)
 {
-	return 0;
+	uint8_t zp = in[1];
+	return (uint16_t)((m_Memory[zp] | (m_Memory[(uint8_t)(zp + 1)] << 8)) + m_Register.y);
 }
 
 uint16_t System65Silt::Addr_REL(uint8_t *in)
 {
-	return 0;
+	return (uint16_t)((in - m_Memory) + 2 + (int8_t)in[1]);
 }
 
 uint16_t System65Silt::Addr_ZPG(uint8_t *in)
 {
-	return 0;
+	return in[1];
 }
 
 uint16_t System65Silt::Addr_ZPX(uint8_t *in)
 {
-	return 0;
+	return (uint8_t)(in[1] + m_Register.x);
 }
 
 uint16_t System65Silt::Addr_ZPY(uint8_t *in)
 {
-	return 0;
-}
\ No newline at end of file
+	return (uint8_t)(in[1] + m_Register.y);
+}
+
+int System65Silt::Emit_AbsIndexed(uint8_t *&out, uint16_t base, uint8_t index, bool penalty)
+{
+	int size = Emit(out, {
+		0x0F, 0xB6, index // movzx edx,<index>
+	});
+
+	// A read takes a cycle longer if the sum is on the next page, which is
+	// when the index is at least $100 - the low byte of the base (and the
+	// compare doesn't borrow)
+	if (penalty && ((base & 0xFF) != 0)) {
+		size += Emit(out, {
+			0x80, 0xFA, (uint8_t)(0x100 - (base & 0xFF)), // cmp dl,<imm:$100-lo>
+			0x83, 0xD5, 0xFF                              // adc ebp,-1
+		});
+	}
+
+	if (base <= 0xFF00)
+		return size + Emit_LoadPointer(out, m_Memory + base);
+
+	// The sum can wrap past $FFFF, so do it in 16 bits
+	size += Emit(out, {
+		0x66, 0x81, 0xC2, (uint8_t)(base & 0xFF), (uint8_t)(base >> 8) // add dx,<imm:base>
+	});
+	return size + Emit_LoadPointer(out, m_Memory);
+}
+
+int System65Silt::Emit_Address(const uint8_t *in, uint8_t *&out, AddrMode mode, bool penalty)
+{
+	uint16_t addr = (uint16_t)(in[1] | (in[2] << 8));
+	int size;
+
+	switch (mode) {
+	case AM_ZPG:
+		addr = in[1];
+		// fall through
+	case AM_ABS:
+		size = Emit_LoadPointer(out, m_Memory + addr);
+		return size + Emit(out, {
+			0x31, 0xD2 // xor edx,edx
+		});
+	case AM_ZPX:
+	case AM_ZPY:
+		// the sum wraps around in DL, staying in the zeropage
+		size = Emit_LoadPointer(out, m_Memory);
+		return size + Emit(out, {
+			0x0F, 0xB6, (uint8_t)((mode == AM_ZPX) ? 0xD3 : 0xD7), // movzx edx,<bl/bh>
+			0x80, 0xC2, in[1]                                      // add dl,<imm:zp>
+		});
+	case AM_ABX:
+		return Emit_AbsIndexed(out, addr, 0xD3, penalty);
+	case AM_ABY:
+		return Emit_AbsIndexed(out, addr, 0xD7, penalty);
+	case AM_INX:
+		// the pointer is read from zp+X and zp+X+1, wrapping in the zeropage
+		size = Emit_LoadPointer(out, m_Memory);
+		return size + Emit(out, {
+			0x0F, 0xB6, 0xD3,             // movzx edx,bl
+			0x80, 0xC2, in[1],            // add dl,<imm:zp>
+			0x44, 0x0F, 0xB6, 0x04, 0x16, // movzx r8d,BYTE PTR [rsi+rdx]
+			0xFE, 0xC2,                   // inc dl
+			0x0F, 0xB6, 0x14, 0x16,       // movzx edx,BYTE PTR [rsi+rdx]
+			0xC1, 0xE2, 0x08,             // shl edx,8
+			0x44, 0x09, 0xC2              // or edx,r8d
+		});
+	case AM_INY:
+		// the pointer is read from zp and zp+1, wrapping in the zeropage,
+		// and Y is added to it in 16 bits
+		size = Emit_LoadPointer(out, m_Memory);
+		size += Emit(out, {
+			0x0F, 0xB6, 0x96, (uint8_t)(in[1] + 1), 0x00, 0x00, 0x00, // movzx edx,BYTE PTR [rsi+<zp+1>]
+			0xC1, 0xE2, 0x08,                                          // shl edx,8
+			0x8A, 0x96, in[1], 0x00, 0x00, 0x00,                       // mov dl,[rsi+<zp>]
+			0x02, 0xD7,                                                // add dl,bh
+			0x80, 0xD6, 0x00                                           // adc dh,0
+		});
+		if (penalty) {
+			// the low byte wrapped if it's now below Y
+			size += Emit(out, {
+				0x3A, 0xD7,      // cmp dl,bh
+				0x83, 0xDD, 0x00 // sbb ebp,0
+			});
+		}
+		return size;
+	default:
+		assert(false && "no address for this addressing mode");
+		return 0;
+	}
+}
+
+int System65Silt::Emit_Operand(const uint8_t *in, uint8_t *&out, AddrMode mode)
+{
+	if (mode == AM_IMM) {
+		return Emit(out, {
+			0xB2, in[1] // mov dl,<imm>
+		});
+	}
+
+	int size = Emit_Address(in, out, mode, true);
+	return size + Emit(out, {
+		0x8A, 0x14, 0x16 // mov dl,[rsi+rdx]
+	});
+}
+
+int System65Silt::InstructionSize(AddrMode mode)
+{
+	switch (mode) {
+	case AM_ABS:
+	case AM_ABX:
+	case AM_ABY:
+		return 3;
+	default:
+		return 2;
+	}
+}
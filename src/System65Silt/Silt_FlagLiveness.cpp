@@ -0,0 +1,144 @@
+#include "System65Silt/System65Silt.hpp"
+
+#include <string.h>
+
+#include "Disasm/Opcodes.hpp"
+
+namespace {
+	/** Flags an instruction reads and writes, by mnemonic. */
+	struct FlagEffect {
+		const char *mnemonic; //!< Mnemonic, as in Disasm::Opcodes
+		uint8_t reads; //!< N, V, Z and C flags read
+		uint8_t writes; //!< N, V, Z and C flags written
+	};
+
+	const uint8_t N = 0x80;
+	const uint8_t V = 0x40;
+	const uint8_t Z = 0x02;
+	const uint8_t C = 0x01;
+
+	// Anything that isn't listed neither reads nor writes them; branches,
+	// jumps and returns end the block, so they're never looked up
+	const FlagEffect flagEffects[] = {
+		{ "adc", C,         N|V|Z|C },
+		{ "and", 0,         N|Z     },
+		{ "asl", 0,         N|Z|C   },
+		{ "bit", 0,         N|V|Z   },
+		{ "clc", 0,         C       },
+		{ "clv", 0,         V       },
+		{ "cmp", 0,         N|Z|C   },
+		{ "cpx", 0,         N|Z|C   },
+		{ "cpy", 0,         N|Z|C   },
+		{ "dec", 0,         N|Z     },
+		{ "dex", 0,         N|Z     },
+		{ "dey", 0,         N|Z     },
+		{ "eor", 0,         N|Z     },
+		{ "inc", 0,         N|Z     },
+		{ "inx", 0,         N|Z     },
+		{ "iny", 0,         N|Z     },
+		{ "lda", 0,         N|Z     },
+		{ "ldx", 0,         N|Z     },
+		{ "ldy", 0,         N|Z     },
+		{ "lsr", 0,         N|Z|C   },
+		{ "ora", 0,         N|Z     },
+		{ "php", N|V|Z|C,   0       },
+		{ "pla", 0,         N|Z     },
+		{ "plp", 0,         N|V|Z|C },
+		{ "rol", C,         N|Z|C   },
+		{ "ror", C,         N|Z|C   },
+		{ "sbc", C,         N|V|Z|C },
+		{ "sec", 0,         C       },
+		{ "tax", 0,         N|Z     },
+		{ "tay", 0,         N|Z     },
+		{ "tsx", 0,         N|Z     },
+		{ "txa", 0,         N|Z     },
+		{ "tya", 0,         N|Z     }
+	};
+
+	/** Flag effects of every opcode, looked up from flagEffects once. */
+	struct FlagTable {
+		uint8_t reads[0x100]; //!< Indexed by opcode
+		uint8_t writes[0x100]; //!< Indexed by opcode
+		bool ends[0x100]; //!< Whether the opcode ends a block
+		bool stores[0x100]; //!< Whether the opcode writes to memory by address
+
+		FlagTable()
+		{
+			memset(reads, 0, sizeof(reads));
+			memset(writes, 0, sizeof(writes));
+			for (unsigned int op = 0; op < 0x100; op++) {
+				const char *mnemonic = Disasm::Opcodes[op].mnemonic;
+				ends[op] = (mnemonic != NULL) && ((Disasm::Opcodes[op].mode == Disasm::ADDR_REL) ||
+					(strcmp(mnemonic, "jmp") == 0) || (strcmp(mnemonic, "jsr") == 0) ||
+					(strcmp(mnemonic, "rts") == 0) || (strcmp(mnemonic, "rti") == 0) ||
+					(strcmp(mnemonic, "brk") == 0));
+				stores[op] = (mnemonic != NULL) && (Disasm::Opcodes[op].mode != Disasm::ADDR_ACC) &&
+					((strcmp(mnemonic, "sta") == 0) || (strcmp(mnemonic, "stx") == 0) ||
+					(strcmp(mnemonic, "sty") == 0) || (strcmp(mnemonic, "asl") == 0) ||
+					(strcmp(mnemonic, "lsr") == 0) || (strcmp(mnemonic, "rol") == 0) ||
+					(strcmp(mnemonic, "ror") == 0) || (strcmp(mnemonic, "inc") == 0) ||
+					(strcmp(mnemonic, "dec") == 0));
+				for (size_t i = 0; (mnemonic != NULL) && (i < sizeof(flagEffects) / sizeof(flagEffects[0])); i++) {
+					if (strcmp(mnemonic, flagEffects[i].mnemonic) == 0) {
+						reads[op] = flagEffects[i].reads;
+						writes[op] = flagEffects[i].writes;
+					}
+				}
+			}
+		}
+	};
+
+	const FlagTable flagTable;
+}
+
+void System65Silt::AnalyzeFlags(const uint8_t *in)
+{
+	// Anything not reached below is left with every flag live
+	memset(m_FlagsLiveAfter, FLAGS_TRACKED, sizeof(m_FlagsLiveAfter));
+
+	// Find the instructions, stopping where CompileBlock() does
+	int offsets[SILT_MAX_BLOCK_BYTES + 1];
+	int count = 0;
+	int offset = 0;
+	for (;;) {
+		uint8_t op = in[offset];
+		if (Disasm::Opcodes[op].mnemonic == NULL)
+			break;
+		offsets[count++] = offset;
+		offset += Disasm::Opcodes[op].length;
+		if (flagTable.ends[op] || (offset >= SILT_MAX_BLOCK_BYTES))
+			break;
+	}
+
+	// Then work backwards from the end of the block, where everything is
+	// live. A store that's checked for landing on code can leave the block
+	// too, so everything is live after it as well.
+	uint8_t live = FLAGS_TRACKED;
+	for (int i = count - 1; i >= 0; i--) {
+		const uint8_t *instr = in + offsets[i];
+		AddrMode mode;
+		if (Helper_StoreMode(*instr, mode) && Helper_StoreChecked(instr, mode))
+			live = FLAGS_TRACKED;
+
+		m_FlagsLiveAfter[offsets[i]] = live;
+		live = (uint8_t)((live & ~flagTable.writes[*instr]) | flagTable.reads[*instr]);
+	}
+}
+
+bool System65Silt::Helper_StoreMode(uint8_t opcode, AddrMode &mode)
+{
+	if (!flagTable.stores[opcode])
+		return false;
+
+	switch (Disasm::Opcodes[opcode].mode) {
+	case Disasm::ADDR_ZPG: mode = AM_ZPG; return true;
+	case Disasm::ADDR_ZPX: mode = AM_ZPX; return true;
+	case Disasm::ADDR_ZPY: mode = AM_ZPY; return true;
+	case Disasm::ADDR_ABS: mode = AM_ABS; return true;
+	case Disasm::ADDR_ABX: mode = AM_ABX; return true;
+	case Disasm::ADDR_ABY: mode = AM_ABY; return true;
+	case Disasm::ADDR_IZX: mode = AM_INX; return true;
+	case Disasm::ADDR_IZY: mode = AM_INY; return true;
+	default:               return false;
+	}
+}
@@ -1,5 +1,7 @@
 #include "System65Silt/System65Silt.hpp"
 
+#include <algorithm>
+
 uint8_t System65Silt::Helper_PeekByte(uint16_t addr)
 {
 	return m_Memory[addr];
@@ -13,12 +15,14 @@ uint16_t System65Silt::Helper_PeekWord(uint16_t addr)
 void System65Silt::Helper_Poke(uint16_t addr, uint8_t val)
 {
 	m_Memory[addr] = val;
+	if (IsCodeByte(addr))
+		InvalidateCode(addr);
 }
 
 void System65Silt::Helper_Poke(uint16_t addr, uint16_t val)
 {
-	m_Memory[addr] = val & 0xFF;
-	m_Memory[addr+1] = (val >> 8) & 0xFF;
+	Helper_Poke(addr, (uint8_t)(val & 0xFF));
+	Helper_Poke((uint16_t)(addr+1), (uint8_t)((val >> 8) & 0xFF));
 }
 
 void System65Silt::Helper_Push(uint8_t val)
@@ -41,5 +45,194 @@ uint8_t System65Silt::Helper_PopByte(void)
 
 uint16_t System65Silt::Helper_PopWord(void)
 {
-	return (Helper_PopByte() & (Helper_PopByte() << 8));
+	uint16_t val = Helper_PopByte();
+	val |= Helper_PopByte() << 8;
+	return val;
+}
+
+bool System65Silt::Helper_StoreRange(const uint8_t *in, AddrMode mode, unsigned int &first, unsigned int &last)
+{
+	uint16_t addr = (uint16_t)(in[1] | (in[2] << 8));
+
+	switch (mode) {
+	case AM_ZPG:
+		first = last = in[1];
+		return true;
+	case AM_ABS:
+		first = last = addr;
+		return true;
+	case AM_ZPX:
+	case AM_ZPY:
+		first = 0x00;
+		last = 0xFF;
+		return true;
+	case AM_ABX:
+	case AM_ABY:
+		first = addr;
+		last = addr + 0xFF;
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool System65Silt::Helper_StoreChecked(const uint8_t *in, AddrMode mode)
+{
+	unsigned int first, last;
+	if (!Helper_StoreRange(in, mode, first, last))
+		return true;
+
+	for (unsigned int page = (first >> 8); page <= (last >> 8); page++) {
+		if (m_CompilePages[page & 0xFF])
+			return true;
+	}
+	return false;
+}
+
+int System65Silt::Emit_StoreAddress(const uint8_t *in, uint8_t *&out, AddrMode mode)
+{
+	if (!Helper_StoreChecked(in, mode))
+		return 0;
+
+	uint16_t addr = (uint16_t)(in[1] | (in[2] << 8));
+	switch (mode) {
+	case AM_ZPG:
+		addr = in[1];
+		// fall through
+	case AM_ABS:
+		return Emit(out, {
+			0x41, 0xB8, (uint8_t)(addr & 0xFF), (uint8_t)(addr >> 8), 0x00, 0x00 // mov r8d,<imm:addr>
+		});
+	case AM_ABX:
+	case AM_ABY:
+		// RSI points at the base, and RDX only has the index
+		if (addr <= 0xFF00) {
+			return Emit(out, {
+				0x44, 0x8D, 0x82, (uint8_t)(addr & 0xFF), (uint8_t)(addr >> 8), 0x00, 0x00 // lea r8d,[rdx+<imm:addr>]
+			});
+		}
+		// fall through
+	default:
+		// EDX has the whole address
+		return Emit(out, {
+			0x41, 0x89, 0xD0 // mov r8d,edx
+		});
+	}
+}
+
+int System65Silt::Emit_StoreCheck(const uint8_t *in, uint8_t *&out, AddrMode mode, int count)
+{
+	if (!Helper_StoreChecked(in, mode)) {
+		// Nothing is checked, so the block has to go if code turns up on a
+		// page it writes to; Install() lists it in m_PageWriters. A write
+		// with no known range is always checked, so it never gets here.
+		unsigned int first, last;
+		if (!Helper_StoreRange(in, mode, first, last))
+			return 0;
+		for (unsigned int page = (first >> 8); page <= (last >> 8); page++) {
+			if (std::find(m_CompileWrites.begin(), m_CompileWrites.end(), (uint8_t)page) == m_CompileWrites.end())
+				m_CompileWrites.push_back((uint8_t)page);
+		}
+		return 0;
+	}
+
+	// Most stores to a page with code on it still miss the code, so the
+	// page is only a quick filter in front of the bitmap
+	uint16_t next = (uint16_t)((in - m_CompileMemory.data()) + InstructionSize(mode));
+	uint32_t pages = offsetof(BlockContext, codepages);
+	uint32_t bytes = offsetof(BlockContext, codebytes);
+	uint32_t codewrite = offsetof(BlockContext, codewrite);
+	return Emit(out, {
+		0x45, 0x89, 0xC1,                         // mov r9d,r8d
+		0x41, 0xC1, 0xE9, 0x08,                   // shr r9d,8
+		0x43, 0x80, 0xBC, 0x0D,                   // cmp BYTE PTR [r13+r9+<imm:codepages>],0
+		(uint8_t)(pages & 0xFF), (uint8_t)(pages >> 8), 0x00, 0x00, 0x00,
+		0x74, 0x1C,                               // je <done>
+		0x45, 0x0F, 0xA3, 0x85,                   // bt DWORD PTR [r13+<imm:codebytes>],r8d
+		(uint8_t)(bytes & 0xFF), (uint8_t)(bytes >> 8), 0x00, 0x00,
+		0x73, 0x12,                               // jnc <done>
+		0x45, 0x89, 0x85,                         // mov [r13+<imm:codewrite>],r8d
+		(uint8_t)(codewrite & 0xFF), (uint8_t)(codewrite >> 8), 0x00, 0x00,
+		0x81, 0xED,                               // sub ebp,<imm:count>
+		(uint8_t)(count & 0xFF), (uint8_t)((count >> 8) & 0xFF),
+		(uint8_t)((count >> 16) & 0xFF), (uint8_t)(count >> 24),
+		0x66, 0xBF, (uint8_t)(next & 0xFF), (uint8_t)(next >> 8), // mov di,<imm:next>
+		0xC3                                      // ret
+		// done:
+	});
+}
+
+int System65Silt::Emit_UpdateNZ(uint8_t *&out)
+{
+	return Emit(out, {
+		0x80, 0xE1, 0x7D,            // and cl,~(N|Z)
+		0x41, 0x0A, 0x4C, 0x15, 0x00 // or cl,[r13+rdx]
+	});
+}
+
+int System65Silt::Emit_SetNZ(uint8_t *&out, HostReg reg)
+{
+	if (!IsLive(FLAG_N | FLAG_Z))
+		return 0;
+
+	int size = Emit(out, {
+		0x0F, 0xB6, (uint8_t)(0xD0 | reg) // movzx edx,<reg>
+	});
+	return size + Emit_UpdateNZ(out);
+}
+
+int System65Silt::Emit_StackPointer(uint8_t *&out)
+{
+	int size = Emit_LoadPointer(out, m_EffectiveStackBase);
+	return size + Emit(out, {
+		0x0F, 0xB6, 0xD4 // movzx edx,ah
+	});
+}
+
+int System65Silt::Emit_CallDecimal(uint8_t *&out, uint16_t (*helper)(uint8_t a, uint8_t val, uint8_t p))
+{
+	// RAX and RCX aren't preserved by the call; RBX, RBP, R12 and R13 are.
+	// The two pushes leave the stack aligned as it was when the block was
+	// called, so it takes another 8 bytes (plus the shadow space on Windows)
+	// to align it for the call.
+	int size = Emit(out, {
+		0x50,                  // push rax
+		0x51,                  // push rcx
+#ifdef _WIN64
+		0x48, 0x83, 0xEC, 0x28, // sub rsp,40
+		0x44, 0x0F, 0xB6, 0xC1, // movzx r8d,cl
+		0x0F, 0xB6, 0xC8,       // movzx ecx,al
+		0x0F, 0xB6, 0xD2,       // movzx edx,dl
+#else
+		0x48, 0x83, 0xEC, 0x08, // sub rsp,8
+		0x0F, 0xB6, 0xF8,       // movzx edi,al
+		0x0F, 0xB6, 0xF2,       // movzx esi,dl
+		0x0F, 0xB6, 0xD1,       // movzx edx,cl
+#endif // _WIN64
+		0x48, 0xB8              // mov rax,<imm:helper>
+	});
+	if (out != NULL)
+		EmitPointer(out, (const void *)helper);
+	size += 8;
+
+	return size + Emit(out, {
+		0xFF, 0xD0,             // call rax
+#ifdef _WIN64
+		0x48, 0x83, 0xC4, 0x28, // add rsp,40
+#else
+		0x48, 0x83, 0xC4, 0x08, // add rsp,8
+#endif // _WIN64
+		0x89, 0xC2,             // mov edx,eax
+		0x59,                   // pop rcx
+		0x58,                   // pop rax
+		0x88, 0xD0,             // mov al,dl
+		0x88, 0xF1              // mov cl,dh
+	});
+}
+
+int System65Silt::Emit_Implied(const uint8_t *&in, uint8_t *&out, int &count, int cycles, std::initializer_list<uint8_t> code)
+{
+	in += 1;
+	count += cycles;
+	return Emit(out, code);
 }
\ No newline at end of file
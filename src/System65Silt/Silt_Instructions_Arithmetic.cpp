@@ -1 +1,291 @@
-//#include "System65Silt/System65Silt.hpp"
+#include "System65Silt/System65Silt.hpp"
+
+// Arithmetic Operations
+
+int System65Silt::Emit_AddSub(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, bool subtract, int cycles)
+{
+	int size = Emit_Operand(in, out, mode);
+
+	// Sizes of the binary and decimal paths, so they can be jumped over
+	uint8_t *none = NULL;
+	bool cv = IsLive(FLAG_C | FLAG_V);
+	int binsize = (subtract ? 7 : 6) + (cv ? 16 : 0) + Emit_SetNZ(none, REG_AL);
+	int decsize = Emit_CallDecimal(none, subtract ? Helper_DecimalSBC : Helper_DecimalADC);
+
+	size += Emit(out, {
+		0xF6, 0xC1, 0x08,                 // test cl,D
+		0x75, (uint8_t)(binsize + 2),     // jnz <decimal>
+		0x0F, 0xBA, 0xE1, 0x00            // bt ecx,0
+	});
+
+	// x86 borrows where the 6502 carries, so the carry is flipped around
+	// SBB; V works out the same
+	if (subtract) {
+		size += Emit(out, {
+			0xF5,             // cmc
+			0x18, 0xD0        // sbb al,dl
+		});
+	} else {
+		size += Emit(out, {
+			0x10, 0xD0        // adc al,dl
+		});
+	}
+	if (cv) {
+		size += Emit(out, {
+			0x0F, (uint8_t)(subtract ? 0x93 : 0x92), 0xC2, // setnc/setc dl
+			0x0F, 0x90, 0xC6,                              // seto dh
+			0x80, 0xE1, 0xBE,                              // and cl,~(V|C)
+			0x08, 0xD1,                                    // or cl,dl
+			0xC0, 0xE6, 0x06,                              // shl dh,6
+			0x08, 0xF1                                     // or cl,dh
+		});
+	}
+	size += Emit_SetNZ(out, REG_AL);
+	size += Emit(out, {
+		0xEB, (uint8_t)decsize // jmp <done>
+	});
+
+	// decimal:
+	size += Emit_CallDecimal(out, subtract ? Helper_DecimalSBC : Helper_DecimalADC);
+	// done:
+
+	in += InstructionSize(mode);
+	count += cycles;
+	return size;
+}
+
+int System65Silt::Emit_Compare(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles)
+{
+	int size = Emit_Operand(in, out, mode);
+	size += Emit(out, {
+		0x88, (uint8_t)(0xC6 | (reg << 3)), // mov dh,<reg>
+		0x28, 0xD6                          // sub dh,dl
+	});
+	if (IsLive(FLAG_C)) {
+		size += Emit(out, {
+			0x0F, 0x93, 0xC2, // setnc dl
+			0x80, 0xE1, 0xFE, // and cl,~C
+			0x08, 0xD1        // or cl,dl
+		});
+	}
+	size += Emit_SetNZ(out, REG_DH);
+
+	in += InstructionSize(mode);
+	count += cycles;
+	return size;
+}
+
+uint16_t System65Silt::Helper_DecimalADC(uint8_t a, uint8_t val, uint8_t p)
+{
+	unsigned int c = p & 0x01;
+
+	// Add each digit, carrying into the next if it goes over 9. Z comes from
+	// the binary sum, and N and V from the sum before the high digit is
+	// adjusted.
+	unsigned int lo = (a & 0x0F) + (val & 0x0F) + c;
+	if (lo > 0x09)
+		lo += 0x06;
+	unsigned int sum = (a & 0xF0) + (val & 0xF0) + ((lo > 0x0F) ? 0x10 : 0x00) + (lo & 0x0F);
+
+	p &= 0x3C;
+	if (((a + val + c) & 0xFF) == 0)
+		p |= 0x02;
+	p |= sum & 0x80;
+	if (~(a ^ val) & (a ^ sum) & 0x80)
+		p |= 0x40;
+
+	if ((sum & 0x1F0) > 0x90)
+		sum += 0x60;
+	if ((sum & 0xFF0) > 0xF0)
+		p |= 0x01;
+
+	return (uint16_t)((p << 8) | (sum & 0xFF));
+}
+
+uint16_t System65Silt::Helper_DecimalSBC(uint8_t a, uint8_t val, uint8_t p)
+{
+	int borrow = (p & 0x01) ? 0 : 1;
+
+	// The flags are the same as in binary mode
+	int diff = a - val - borrow;
+	p &= 0x3C;
+	if ((diff & 0xFF) == 0)
+		p |= 0x02;
+	p |= diff & 0x80;
+	if ((a ^ val) & (a ^ diff) & 0x80)
+		p |= 0x40;
+	if (diff >= 0)
+		p |= 0x01;
+
+	// Subtract each digit, borrowing from the next if it goes under 0
+	int lo = (a & 0x0F) - (val & 0x0F) - borrow;
+	int hi = (a & 0xF0) - (val & 0xF0);
+	if (lo < 0) {
+		lo -= 0x06;
+		hi -= 0x10;
+	}
+	if (hi < 0)
+		hi -= 0x60;
+
+	return (uint16_t)((p << 8) | (hi & 0xF0) | (lo & 0x0F));
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_adcimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_IMM, false, 2);
+}
+
+int System65Silt::i_adczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ZPG, false, 3);
+}
+
+int System65Silt::i_adczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ZPX, false, 4);
+}
+
+int System65Silt::i_adcabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABS, false, 4);
+}
+
+int System65Silt::i_adcabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABX, false, 4);
+}
+
+int System65Silt::i_adcaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABY, false, 4);
+}
+
+int System65Silt::i_adcinx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_INX, false, 6);
+}
+
+int System65Silt::i_adciny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_INY, false, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_sbcimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_IMM, true, 2);
+}
+
+int System65Silt::i_sbczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ZPG, true, 3);
+}
+
+int System65Silt::i_sbczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ZPX, true, 4);
+}
+
+int System65Silt::i_sbcabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABS, true, 4);
+}
+
+int System65Silt::i_sbcabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABX, true, 4);
+}
+
+int System65Silt::i_sbcaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_ABY, true, 4);
+}
+
+int System65Silt::i_sbcinx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_INX, true, 6);
+}
+
+int System65Silt::i_sbciny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_AddSub(in, out, count, AM_INY, true, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_cmpimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_IMM, REG_AL, 2);
+}
+
+int System65Silt::i_cmpzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ZPG, REG_AL, 3);
+}
+
+int System65Silt::i_cmpzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ZPX, REG_AL, 4);
+}
+
+int System65Silt::i_cmpabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ABS, REG_AL, 4);
+}
+
+int System65Silt::i_cmpabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ABX, REG_AL, 4);
+}
+
+int System65Silt::i_cmpaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ABY, REG_AL, 4);
+}
+
+int System65Silt::i_cmpinx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_INX, REG_AL, 6);
+}
+
+int System65Silt::i_cmpiny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_INY, REG_AL, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_cpximm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_IMM, REG_BL, 2);
+}
+
+int System65Silt::i_cpxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ZPG, REG_BL, 3);
+}
+
+int System65Silt::i_cpxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ABS, REG_BL, 4);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_cpyimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_IMM, REG_BH, 2);
+}
+
+int System65Silt::i_cpyzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ZPG, REG_BH, 3);
+}
+
+int System65Silt::i_cpyabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Compare(in, out, count, AM_ABS, REG_BH, 4);
+}
@@ -0,0 +1,66 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Branches
+
+int System65Silt::Emit_Branch(const uint8_t *&in, uint8_t *&, int &count, bool &stop, uint8_t flag, bool set)
+{
+	uint16_t next = (uint16_t)((in - m_CompileMemory.data()) + 2);
+	uint16_t target = (uint16_t)(next + (int8_t)in[1]);
+
+	// The test and the two exits go after the block's cycles are taken off,
+	// so they're left to CompileBlock(). A taken branch costs a cycle, or
+	// two if it lands on another page.
+	m_BlockEnd.count = 2;
+	m_BlockEnd.target[0] = target;
+	m_BlockEnd.target[1] = next;
+	m_BlockEnd.flag = flag;
+	m_BlockEnd.set = set;
+	m_BlockEnd.penalty = ((next ^ target) & 0xFF00) ? 2 : 1;
+
+	stop = true;
+	in += 2;
+	count += 2;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_bcc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x01, false);
+}
+
+int System65Silt::i_bcs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x01, true);
+}
+
+int System65Silt::i_beq(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x02, true);
+}
+
+int System65Silt::i_bmi(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x80, true);
+}
+
+int System65Silt::i_bne(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x02, false);
+}
+
+int System65Silt::i_bpl(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x80, false);
+}
+
+int System65Silt::i_bvc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x40, false);
+}
+
+int System65Silt::i_bvs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	return Emit_Branch(in, out, count, stop, 0x40, true);
+}
@@ -0,0 +1,67 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Increments and Decrements
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_inczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xFE, 0, REG_DL, 5);
+}
+
+int System65Silt::i_inczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xFE, 0, REG_DL, 6);
+}
+
+int System65Silt::i_incabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xFE, 0, REG_DL, 6);
+}
+
+int System65Silt::i_incabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xFE, 0, REG_DL, 7);
+}
+
+int System65Silt::i_inx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xFE, 0, REG_BL, 2);
+}
+
+int System65Silt::i_iny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xFE, 0, REG_BH, 2);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_deczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xFE, 1, REG_DL, 5);
+}
+
+int System65Silt::i_deczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xFE, 1, REG_DL, 6);
+}
+
+int System65Silt::i_decabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xFE, 1, REG_DL, 6);
+}
+
+int System65Silt::i_decabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xFE, 1, REG_DL, 7);
+}
+
+int System65Silt::i_dex(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xFE, 1, REG_BL, 2);
+}
+
+int System65Silt::i_dey(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xFE, 1, REG_BH, 2);
+}
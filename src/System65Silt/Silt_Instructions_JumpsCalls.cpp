@@ -1,82 +1,89 @@
 #include "System65Silt/System65Silt.hpp"
 
-int System65Silt::i_jmpabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_jmpabs(const uint8_t *&in, uint8_t *&, int &count, bool &stop)
 {
-	if (out != NULL) {
-		*out++ = 0x66; // 16-bit prefix
-		*out++ = 0xBF; // mov di,imm
-		*out++ = in[1]; // <imm>
-		*out++ = in[2];
-	}
+	// Nothing to do but go there
+	SetExit((uint16_t)(in[1] | (in[2] << 8)));
 
 	stop = true;
 	in += 3;
 	count += 3;
-	return 4;
+	return 0;
 }
 
-// TODO: Surely there's a better way to do it...
 int System65Silt::i_jmpind(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
 {
-	if (out != NULL) {
-		// Strategy: get internal 16-bit ptr, zero-extend to 32-bit, add
-		// m_Memory ptr for effective address, and use the address as a ptr to the
-		// ultimate jump target (to load into DI).
-		uint16_t offs = MAKEWORD(in[1],in[2]); // "internal" pointer to jump target
-		*out++ = 0x66; // mov dx,<imm:offs>
-		*out++ = 0xBA;
-		*((uint16_t *)out) = offs; // <immediate:offs>
-		out += 2;
-		*out++ = 0x0F; // movzx edx,dx
-		*out++ = 0xB7;
-		*out++ = 0xD2;
-		*out++ = 0x8D; // lea esi,[edx+<imm:m_Memory>]
-		*out++ = 0xB2;
-		*((uint32_t *)out) = *m_Memory; // <immediate:m_Memory>
-		out += 4;
-		*out++ = 0x66; // mov di, WORD PTR [esi]
-		*out++ = 0x8B;
-		*out++ = 0x3E;
+	uint16_t offs = (uint16_t)(in[1] | (in[2] << 8)); // "internal" pointer to jump target
+
+	// The NMOS 6502 doesn't carry into the high byte of the pointer, so a
+	// pointer at xxFF takes its high byte from xx00
+	if ((offs & 0xFF) == 0xFF) {
+		uint16_t hi = (uint16_t)(offs & 0xFF00);
+		int size = Emit_LoadPointer(out, m_Memory);
+		size += Emit(out, {
+			0x0F, 0xB6, 0x96, (uint8_t)(hi & 0xFF), (uint8_t)(hi >> 8), 0x00, 0x00, // movzx edx,BYTE PTR [rsi+<imm:hi>]
+			0xC1, 0xE2, 0x08,                                                       // shl edx,8
+			0x8A, 0x96, (uint8_t)(offs & 0xFF), (uint8_t)(offs >> 8), 0x00, 0x00,   // mov dl,BYTE PTR [rsi+<imm:offs>]
+			0x89, 0xD7                                                              // mov edi,edx
+		});
+
+		stop = true;
+		in += 3;
+		count += 5;
+		return size;
 	}
 
+	// Strategy: embed the host address of the internal 16-bit ptr, and
+	// load the ultimate jump target from there into DI.
+	int size = Emit_LoadPointer(out, m_Memory + offs);
+	size += Emit(out, {
+		0x66, 0x8B, 0x3E // mov di,WORD PTR [rsi]
+	});
+
 	stop = true;
 	in += 3;
 	count += 5;
-	return 16;
+	return size;
 }
 
 int System65Silt::i_jsrabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
 {
-	if (out != NULL) {
-		*out++ = 0xFF; // call dword ptr [siltasm_puship]
-		*out++ = 0x15;
-		*((void**)out) = siltasm_puship;
-		out += 4;
-		*out++ = 0x66; // 16-bit prefix
-		*out++ = 0xBF; // mov di,imm
-		*out++ = in[1]; // <imm>
-		*out++ = in[2];
-	}
+	// JSR pushes the address of its own last byte, high byte first
+	uint16_t ret = (uint16_t)((in - m_CompileMemory.data()) + 2);
+
+	int size = Emit_StackPointer(out);
+	size += Emit(out, {
+		0xC6, 0x04, 0x16, (uint8_t)(ret >> 8),   // mov BYTE PTR [rsi+rdx],<imm:ret hi>
+		0xFE, 0xCC,                              // dec ah
+		0x0F, 0xB6, 0xD4,                        // movzx edx,ah
+		0xC6, 0x04, 0x16, (uint8_t)(ret & 0xFF), // mov BYTE PTR [rsi+rdx],<imm:ret lo>
+		0xFE, 0xCC                               // dec ah
+	});
+	SetExit((uint16_t)(in[1] | (in[2] << 8)));
 
 	stop = true;
 	in += 3;
 	count += 6;
-	return 10;
+	return size;
 }
 
 int System65Silt::i_rts(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
 {
-	if (out != NULL) {
-		*out++ = 0xFF; // call dword ptr [siltasm_popip]
-		*out++ = 0x15;
-		*((void**)out) = siltasm_popip;
-		out += 4;
-		*out++ = 0x66; // inc di
-		*out++ = 0x47;
-	}
+	int size = Emit_LoadPointer(out, m_EffectiveStackBase);
+	size += Emit(out, {
+		0xFE, 0xC4,             // inc ah
+		0x0F, 0xB6, 0xD4,       // movzx edx,ah
+		0x0F, 0xB6, 0x3C, 0x16, // movzx edi,BYTE PTR [rsi+rdx]
+		0xFE, 0xC4,             // inc ah
+		0x0F, 0xB6, 0xD4,       // movzx edx,ah
+		0x0F, 0xB6, 0x14, 0x16, // movzx edx,BYTE PTR [rsi+rdx]
+		0xC1, 0xE2, 0x08,       // shl edx,8
+		0x09, 0xD7,             // or edi,edx
+		0x66, 0xFF, 0xC7        // inc di
+	});
 
 	stop = true;
 	in += 1;
 	count += 6;
-	return 8;
-}
\ No newline at end of file
+	return size;
+}
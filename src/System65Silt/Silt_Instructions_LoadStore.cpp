@@ -1,148 +1,214 @@
 #include "System65Silt/System65Silt.hpp"
 
-int System65Silt::i_ldaimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::Emit_Load(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles)
 {
-	if (out != NULL) {
-		*out++ = 0xB0;  // mov al, imm
-		*out++ = in[1]; // <imm>
+	int size;
+
+	if (mode == AM_IMM) {
+		size = Emit(out, {
+			(uint8_t)(0xB0 | reg), in[1] // mov <reg>,<imm>
+		});
+	} else {
+		size = Emit_Address(in, out, mode, true);
+		size += Emit(out, {
+			0x8A, (uint8_t)(0x04 | (reg << 3)), 0x16 // mov <reg>,[rsi+rdx]
+		});
 	}
+	size += Emit_SetNZ(out, reg);
 
-	in += 2;
-	count += 2;
-	return 2;
+	in += InstructionSize(mode);
+	count += cycles;
+	return size;
 }
 
-int System65Silt::i_ldazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::Emit_Store(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles)
 {
-	return 0;
+	int size = Emit_Address(in, out, mode, false);
+	count += cycles;
+
+	// A checked store that wouldn't change the byte is left out, so that
+	// storing the same value over code doesn't throw it away
+	if (Helper_StoreChecked(in, mode)) {
+		uint8_t *none = NULL;
+		int skip = 3 + Emit_StoreCheck(in, none, mode, count);
+		size += Emit_StoreAddress(in, out, mode);
+		size += Emit(out, {
+			0x38, (uint8_t)(0x04 | (reg << 3)), 0x16, // cmp [rsi+rdx],<reg>
+			0x74, (uint8_t)skip                       // je <done>
+		});
+	}
+	size += Emit(out, {
+		0x88, (uint8_t)(0x04 | (reg << 3)), 0x16 // mov [rsi+rdx],<reg>
+	});
+	size += Emit_StoreCheck(in, out, mode, count);
+	// done:
+	in += InstructionSize(mode);
+	return size;
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_ldaimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_IMM, REG_AL, 2);
 }
 
-int System65Silt::i_ldazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	return 0;
+	return Emit_Load(in, out, count, AM_ZPG, REG_AL, 3);
 }
 
-int System65Silt::i_ldaabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	return 0;
+	return Emit_Load(in, out, count, AM_ZPX, REG_AL, 4);
 }
 
-int System65Silt::i_ldaabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldaabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	if (out != NULL) {
-		// zero-extend X register offset (in bl) to edx
-		*out++ = 0x0F; // movzx edx,bl
-		*out++ = 0xB6;
-		*out++ = 0xD3;
+	return Emit_Load(in, out, count, AM_ABS, REG_AL, 4);
+}
 
-		// decode specified absolute address
-		uint16_t offs = MAKEWORD(in[1], in[2]);
+int System65Silt::i_ldaabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ABX, REG_AL, 4);
+}
 
-		// calculate true address in emulated memory
-		uint32_t addr = (uint32_t)(m_Memory + offs);
+int System65Silt::i_ldaaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ABY, REG_AL, 4);
+}
 
-		// load address plus offset (placed in edx above) into esi
-		*out++ = 0x8D; // lea esi,[edx+imm]
-		*out++ = 0xB2;
-		*((uint32_t *)out) = addr; // <imm>
-		out += 4;
+int System65Silt::i_ldainx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_INX, REG_AL, 6);
+}
 
-		// load accumulator (in al) from memory pointed at by esi
-		*out++ = 0x8A; // mov al,[esi]
-		*out++ = 0x06;
-	}
+int System65Silt::i_ldainy(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_INY, REG_AL, 5);
+}
 
-	in += 3;
-	count += 5;
-	return 11;
+//------------------------------------------------------------------------------
+
+int System65Silt::i_ldximm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_IMM, REG_BL, 2);
+}
+
+int System65Silt::i_ldxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ZPG, REG_BL, 3);
 }
 
-int System65Silt::i_ldaaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldxzpy(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	return 0;
+	return Emit_Load(in, out, count, AM_ZPY, REG_BL, 4);
 }
 
-int System65Silt::i_ldainx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	return 0;
+	return Emit_Load(in, out, count, AM_ABS, REG_BL, 4);
 }
 
-int System65Silt::i_ldainy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldxaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	return 0;
+	return Emit_Load(in, out, count, AM_ABY, REG_BL, 4);
 }
 
 //------------------------------------------------------------------------------
 
-int System65Silt::i_ldximm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldyimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	if (out != NULL) {
-		*out++ = 0xB3; // mov bl,imm
-		*out++ = in[1]; // <imm>
-	}
+	return Emit_Load(in, out, count, AM_IMM, REG_BH, 2);
+}
 
-	in += 2;
-	count += 2;
-	return 2;
+int System65Silt::i_ldyzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ZPG, REG_BH, 3);
 }
 
-//------------------------------------------------------------------------------
+int System65Silt::i_ldyzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ZPX, REG_BH, 4);
+}
 
-int System65Silt::i_ldyimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_ldyabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	if (out != NULL) {
-		*out++ = 0xB7; // mov bh,imm
-		*out++ = in[1]; // <imm>
-	}
+	return Emit_Load(in, out, count, AM_ABS, REG_BH, 4);
+}
 
-	return 0;
+int System65Silt::i_ldyabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Load(in, out, count, AM_ABX, REG_BH, 4);
 }
 
 //------------------------------------------------------------------------------
 
-int System65Silt::i_staabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_stazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	if (out != NULL) {
-		// decode specified absolute address
-		uint16_t offs = MAKEWORD(in[1],in[2]);
+	return Emit_Store(in, out, count, AM_ZPG, REG_AL, 3);
+}
 
-		// calculate true address in emulated memory
-		uint32_t addr = (uint32_t)(m_Memory + offs);
+int System65Silt::i_stazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ZPX, REG_AL, 4);
+}
 
-		// store accumulator (in al) to memory pointed by esi
-		*out++ = 0x88; // mov [esi],al
-		*out++ = 0x06;
-	}
+int System65Silt::i_staabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ABS, REG_AL, 4);
+}
 
-	return 0;
+int System65Silt::i_staabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ABX, REG_AL, 5);
 }
 
-int System65Silt::i_staabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+int System65Silt::i_staaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
 {
-	if (out != NULL) {
-		// zero-extend X register offset (in bl) to edx
-		*out++ = 0x0F; // movezx edx, bl
-		*out++ = 0xB6;
-		*out++ = 0xD3;
+	return Emit_Store(in, out, count, AM_ABY, REG_AL, 5);
+}
 
-		// decode specified absolute address
-		uint16_t offs = MAKEWORD(in[1], in[2]);
+int System65Silt::i_stainx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_INX, REG_AL, 6);
+}
 
-		// calculate true address in emulated memory
-		uint32_t addr = (uint32_t)(m_Memory + offs);
+int System65Silt::i_stainy(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_INY, REG_AL, 6);
+}
 
-		// load address plus offset (placed in edx above) into esi
-		*out++ = 0x8D; // lea esi,[edx+imm]
-		*out++ = 0xB2;
-		*((uint32_t *)out) = addr; // <imm>
-		*out += 4;
+//------------------------------------------------------------------------------
 
-		// store accumulator (in al) to memory pointed by esi
-		*out++ = 0x88; // mov [esi],al
-		*out++ = 0x06;
-	}
+int System65Silt::i_stxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ZPG, REG_BL, 3);
+}
 
-	in += 3;
-	count += 5;
-	return 11;
-}
\ No newline at end of file
+int System65Silt::i_stxzpy(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ZPY, REG_BL, 4);
+}
+
+int System65Silt::i_stxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ABS, REG_BL, 4);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_styzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ZPG, REG_BH, 3);
+}
+
+int System65Silt::i_styzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ZPX, REG_BH, 4);
+}
+
+int System65Silt::i_styabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Store(in, out, count, AM_ABS, REG_BH, 4);
+}
@@ -0,0 +1,178 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Logical Operations
+
+int System65Silt::Emit_Logical(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, uint8_t opcode, int cycles)
+{
+	int size = Emit_Operand(in, out, mode);
+	size += Emit(out, {
+		opcode, 0xD0 // <op> al,dl
+	});
+	size += Emit_SetNZ(out, REG_AL);
+
+	in += InstructionSize(mode);
+	count += cycles;
+	return size;
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_andimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_IMM, 0x20, 2);
+}
+
+int System65Silt::i_andzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPG, 0x20, 3);
+}
+
+int System65Silt::i_andzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPX, 0x20, 4);
+}
+
+int System65Silt::i_andabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABS, 0x20, 4);
+}
+
+int System65Silt::i_andabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABX, 0x20, 4);
+}
+
+int System65Silt::i_andaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABY, 0x20, 4);
+}
+
+int System65Silt::i_andinx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INX, 0x20, 6);
+}
+
+int System65Silt::i_andiny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INY, 0x20, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_eorimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_IMM, 0x30, 2);
+}
+
+int System65Silt::i_eorzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPG, 0x30, 3);
+}
+
+int System65Silt::i_eorzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPX, 0x30, 4);
+}
+
+int System65Silt::i_eorabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABS, 0x30, 4);
+}
+
+int System65Silt::i_eorabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABX, 0x30, 4);
+}
+
+int System65Silt::i_eoraby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABY, 0x30, 4);
+}
+
+int System65Silt::i_eorinx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INX, 0x30, 6);
+}
+
+int System65Silt::i_eoriny(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INY, 0x30, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_oraimm(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_IMM, 0x08, 2);
+}
+
+int System65Silt::i_orazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPG, 0x08, 3);
+}
+
+int System65Silt::i_orazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ZPX, 0x08, 4);
+}
+
+int System65Silt::i_oraabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABS, 0x08, 4);
+}
+
+int System65Silt::i_oraabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABX, 0x08, 4);
+}
+
+int System65Silt::i_oraaby(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_ABY, 0x08, 4);
+}
+
+int System65Silt::i_orainx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INX, 0x08, 6);
+}
+
+int System65Silt::i_orainy(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Logical(in, out, count, AM_INY, 0x08, 5);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_bitzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Operand(in, out, AM_ZPG);
+	in += 2;
+	count += 3;
+	return size + Emit_BitTest(out);
+}
+
+int System65Silt::i_bitabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Operand(in, out, AM_ABS);
+	in += 3;
+	count += 4;
+	return size + Emit_BitTest(out);
+}
+
+int System65Silt::Emit_BitTest(uint8_t *&out)
+{
+	if (!IsLive(FLAG_N | FLAG_V | FLAG_Z))
+		return 0;
+
+	// N and V come straight from the operand, and Z from the AND
+	return Emit(out, {
+		0x88, 0xD6,       // mov dh,dl
+		0x20, 0xC6,       // and dh,al
+		0x80, 0xE1, 0x3D, // and cl,~(N|V|Z)
+		0x80, 0xE2, 0xC0, // and dl,N|V
+		0x08, 0xD1,       // or cl,dl
+		0x84, 0xF6,       // test dh,dh
+		0x75, 0x03,       // jnz +3
+		0x80, 0xC9, 0x02  // or cl,Z
+	});
+}
@@ -0,0 +1,35 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Register Transfers
+
+int System65Silt::i_tax(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Implied(in, out, count, 2, {
+		0x88, 0xC3 // mov bl,al
+	});
+	return size + Emit_SetNZ(out, REG_BL);
+}
+
+int System65Silt::i_tay(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Implied(in, out, count, 2, {
+		0x88, 0xC7 // mov bh,al
+	});
+	return size + Emit_SetNZ(out, REG_BH);
+}
+
+int System65Silt::i_txa(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Implied(in, out, count, 2, {
+		0x88, 0xD8 // mov al,bl
+	});
+	return size + Emit_SetNZ(out, REG_AL);
+}
+
+int System65Silt::i_tya(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Implied(in, out, count, 2, {
+		0x88, 0xF8 // mov al,bh
+	});
+	return size + Emit_SetNZ(out, REG_AL);
+}
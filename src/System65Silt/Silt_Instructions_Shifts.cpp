@@ -0,0 +1,167 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Shifts
+
+int System65Silt::Emit_Modify(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, uint8_t opcode, uint8_t op, HostReg reg, int cycles)
+{
+	bool shift = (opcode == 0xD0);
+	bool memory = (reg == REG_DL);
+	int size = 0;
+
+	if (memory) {
+		size += Emit_Address(in, out, mode, false);
+		size += Emit_StoreAddress(in, out, mode);
+	}
+
+	// RCL and RCR rotate through the host's carry, so it needs the guest's
+	if (shift && ((op == 2) || (op == 3))) {
+		size += Emit(out, {
+			0x0F, 0xBA, 0xE1, 0x00 // bt ecx,0
+		});
+	}
+
+	if (memory) {
+		size += Emit(out, {
+			opcode, (uint8_t)(0x04 | (op << 3)), 0x16 // <op> BYTE PTR [rsi+rdx]
+		});
+	} else {
+		size += Emit(out, {
+			opcode, (uint8_t)(0xC0 | (op << 3) | reg) // <op> <reg>
+		});
+	}
+
+	// Swap the bit shifted out into C without touching the other flags
+	if (shift && IsLive(FLAG_C)) {
+		size += Emit(out, {
+			0xD0, 0xD9, // rcr cl,1
+			0xD0, 0xC1  // rol cl,1
+		});
+	}
+
+	if (memory) {
+		if (IsLive(FLAG_N | FLAG_Z)) {
+			size += Emit(out, {
+				0x0F, 0xB6, 0x14, 0x16 // movzx edx,BYTE PTR [rsi+rdx]
+			});
+			size += Emit_UpdateNZ(out);
+		}
+
+		count += cycles;
+		size += Emit_StoreCheck(in, out, mode, count);
+		in += InstructionSize(mode);
+	} else {
+		size += Emit_SetNZ(out, reg);
+		count += cycles;
+		in += 1;
+	}
+
+	return size;
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_aslacc(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xD0, 4, REG_AL, 2);
+}
+
+int System65Silt::i_aslzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xD0, 4, REG_DL, 5);
+}
+
+int System65Silt::i_aslzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xD0, 4, REG_DL, 6);
+}
+
+int System65Silt::i_aslabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xD0, 4, REG_DL, 6);
+}
+
+int System65Silt::i_aslabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xD0, 4, REG_DL, 7);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_lsracc(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xD0, 5, REG_AL, 2);
+}
+
+int System65Silt::i_lsrzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xD0, 5, REG_DL, 5);
+}
+
+int System65Silt::i_lsrzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xD0, 5, REG_DL, 6);
+}
+
+int System65Silt::i_lsrabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xD0, 5, REG_DL, 6);
+}
+
+int System65Silt::i_lsrabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xD0, 5, REG_DL, 7);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_rolacc(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xD0, 2, REG_AL, 2);
+}
+
+int System65Silt::i_rolzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xD0, 2, REG_DL, 5);
+}
+
+int System65Silt::i_rolzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xD0, 2, REG_DL, 6);
+}
+
+int System65Silt::i_rolabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xD0, 2, REG_DL, 6);
+}
+
+int System65Silt::i_rolabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xD0, 2, REG_DL, 7);
+}
+
+//------------------------------------------------------------------------------
+
+int System65Silt::i_roracc(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_IMM, 0xD0, 3, REG_AL, 2);
+}
+
+int System65Silt::i_rorzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPG, 0xD0, 3, REG_DL, 5);
+}
+
+int System65Silt::i_rorzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ZPX, 0xD0, 3, REG_DL, 6);
+}
+
+int System65Silt::i_rorabs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABS, 0xD0, 3, REG_DL, 6);
+}
+
+int System65Silt::i_rorabx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Modify(in, out, count, AM_ABX, 0xD0, 3, REG_DL, 7);
+}
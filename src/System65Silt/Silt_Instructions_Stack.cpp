@@ -2,32 +2,61 @@
 
 // Stack Operations
 
-//void SYSTEM65CORE System65Silt::Insn_TSX(void)
-//{
-//
-//}
-//
-//void SYSTEM65CORE System65Silt::Insn_TXS(void)
-//{
-//
-//}
-//
-//void SYSTEM65CORE System65Silt::Insn_PHA(void)
-//{
-//
-//}
-//
-//void SYSTEM65CORE System65Silt::Insn_PHP(void)
-//{
-//
-//}
-//
-//void SYSTEM65CORE System65Silt::Insn_PLA(void)
-//{
-//
-//}
-//
-//void SYSTEM65CORE System65Silt::Insn_PLP(void)
-//{
-//
-//}
\ No newline at end of file
+int System65Silt::i_tsx(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_Implied(in, out, count, 2, {
+		0x88, 0xE3 // mov bl,ah
+	});
+	return size + Emit_SetNZ(out, REG_BL);
+}
+
+int System65Silt::i_txs(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x88, 0xDC // mov ah,bl
+	});
+}
+
+int System65Silt::i_pha(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_StackPointer(out);
+	return size + Emit_Implied(in, out, count, 3, {
+		0x88, 0x04, 0x16, // mov [rsi+rdx],al
+		0xFE, 0xCC        // dec ah
+	});
+}
+
+int System65Silt::i_php(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	// B and the unused bit are always set in the pushed copy
+	int size = Emit_StackPointer(out);
+	return size + Emit_Implied(in, out, count, 3, {
+		0x88, 0x0C, 0x16,       // mov [rsi+rdx],cl
+		0x80, 0x0C, 0x16, 0x30, // or BYTE PTR [rsi+rdx],0x30
+		0xFE, 0xCC              // dec ah
+	});
+}
+
+int System65Silt::i_pla(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	int size = Emit_LoadPointer(out, m_EffectiveStackBase);
+	size += Emit_Implied(in, out, count, 4, {
+		0xFE, 0xC4,      // inc ah
+		0x0F, 0xB6, 0xD4, // movzx edx,ah
+		0x8A, 0x04, 0x16  // mov al,[rsi+rdx]
+	});
+	return size + Emit_SetNZ(out, REG_AL);
+}
+
+int System65Silt::i_plp(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	// B doesn't exist in the register itself, and the unused bit reads as 1
+	int size = Emit_LoadPointer(out, m_EffectiveStackBase);
+	return size + Emit_Implied(in, out, count, 4, {
+		0xFE, 0xC4,       // inc ah
+		0x0F, 0xB6, 0xD4, // movzx edx,ah
+		0x8A, 0x0C, 0x16, // mov cl,[rsi+rdx]
+		0x80, 0xE1, 0xEF, // and cl,~B
+		0x80, 0xC9, 0x20  // or cl,0x20
+	});
+}
@@ -0,0 +1,52 @@
+#include "System65Silt/System65Silt.hpp"
+
+// Status Flag Changes
+
+int System65Silt::i_clc(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xE1, 0xFE // and cl,~C
+	});
+}
+
+int System65Silt::i_cld(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xE1, 0xF7 // and cl,~D
+	});
+}
+
+int System65Silt::i_cli(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xE1, 0xFB // and cl,~I
+	});
+}
+
+int System65Silt::i_clv(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xE1, 0xBF // and cl,~V
+	});
+}
+
+int System65Silt::i_sec(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xC9, 0x01 // or cl,C
+	});
+}
+
+int System65Silt::i_sed(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xC9, 0x08 // or cl,D
+	});
+}
+
+int System65Silt::i_sei(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {
+		0x80, 0xC9, 0x04 // or cl,I
+	});
+}
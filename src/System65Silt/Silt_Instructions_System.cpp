@@ -1,11 +1,63 @@
 #include "System65Silt/System65Silt.hpp"
 
-int System65Silt::i_nop(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+// System Functions
+
+int System65Silt::i_brk(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
+{
+	// BRK pushes the address after its padding byte, then P with B set
+	uint16_t ret = (uint16_t)((in - m_CompileMemory.data()) + 2);
+
+	int size = Emit_StackPointer(out);
+	size += Emit(out, {
+		0xC6, 0x04, 0x16, (uint8_t)(ret >> 8),   // mov BYTE PTR [rsi+rdx],<imm:ret hi>
+		0xFE, 0xCC,                              // dec ah
+		0x0F, 0xB6, 0xD4,                        // movzx edx,ah
+		0xC6, 0x04, 0x16, (uint8_t)(ret & 0xFF), // mov BYTE PTR [rsi+rdx],<imm:ret lo>
+		0xFE, 0xCC,                              // dec ah
+		0x0F, 0xB6, 0xD4,                        // movzx edx,ah
+		0x88, 0x0C, 0x16,                        // mov [rsi+rdx],cl
+		0x80, 0x0C, 0x16, 0x30,                  // or BYTE PTR [rsi+rdx],0x30
+		0xFE, 0xCC,                              // dec ah
+		0x80, 0xC9, 0x04                         // or cl,I
+	});
+	size += Emit_LoadPointer(out, m_Memory + 0xFFFE);
+	size += Emit(out, {
+		0x66, 0x8B, 0x3E // mov di,WORD PTR [rsi]
+	});
+
+	stop = true;
+	in += 1;
+	count += 7;
+	return size;
+}
+
+int System65Silt::i_nop(const uint8_t *&in, uint8_t *&out, int &count, bool &)
+{
+	return Emit_Implied(in, out, count, 2, {});
+}
+
+int System65Silt::i_rti(const uint8_t *&in, uint8_t *&out, int &count, bool &stop)
 {
-	if (out != NULL)
-		*out++ = 0x90; // nop
+	// Unlike RTS, the address pulled is the one to return to
+	int size = Emit_LoadPointer(out, m_EffectiveStackBase);
+	size += Emit(out, {
+		0xFE, 0xC4,             // inc ah
+		0x0F, 0xB6, 0xD4,       // movzx edx,ah
+		0x8A, 0x0C, 0x16,       // mov cl,[rsi+rdx]
+		0x80, 0xE1, 0xEF,       // and cl,~B
+		0x80, 0xC9, 0x20,       // or cl,0x20
+		0xFE, 0xC4,             // inc ah
+		0x0F, 0xB6, 0xD4,       // movzx edx,ah
+		0x0F, 0xB6, 0x3C, 0x16, // movzx edi,BYTE PTR [rsi+rdx]
+		0xFE, 0xC4,             // inc ah
+		0x0F, 0xB6, 0xD4,       // movzx edx,ah
+		0x0F, 0xB6, 0x14, 0x16, // movzx edx,BYTE PTR [rsi+rdx]
+		0xC1, 0xE2, 0x08,       // shl edx,8
+		0x09, 0xD7              // or edi,edx
+	});
 
+	stop = true;
 	in += 1;
-	count += 1;
-	return 1;
-}
\ No newline at end of file
+	count += 6;
+	return size;
+}
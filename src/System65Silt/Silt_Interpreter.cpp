@@ -0,0 +1,300 @@
+#include "System65Silt/System65Silt.hpp"
+
+#include <string.h>
+
+#include <stdexcept>
+
+#include "Disasm/Opcodes.hpp"
+
+namespace {
+	/** What an instruction does, whatever its addressing mode. */
+	enum Operation {
+		OP_NONE, OP_ADC, OP_AND, OP_ASL, OP_BCC, OP_BCS, OP_BEQ, OP_BIT,
+		OP_BMI, OP_BNE, OP_BPL, OP_BRK, OP_BVC, OP_BVS, OP_CLC, OP_CLD,
+		OP_CLI, OP_CLV, OP_CMP, OP_CPX, OP_CPY, OP_DEC, OP_DEX, OP_DEY,
+		OP_EOR, OP_INC, OP_INX, OP_INY, OP_JMP, OP_JSR, OP_LDA, OP_LDX,
+		OP_LDY, OP_LSR, OP_NOP, OP_ORA, OP_PHA, OP_PHP, OP_PLA, OP_PLP,
+		OP_ROL, OP_ROR, OP_RTI, OP_RTS, OP_SBC, OP_SEC, OP_SED, OP_SEI,
+		OP_STA, OP_STX, OP_STY, OP_TAX, OP_TAY, OP_TSX, OP_TXA, OP_TXS,
+		OP_TYA
+	};
+
+	/** An operation, by mnemonic. */
+	struct OperationName {
+		const char *mnemonic; //!< Mnemonic, as in Disasm::Opcodes
+		Operation op; //!< What it does
+		bool penalty; //!< Whether it takes a cycle longer when indexing crosses a page
+	};
+
+	const OperationName operationNames[] = {
+		{ "adc", OP_ADC, true  }, { "and", OP_AND, true  }, { "asl", OP_ASL, false },
+		{ "bcc", OP_BCC, false }, { "bcs", OP_BCS, false }, { "beq", OP_BEQ, false },
+		{ "bit", OP_BIT, false }, { "bmi", OP_BMI, false }, { "bne", OP_BNE, false },
+		{ "bpl", OP_BPL, false }, { "brk", OP_BRK, false }, { "bvc", OP_BVC, false },
+		{ "bvs", OP_BVS, false }, { "clc", OP_CLC, false }, { "cld", OP_CLD, false },
+		{ "cli", OP_CLI, false }, { "clv", OP_CLV, false }, { "cmp", OP_CMP, true  },
+		{ "cpx", OP_CPX, false }, { "cpy", OP_CPY, false }, { "dec", OP_DEC, false },
+		{ "dex", OP_DEX, false }, { "dey", OP_DEY, false }, { "eor", OP_EOR, true  },
+		{ "inc", OP_INC, false }, { "inx", OP_INX, false }, { "iny", OP_INY, false },
+		{ "jmp", OP_JMP, false }, { "jsr", OP_JSR, false }, { "lda", OP_LDA, true  },
+		{ "ldx", OP_LDX, true  }, { "ldy", OP_LDY, true  }, { "lsr", OP_LSR, false },
+		{ "nop", OP_NOP, false }, { "ora", OP_ORA, true  }, { "pha", OP_PHA, false },
+		{ "php", OP_PHP, false }, { "pla", OP_PLA, false }, { "plp", OP_PLP, false },
+		{ "rol", OP_ROL, false }, { "ror", OP_ROR, false }, { "rti", OP_RTI, false },
+		{ "rts", OP_RTS, false }, { "sbc", OP_SBC, true  }, { "sec", OP_SEC, false },
+		{ "sed", OP_SED, false }, { "sei", OP_SEI, false }, { "sta", OP_STA, false },
+		{ "stx", OP_STX, false }, { "sty", OP_STY, false }, { "tax", OP_TAX, false },
+		{ "tay", OP_TAY, false }, { "tsx", OP_TSX, false }, { "txa", OP_TXA, false },
+		{ "txs", OP_TXS, false }, { "tya", OP_TYA, false }
+	};
+
+	/** The operation of every opcode, looked up from operationNames once. */
+	struct OperationTable {
+		Operation ops[0x100]; //!< Indexed by opcode; OP_NONE if undocumented
+		bool penalty[0x100]; //!< Indexed by opcode
+
+		OperationTable()
+		{
+			memset(penalty, 0, sizeof(penalty));
+			for (unsigned int op = 0; op < 0x100; op++) {
+				ops[op] = OP_NONE;
+				const char *mnemonic = Disasm::Opcodes[op].mnemonic;
+				for (size_t i = 0; (mnemonic != NULL) && (i < sizeof(operationNames) / sizeof(operationNames[0])); i++) {
+					if (strcmp(mnemonic, operationNames[i].mnemonic) == 0) {
+						ops[op] = operationNames[i].op;
+						penalty[op] = operationNames[i].penalty;
+					}
+				}
+			}
+		}
+	};
+
+	const OperationTable operationTable;
+}
+
+void System65Silt::Interpret(void)
+{
+	uint16_t start = m_Register.pc;
+	int cycles = 0;
+	bool stop = false;
+
+	while (!stop) {
+		uint16_t pc = m_Register.pc;
+		uint8_t *in = m_Memory + pc;
+		Operation op = operationTable.ops[*in];
+		const Disasm::OpcodeInfo &info = Disasm::Opcodes[*in];
+
+		if (op == OP_NONE) {
+			// Undocumented opcode; as in CompileBlock(), the block ends in
+			// front of it, and only a block starting with one is an error
+			if (pc == start) {
+				char msg[64];
+				snprintf(msg, sizeof(msg), "Silt can't run opcode 0x%.2X @ $%.4X", *in, pc);
+				throw std::runtime_error(msg);
+			}
+			break;
+		}
+
+		// Work out the operand's address; indexed reads that cross a page
+		// take a cycle longer
+		uint16_t addr = 0;
+		uint8_t index = 0;
+		switch (info.mode) {
+		case Disasm::ADDR_IMM: addr = Addr_IMM(in); break;
+		case Disasm::ADDR_ZPG: addr = Addr_ZPG(in); break;
+		case Disasm::ADDR_ZPX: addr = Addr_ZPX(in); break;
+		case Disasm::ADDR_ZPY: addr = Addr_ZPY(in); break;
+		case Disasm::ADDR_ABS: addr = Addr_ABS(in); break;
+		case Disasm::ADDR_ABX: addr = Addr_ABX(in); index = m_Register.x; break;
+		case Disasm::ADDR_ABY: addr = Addr_ABY(in); index = m_Register.y; break;
+		case Disasm::ADDR_IND: addr = Addr_IND(in); break;
+		case Disasm::ADDR_IZX: addr = Addr_INX(in); break;
+		case Disasm::ADDR_IZY: addr = Addr_INY(in); index = m_Register.y; break;
+		case Disasm::ADDR_REL: addr = Addr_REL(in); break;
+		default: break;
+		}
+		cycles += info.cycles;
+		if (operationTable.penalty[*in] && ((((uint16_t)(addr - index)) ^ addr) & 0xFF00))
+			cycles++;
+
+		uint16_t next = (uint16_t)(pc + info.length);
+		m_Register.pc = next;
+
+		uint8_t &p = m_Register.p;
+		bool acc = (info.mode == Disasm::ADDR_ACC);
+		bool taken = false;
+		switch (op) {
+		// Load/Store
+		case OP_LDA: m_Register.a = m_Memory[addr]; SetNZ(m_Register.a); break;
+		case OP_LDX: m_Register.x = m_Memory[addr]; SetNZ(m_Register.x); break;
+		case OP_LDY: m_Register.y = m_Memory[addr]; SetNZ(m_Register.y); break;
+		case OP_STA: Helper_Poke(addr, m_Register.a); break;
+		case OP_STX: Helper_Poke(addr, m_Register.x); break;
+		case OP_STY: Helper_Poke(addr, m_Register.y); break;
+
+		// Register Transfer
+		case OP_TAX: m_Register.x = m_Register.a; SetNZ(m_Register.x); break;
+		case OP_TAY: m_Register.y = m_Register.a; SetNZ(m_Register.y); break;
+		case OP_TXA: m_Register.a = m_Register.x; SetNZ(m_Register.a); break;
+		case OP_TYA: m_Register.a = m_Register.y; SetNZ(m_Register.a); break;
+
+		// Stack Operations
+		case OP_TSX: m_Register.x = m_Register.s; SetNZ(m_Register.x); break;
+		case OP_TXS: m_Register.s = m_Register.x; break;
+		case OP_PHA: Helper_Push(m_Register.a); break;
+		case OP_PHP: Helper_Push((uint8_t)(p | 0x30)); break;
+		case OP_PLA: m_Register.a = Helper_PopByte(); SetNZ(m_Register.a); break;
+		case OP_PLP: p = (uint8_t)((Helper_PopByte() & ~0x10) | 0x20); break;
+
+		// Logical Operations
+		case OP_AND: m_Register.a &= m_Memory[addr]; SetNZ(m_Register.a); break;
+		case OP_EOR: m_Register.a ^= m_Memory[addr]; SetNZ(m_Register.a); break;
+		case OP_ORA: m_Register.a |= m_Memory[addr]; SetNZ(m_Register.a); break;
+		case OP_BIT: {
+			uint8_t val = m_Memory[addr];
+			p = (uint8_t)((p & 0x3D) | (val & 0xC0) | (((m_Register.a & val) == 0) ? 0x02 : 0x00));
+			break;
+		}
+
+		// Arithmetic
+		case OP_ADC:
+		case OP_SBC: {
+			uint8_t val = m_Memory[addr];
+			if (p & 0x08) {
+				uint16_t result = (op == OP_ADC) ? Helper_DecimalADC(m_Register.a, val, p) : Helper_DecimalSBC(m_Register.a, val, p);
+				m_Register.a = (uint8_t)(result & 0xFF);
+				p = (uint8_t)(result >> 8);
+				break;
+			}
+			// Subtracting is adding the complement, with C as the inverted
+			// borrow
+			if (op == OP_SBC)
+				val = (uint8_t)~val;
+			unsigned int sum = m_Register.a + val + (p & 0x01);
+			p &= 0xBE;
+			if (~(m_Register.a ^ val) & (m_Register.a ^ sum) & 0x80)
+				p |= 0x40;
+			if (sum > 0xFF)
+				p |= 0x01;
+			m_Register.a = (uint8_t)sum;
+			SetNZ(m_Register.a);
+			break;
+		}
+		case OP_CMP: Compare(m_Register.a, m_Memory[addr]); break;
+		case OP_CPX: Compare(m_Register.x, m_Memory[addr]); break;
+		case OP_CPY: Compare(m_Register.y, m_Memory[addr]); break;
+
+		// Increments & Decrements
+		case OP_INC: Helper_Poke(addr, (uint8_t)(m_Memory[addr] + 1)); SetNZ(m_Memory[addr]); break;
+		case OP_INX: m_Register.x++; SetNZ(m_Register.x); break;
+		case OP_INY: m_Register.y++; SetNZ(m_Register.y); break;
+		case OP_DEC: Helper_Poke(addr, (uint8_t)(m_Memory[addr] - 1)); SetNZ(m_Memory[addr]); break;
+		case OP_DEX: m_Register.x--; SetNZ(m_Register.x); break;
+		case OP_DEY: m_Register.y--; SetNZ(m_Register.y); break;
+
+		// Shifts
+		case OP_ASL:
+		case OP_LSR:
+		case OP_ROL:
+		case OP_ROR: {
+			uint8_t val = acc ? m_Register.a : m_Memory[addr];
+			uint8_t carry = p & 0x01;
+			uint8_t result;
+			if ((op == OP_ASL) || (op == OP_ROL)) {
+				result = (uint8_t)((val << 1) | ((op == OP_ROL) ? carry : 0));
+				carry = val >> 7;
+			} else {
+				result = (uint8_t)((val >> 1) | ((op == OP_ROR) ? (carry << 7) : 0));
+				carry = val & 0x01;
+			}
+			p = (uint8_t)((p & ~0x01) | carry);
+			if (acc)
+				m_Register.a = result;
+			else
+				Helper_Poke(addr, result);
+			SetNZ(result);
+			break;
+		}
+
+		// Jumps & Calls
+		case OP_JMP:
+			m_Register.pc = addr;
+			stop = true;
+			break;
+		case OP_JSR:
+			// JSR pushes the address of its own last byte
+			Helper_Push((uint16_t)(next - 1));
+			m_Register.pc = addr;
+			stop = true;
+			break;
+		case OP_RTS:
+			m_Register.pc = (uint16_t)(Helper_PopWord() + 1);
+			stop = true;
+			break;
+
+		// Branches
+		case OP_BCC: taken = (p & 0x01) == 0; break;
+		case OP_BCS: taken = (p & 0x01) != 0; break;
+		case OP_BEQ: taken = (p & 0x02) != 0; break;
+		case OP_BMI: taken = (p & 0x80) != 0; break;
+		case OP_BNE: taken = (p & 0x02) == 0; break;
+		case OP_BPL: taken = (p & 0x80) == 0; break;
+		case OP_BVC: taken = (p & 0x40) == 0; break;
+		case OP_BVS: taken = (p & 0x40) != 0; break;
+
+		// Status Flag Changes
+		case OP_CLC: p &= ~0x01; break;
+		case OP_CLD: p &= ~0x08; break;
+		case OP_CLI: p &= ~0x04; break;
+		case OP_CLV: p &= ~0x40; break;
+		case OP_SEC: p |= 0x01; break;
+		case OP_SED: p |= 0x08; break;
+		case OP_SEI: p |= 0x04; break;
+
+		// System Functions
+		case OP_BRK:
+			// BRK pushes the address after its padding byte, then P with B set
+			Helper_Push((uint16_t)(pc + 2));
+			Helper_Push((uint8_t)(p | 0x30));
+			p |= 0x04;
+			m_Register.pc = Helper_PeekWord(0xFFFE);
+			stop = true;
+			break;
+		case OP_NOP:
+			break;
+		case OP_RTI:
+			p = (uint8_t)((Helper_PopByte() & ~0x10) | 0x20);
+			m_Register.pc = Helper_PopWord();
+			stop = true;
+			break;
+		default:
+			break;
+		}
+
+		if (info.mode == Disasm::ADDR_REL) {
+			// A taken branch costs a cycle, or two if it lands on another page
+			if (taken) {
+				cycles += ((next ^ addr) & 0xFF00) ? 2 : 1;
+				m_Register.pc = addr;
+			}
+			stop = true;
+		}
+
+		if ((uint16_t)(m_Register.pc - start) >= SILT_MAX_BLOCK_BYTES)
+			stop = true;
+	}
+
+	m_CycleCount += cycles;
+	m_TickCycles += cycles;
+}
+
+void System65Silt::SetNZ(uint8_t val)
+{
+	m_Register.p = (uint8_t)((m_Register.p & ~0x82) | m_Context.nz[val]);
+}
+
+void System65Silt::Compare(uint8_t reg, uint8_t val)
+{
+	m_Register.p = (uint8_t)((m_Register.p & ~0x01) | ((reg >= val) ? 0x01 : 0x00));
+	SetNZ((uint8_t)(reg - val));
+}
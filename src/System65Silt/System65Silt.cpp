@@ -1,9 +1,25 @@
 #include "System65Silt/System65Silt.hpp"
 
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
 //------------------------------------------------------------------------------
 // Public
 //------------------------------------------------------------------------------
-System65Silt::System65Silt(unsigned int memsize, uint8_t stackbase)
+System65Silt::System65Silt(unsigned int memsize, uint8_t stackbase) :
+	m_Blocks(0x10000),
+	m_BlockValid(0x10000 / 32, 0),
+	m_BlockHits(0x10000, 0),
+	m_CompileMemory(0x10000 + SILT_MAX_BLOCK_BYTES + 2, 0),
+	m_BlockQueued(0x10000 / 32, 0),
+	m_Compiling(false),
+	m_CompilerStop(false),
+	m_CompiledReady(false),
+	m_Arena(SILT_CODE_CACHE_SIZE),
+	m_EntryArena(256)
 {
 	// Basic bounds checking
 	if (memsize > 0x10000)
@@ -19,43 +35,102 @@ System65Silt::System65Silt(unsigned int memsize, uint8_t stackbase)
 	memset(m_Memory, 0, sizeof(uint8_t)*0xffff);
 	memorysize = memsize;
 	memset(&m_Register, 0, sizeof(m_Register)); // maybe superfluous
+	m_CycleCount = 0;
+	m_TickCycles = 0;
+	m_InterruptPending = false;
+	m_NMInterrupt = false;
+
+	for (unsigned int i = 0; i < 0x100; i++)
+		m_Context.nz[i] = (uint8_t)((i & 0x80) | ((i == 0) ? 0x02 : 0x00));
+	memset(m_Context.codepages, 0, sizeof(m_Context.codepages));
+	memset(m_Context.codebytes, 0, sizeof(m_Context.codebytes));
+	m_Context.codewrite = SILT_NO_CODE_WRITE;
+	m_Context.stopat.store(0, std::memory_order_relaxed);
 
 	m_StackBase = stackbase << 8;
 	m_EffectiveStackBase = m_Memory+m_StackBase;
-	siltasm_init(m_Memory,m_EffectiveStackBase);
+
+#ifndef SILT_HOST_X64
+	delete []m_Memory;
+	throw std::runtime_error("Silt only runs on x86-64 hosts");
+#endif // SILT_HOST_X64
+
+	m_EntrySize = 160;
+	try {
+		m_Entry = m_EntryArena.Alloc(m_EntrySize);
+		EmitEntry();
+		m_EntryArena.Seal();
+		m_Compiler = std::thread(&System65Silt::CompilerMain, this);
+	}
+	catch (...) {
+		delete []m_Memory;
+		throw;
+	}
 }
 
 System65Silt::~System65Silt()
 {
-	// Free the cache
-	for (CacheMap::iterator iter = m_Cache.begin(); iter != m_Cache.end(); ++iter)
-		::VirtualFree(iter->second.ptr, iter->second.size, MEM_DECOMMIT | MEM_RELEASE);
+	{
+		std::lock_guard<std::mutex> lock(m_CompileLock);
+		m_CompilerStop = true;
+	}
+	m_CompileWake.notify_all();
+	m_Compiler.join();
 
 	delete []m_Memory;
 }
 
+void System65Silt::Tick(void)
+{
+	Dispatch(1);
+}
+
 void System65Silt::Tick(unsigned int cycleLimit)
 {
-	const NativeCode *code;
+	if (cycleLimit == 0)
+		return;
 
-	// check to see if the compiled code already exists in our cache
-	CacheMap::const_iterator iter = m_Cache.find(m_Register.pc);
-	if (iter != m_Cache.end())
-		code = &iter->second;
-	else
-		code = Compile(m_Register.pc);
+	while (m_TickCycles < cycleLimit) {
+		unsigned int budget = cycleLimit - m_TickCycles;
+		Dispatch((budget > INT_MAX) ? INT_MAX : (int)budget);
+	}
 
-	// run it
-	Execute(code);
+	// Carry the overrun into the next call
+	m_TickCycles -= cycleLimit;
+}
+
+void System65Silt::Interrupt(bool nmi)
+{
+	// This can be called from another thread while blocks run. stopat is
+	// raised before the interrupt is marked pending, so HandleInterrupt()
+	// lowering it again can only make the interrupt wait for the next
+	// Dispatch(), never leave it raised with nothing pending. An NMI isn't
+	// lost to an IRQ raised after it.
+	if (nmi)
+		m_NMInterrupt.store(true);
+	m_Context.stopat.store(INT_MAX, std::memory_order_relaxed);
+	m_InterruptPending.store(true);
 }
 
 uint8_t System65Silt::SetStackBasePage(uint8_t newbase)
 {
 	uint8_t oldbase = m_StackBase >> 8;
 	m_StackBase = newbase << 8;
+
+	// Compiled blocks have the old stack page built in, and the compiler
+	// thread reads it, so it has to be stopped first
+	if (m_EffectiveStackBase != m_Memory+m_StackBase) {
+		FlushCache();
+		m_EffectiveStackBase = m_Memory+m_StackBase;
+	}
 	return oldbase;
 }
 
+void System65Silt::SetInterruptVector(uint16_t ivec)
+{
+	Helper_Poke(0xFFFE, ivec);
+}
+
 //------------------------------------------------------------------------------
 // Protected
 //------------------------------------------------------------------------------
@@ -64,35 +139,167 @@ uint8_t System65Silt::SetStackBasePage(uint8_t newbase)
 // Private
 //------------------------------------------------------------------------------
 
-const System65Silt::NativeCode *System65Silt::Compile(uint16_t iptr)
+void System65Silt::QueueCompile(uint16_t pc)
+{
+	CompileJob job;
+	job.pc = pc;
+
+	// The compiler thread can't look at anything the guest can change, so
+	// it gets copies
+	size_t size = std::min(sizeof(job.guest), (size_t)(0x10000 - pc));
+	memset(job.guest, 0, sizeof(job.guest));
+	memcpy(job.guest, m_Memory + pc, size);
+	memcpy(job.codepages, m_Context.codepages, sizeof(job.codepages));
+	SetBlockQueued(pc, true);
+
+	{
+		std::lock_guard<std::mutex> lock(m_CompileLock);
+		m_CompileQueue.push_back(std::move(job));
+	}
+	m_CompileWake.notify_all();
+}
+
+void System65Silt::CompilerMain(void)
+{
+	std::unique_lock<std::mutex> lock(m_CompileLock);
+	for (;;) {
+		m_CompileWake.wait(lock, [this] { return m_CompilerStop || !m_CompileQueue.empty(); });
+		if (m_CompilerStop)
+			return;
+
+		CompileJob job = std::move(m_CompileQueue.front());
+		m_CompileQueue.pop_front();
+		m_Compiling = true;
+		lock.unlock();
+
+		try {
+			Translate(job);
+		}
+		catch (const std::exception &) {
+			// Left to the interpreter
+			job.native.clear();
+		}
+
+		lock.lock();
+		m_Compiled.push_back(std::move(job));
+		m_Compiling = false;
+		m_CompiledReady = true;
+		m_CompileWake.notify_all();
+	}
+}
+
+void System65Silt::Translate(CompileJob &job)
 {
-	const uint8_t *in = &(*this)[iptr];
-	NativeCode code;
+	uint8_t *in = m_CompileMemory.data() + job.pc;
+	memcpy(in, job.guest, sizeof(job.guest));
+	memcpy(m_CompilePages, job.codepages, sizeof(m_CompilePages));
+	NativeCode &code = job.code;
 
 	// First-pass compile to determine how much buffer we need
 	// The +1 is for the native return
-	code.size = CompileBlock(in, NULL) + 1;
+	m_CompileWrites.clear();
+	code.size = CompileBlock(in, NULL, code.cyclecount, code.guestsize) + 1;
 
-#ifdef WIN32
-	// Windows only: allow exec in this memory block
-	code.ptr = static_cast<uint8_t *>(::VirtualAlloc(NULL, code.size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
-#endif // WIN32
+	// The pages the block is on will be marked once it's installed, so
+	// stores to them have to be checked; if any are new, size it again
+	bool marked = false;
+	unsigned int last = job.pc + code.guestsize - 1;
+	for (unsigned int page = (job.pc >> 8); page <= (last >> 8); page++) {
+		if (!m_CompilePages[page & 0xFF]) {
+			m_CompilePages[page & 0xFF] = 1;
+			marked = true;
+		}
+	}
+	if (marked) {
+		m_CompileWrites.clear();
+		code.size = CompileBlock(in, NULL, code.cyclecount, code.guestsize) + 1;
+	}
 
 	// Second pass for actual compile
-	CompileBlock(in, code.ptr);
+	job.native.resize(code.size);
+	uint8_t *out = job.native.data();
+	m_CompileWrites.clear();
+	CompileBlock(in, out, code.cyclecount, code.guestsize);
 
 	// Then add the x86 return
-	code.ptr[code.size - 1] = 0xc3;
+	job.native[code.size - 1] = 0xc3;
+	code.ptr = NULL;
+	code.exitcount = m_BlockEnd.count;
+	for (int i = 0; i < code.exitcount; i++)
+		code.exits[i] = m_BlockEnd.exits[i];
+	job.writepages = m_CompileWrites;
+}
+
+void System65Silt::InstallCompiled(void)
+{
+	std::vector<CompileJob> jobs;
+	{
+		std::lock_guard<std::mutex> lock(m_CompileLock);
+		jobs.swap(m_Compiled);
+		m_CompiledReady = false;
+	}
+
+	for (size_t i = 0; i < jobs.size(); i++) {
+		// A block that couldn't be translated stays queued, so it's never
+		// tried again
+		if (jobs[i].native.empty())
+			continue;
+		SetBlockQueued(jobs[i].pc, false);
+		Install(jobs[i]);
+	}
+}
+
+bool System65Silt::Install(const CompileJob &job)
+{
+	uint16_t pc = job.pc;
+
+	// The guest may have written over the code while it was being
+	// translated
+	size_t size = std::min((size_t)job.code.guestsize, (size_t)(0x10000 - pc));
+	if (memcmp(m_Memory + pc, job.guest, size) != 0)
+		return false;
+
+	// or put code where it writes to without checking
+	for (size_t i = 0; i < job.writepages.size(); i++) {
+		if (m_Context.codepages[job.writepages[i]])
+			return false;
+	}
+
+	NativeCode &code = m_Blocks[pc];
+	code = job.code;
+	code.ptr = m_Arena.Alloc(code.size);
+	if (code.ptr == NULL) {
+		// Out of room, so start the cache over; that only unmarks pages,
+		// so the stores the block checks are still enough
+		FlushCache();
+		code.ptr = m_Arena.Alloc(code.size);
+		if (code.ptr == NULL)
+			throw std::bad_alloc();
+	}
+	memcpy(code.ptr, job.native.data(), code.size);
+
+	MarkCodePages(pc, code.guestsize);
+	for (size_t i = 0; i < job.writepages.size(); i++)
+		m_PageWriters[job.writepages[i]].push_back(pc);
 
-	// Finally store it in the cache
-	m_Cache[iptr] = code;
-	return &m_Cache[iptr];
+	// Finally mark it as ready, and chain it to its neighbours
+	SetBlockValid(pc, true);
+	LinkBlock(pc);
+	return true;
 }
 
-int System65Silt::CompileBlock(const uint8_t *in, uint8_t *out)
+void System65Silt::DropCompiles(void)
 {
-	int cyclecount;
+	std::unique_lock<std::mutex> lock(m_CompileLock);
+	m_CompileQueue.clear();
+	m_CompileWake.wait(lock, [this] { return !m_Compiling; });
+	m_Compiled.clear();
+	m_CompiledReady = false;
+	std::fill(m_BlockQueued.begin(), m_BlockQueued.end(), 0);
+}
 
+int System65Silt::CompileBlock(const uint8_t *in, uint8_t *out, int &cyclecount, int &guestsize)
+{
 	// in: ptr to the instruction byte to translate
 	// out: ptr to the next free space in the buffer for emitting native assembly (or NULL if not emitting anything)
 	// c: number of target (6502) cycles for this instruction
@@ -102,64 +309,406 @@ int System65Silt::CompileBlock(const uint8_t *in, uint8_t *out)
 
 	static const CompileFunc opcodeTable[0x100] = {
 		// 00h                     01h                     02h                     03h                     04h                     05h                     06h                     07h                     08h                     09h                     0Ah                     0Bh                     0Ch                     0Dh                     0Eh                     0Fh
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 00h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 10h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 20h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 30h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 40h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 50h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 60h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 70h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // 80h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_staabx,nullptr                ,nullptr                , // 90h
-		   nullptr                ,&System65Silt::i_ldainx,&System65Silt::i_ldximm,nullptr                ,nullptr                ,&System65Silt::i_ldazpg,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_ldaimm,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_ldaabs,nullptr                ,nullptr                , // A0h
-		   nullptr                ,&System65Silt::i_ldainy,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_ldazpx,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_ldaaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_ldaabx,nullptr                ,nullptr                , // B0h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // C0h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // D0h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_nop   ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                , // E0h
-		   nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                ,nullptr                  // F0h
+		   &System65Silt::i_brk   ,&System65Silt::i_orainx,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_orazpg,&System65Silt::i_aslzpg,nullptr                ,&System65Silt::i_php   ,&System65Silt::i_oraimm,&System65Silt::i_aslacc,nullptr                ,nullptr                ,&System65Silt::i_oraabs,&System65Silt::i_aslabs,nullptr                , // 00h
+		   &System65Silt::i_bpl   ,&System65Silt::i_orainy,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_orazpx,&System65Silt::i_aslzpx,nullptr                ,&System65Silt::i_clc   ,&System65Silt::i_oraaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_oraabx,&System65Silt::i_aslabx,nullptr                , // 10h
+		   &System65Silt::i_jsrabs,&System65Silt::i_andinx,nullptr                ,nullptr                ,&System65Silt::i_bitzpg,&System65Silt::i_andzpg,&System65Silt::i_rolzpg,nullptr                ,&System65Silt::i_plp   ,&System65Silt::i_andimm,&System65Silt::i_rolacc,nullptr                ,&System65Silt::i_bitabs,&System65Silt::i_andabs,&System65Silt::i_rolabs,nullptr                , // 20h
+		   &System65Silt::i_bmi   ,&System65Silt::i_andiny,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_andzpx,&System65Silt::i_rolzpx,nullptr                ,&System65Silt::i_sec   ,&System65Silt::i_andaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_andabx,&System65Silt::i_rolabx,nullptr                , // 30h
+		   &System65Silt::i_rti   ,&System65Silt::i_eorinx,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_eorzpg,&System65Silt::i_lsrzpg,nullptr                ,&System65Silt::i_pha   ,&System65Silt::i_eorimm,&System65Silt::i_lsracc,nullptr                ,&System65Silt::i_jmpabs,&System65Silt::i_eorabs,&System65Silt::i_lsrabs,nullptr                , // 40h
+		   &System65Silt::i_bvc   ,&System65Silt::i_eoriny,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_eorzpx,&System65Silt::i_lsrzpx,nullptr                ,&System65Silt::i_cli   ,&System65Silt::i_eoraby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_eorabx,&System65Silt::i_lsrabx,nullptr                , // 50h
+		   &System65Silt::i_rts   ,&System65Silt::i_adcinx,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_adczpg,&System65Silt::i_rorzpg,nullptr                ,&System65Silt::i_pla   ,&System65Silt::i_adcimm,&System65Silt::i_roracc,nullptr                ,&System65Silt::i_jmpind,&System65Silt::i_adcabs,&System65Silt::i_rorabs,nullptr                , // 60h
+		   &System65Silt::i_bvs   ,&System65Silt::i_adciny,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_adczpx,&System65Silt::i_rorzpx,nullptr                ,&System65Silt::i_sei   ,&System65Silt::i_adcaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_adcabx,&System65Silt::i_rorabx,nullptr                , // 70h
+		   nullptr                ,&System65Silt::i_stainx,nullptr                ,nullptr                ,&System65Silt::i_styzpg,&System65Silt::i_stazpg,&System65Silt::i_stxzpg,nullptr                ,&System65Silt::i_dey   ,nullptr                ,&System65Silt::i_txa   ,nullptr                ,&System65Silt::i_styabs,&System65Silt::i_staabs,&System65Silt::i_stxabs,nullptr                , // 80h
+		   &System65Silt::i_bcc   ,&System65Silt::i_stainy,nullptr                ,nullptr                ,&System65Silt::i_styzpx,&System65Silt::i_stazpx,&System65Silt::i_stxzpy,nullptr                ,&System65Silt::i_tya   ,&System65Silt::i_staaby,&System65Silt::i_txs   ,nullptr                ,nullptr                ,&System65Silt::i_staabx,nullptr                ,nullptr                , // 90h
+		   &System65Silt::i_ldyimm,&System65Silt::i_ldainx,&System65Silt::i_ldximm,nullptr                ,&System65Silt::i_ldyzpg,&System65Silt::i_ldazpg,&System65Silt::i_ldxzpg,nullptr                ,&System65Silt::i_tay   ,&System65Silt::i_ldaimm,&System65Silt::i_tax   ,nullptr                ,&System65Silt::i_ldyabs,&System65Silt::i_ldaabs,&System65Silt::i_ldxabs,nullptr                , // A0h
+		   &System65Silt::i_bcs   ,&System65Silt::i_ldainy,nullptr                ,nullptr                ,&System65Silt::i_ldyzpx,&System65Silt::i_ldazpx,&System65Silt::i_ldxzpy,nullptr                ,&System65Silt::i_clv   ,&System65Silt::i_ldaaby,&System65Silt::i_tsx   ,nullptr                ,&System65Silt::i_ldyabx,&System65Silt::i_ldaabx,&System65Silt::i_ldxaby,nullptr                , // B0h
+		   &System65Silt::i_cpyimm,&System65Silt::i_cmpinx,nullptr                ,nullptr                ,&System65Silt::i_cpyzpg,&System65Silt::i_cmpzpg,&System65Silt::i_deczpg,nullptr                ,&System65Silt::i_iny   ,&System65Silt::i_cmpimm,&System65Silt::i_dex   ,nullptr                ,&System65Silt::i_cpyabs,&System65Silt::i_cmpabs,&System65Silt::i_decabs,nullptr                , // C0h
+		   &System65Silt::i_bne   ,&System65Silt::i_cmpiny,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_cmpzpx,&System65Silt::i_deczpx,nullptr                ,&System65Silt::i_cld   ,&System65Silt::i_cmpaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_cmpabx,&System65Silt::i_decabx,nullptr                , // D0h
+		   &System65Silt::i_cpximm,&System65Silt::i_sbcinx,nullptr                ,nullptr                ,&System65Silt::i_cpxzpg,&System65Silt::i_sbczpg,&System65Silt::i_inczpg,nullptr                ,&System65Silt::i_inx   ,&System65Silt::i_sbcimm,&System65Silt::i_nop   ,nullptr                ,&System65Silt::i_cpxabs,&System65Silt::i_sbcabs,&System65Silt::i_incabs,nullptr                , // E0h
+		   &System65Silt::i_beq   ,&System65Silt::i_sbciny,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_sbczpx,&System65Silt::i_inczpx,nullptr                ,&System65Silt::i_sed   ,&System65Silt::i_sbcaby,nullptr                ,nullptr                ,nullptr                ,&System65Silt::i_sbcabx,&System65Silt::i_incabx,nullptr                  // F0h
 	};
 
+	const uint8_t *start = in;
+	const uint8_t *last = in;
 	bool stop = false;
 	int size = 0;
+	cyclecount = 0;
+	m_BlockEnd.count = 0;
+	AnalyzeFlags(in);
 
-	while (!stop)
+	while (!stop) {
+		if (opcodeTable[*in] == nullptr) {
+			// Undocumented opcode; end the block in front of it, so at least
+			// the code up to here runs
+			uint16_t pc = (uint16_t)(in - m_CompileMemory.data());
+			if (in == start) {
+				char msg[64];
+				snprintf(msg, sizeof(msg), "Silt can't compile opcode 0x%.2X @ $%.4X", *in, pc);
+				throw std::runtime_error(msg);
+			}
+			break;
+		}
+		last = in;
+		m_FlagsLive = m_FlagsLiveAfter[in - start];
 		size += (*this.*opcodeTable[*in])(in, out, cyclecount, stop);
 
+		if (in - start >= SILT_MAX_BLOCK_BYTES)
+			break;
+	}
+
+	// Fell off the end of the block, so carry on from the next instruction
+	if (!stop)
+		SetExit((uint16_t)(in - m_CompileMemory.data()));
+
+	// Count the cycles of the whole block at once
+	size += Emit(out, {
+		0x81, 0xED, // sub ebp,<imm:cyclecount>
+		(uint8_t)(cyclecount & 0xFF), (uint8_t)((cyclecount >> 8) & 0xFF),
+		(uint8_t)((cyclecount >> 16) & 0xFF), (uint8_t)(cyclecount >> 24)
+	});
+
+	// Exits going back to the last instruction or before it check the budget
+	uint16_t lastpc = (uint16_t)(last - m_CompileMemory.data());
+	uint16_t taken = m_BlockEnd.target[0];
+	if (m_BlockEnd.count == 1) {
+		size += Emit_Exit(out, size, taken, taken <= lastpc, m_BlockEnd.exits[0]);
+	} else if (m_BlockEnd.count == 2) {
+		uint8_t *none = NULL;
+		BlockExit unused;
+		int takensize = 3 + Emit_Exit(none, 0, taken, taken <= lastpc, unused);
+
+		size += Emit(out, {
+			0xF6, 0xC1, m_BlockEnd.flag,                 // test cl,<imm:flag>
+			(uint8_t)(m_BlockEnd.set ? 0x74 : 0x75),      // jz/jnz <not taken>
+			(uint8_t)takensize,
+			0x83, 0xED, m_BlockEnd.penalty               // sub ebp,<imm:penalty>
+		});
+		size += Emit_Exit(out, size, taken, taken <= lastpc, m_BlockEnd.exits[0]);
+		// not taken:
+		size += Emit_Exit(out, size, m_BlockEnd.target[1], false, m_BlockEnd.exits[1]);
+	}
+
+	guestsize = (int)(in - start);
 	return size;
 }
 
-void System65Silt::Execute(const NativeCode *code)
+void System65Silt::UnlinkBlock(uint16_t pc)
+{
+	IncomingMap::iterator iter = m_Incoming.find(pc);
+	if (iter == m_Incoming.end())
+		return;
+	for (size_t j = 0; j < iter->second.size(); j++) {
+		const ExitRef &ref = iter->second[j];
+		if (IsBlockValid(ref.block) && (ref.exit < m_Blocks[ref.block].exitcount) &&
+			(m_Blocks[ref.block].exits[ref.exit].target == pc))
+			Link(m_Blocks[ref.block], ref.exit, NULL);
+	}
+}
+
+void System65Silt::InvalidateBlock(uint16_t pc)
+{
+	if (!IsBlockValid(pc))
+		return;
+	SetBlockValid(pc, false);
+	UnlinkBlock(pc);
+	UnmarkCodePages(pc, m_Blocks[pc].guestsize);
+}
+
+void System65Silt::InvalidateCode(uint16_t addr)
+{
+	// A block's last instruction starts within SILT_MAX_BLOCK_BYTES of its
+	// first, so only blocks starting that far back can cover addr
+	unsigned int start = (addr >= SILT_MAX_BLOCK_BYTES + 2) ? addr - (SILT_MAX_BLOCK_BYTES + 2) : 0;
+	for (unsigned int pc = start; pc <= addr; pc++) {
+		if (IsBlockValid((uint16_t)pc) && (pc + m_Blocks[pc].guestsize > addr)) {
+			// Code that's being changed may not stay the same long enough
+			// to be worth translating again, so it has to get hot again
+			InvalidateBlock((uint16_t)pc);
+			m_BlockHits[pc] = 0;
+		}
+	}
+}
+
+bool System65Silt::MarkCodePages(uint16_t pc, int guestsize)
+{
+	bool marked = false;
+	unsigned int last = pc + guestsize - 1;
+	for (unsigned int addr = pc; addr <= last; addr++)
+		m_Context.codebytes[(addr & 0xFFFF) >> 5] |= 1u << (addr & 31);
+
+	for (unsigned int page = (pc >> 8); page <= (last >> 8); page++) {
+		uint8_t p = (uint8_t)page;
+		if (m_Context.codepages[p])
+			continue;
+		m_Context.codepages[p] = 1;
+		marked = true;
+
+		for (size_t i = 0; i < m_PageWriters[p].size(); i++)
+			InvalidateBlock(m_PageWriters[p][i]);
+		m_PageWriters[p].clear();
+	}
+	return marked;
+}
+
+void System65Silt::UnmarkCodePages(uint16_t pc, int guestsize)
 {
-	const uint8_t *native = code->ptr;
-	Registers *state = &m_Register;
+	unsigned int last = pc + guestsize - 1;
+	for (unsigned int addr = pc; addr <= last; addr++)
+		m_Context.codebytes[(addr & 0xFFFF) >> 5] &= ~(1u << (addr & 31));
 
-	__asm {
-		// save all of the registers
-		pushad
+	// Blocks can overlap, so any still valid that cover these bytes mark
+	// them again; as in InvalidateCode(), only blocks starting up to
+	// SILT_MAX_BLOCK_BYTES back can reach them
+	unsigned int start = (pc >= SILT_MAX_BLOCK_BYTES + 2) ? pc - (SILT_MAX_BLOCK_BYTES + 2) : 0;
+	for (unsigned int other = start; (other <= last) && (other <= 0xFFFF); other++) {
+		if (IsBlockValid((uint16_t)other) && (other + m_Blocks[other].guestsize > pc)) {
+			unsigned int otherlast = other + m_Blocks[other].guestsize - 1;
+			for (unsigned int addr = other; addr <= otherlast; addr++)
+				m_Context.codebytes[(addr & 0xFFFF) >> 5] |= 1u << (addr & 31);
+		}
+	}
 
-		// Load the VM state
-		mov edx, state
-		mov di, [edx]Registers.pc
-		mov al, [edx]Registers.a
-		mov ah, [edx]Registers.s
-		mov bl, [edx]Registers.x
-		mov bh, [edx]Registers.y
-		mov cl, [edx]Registers.p
+	// A page that's marked never has blocks in m_PageWriters, so there are
+	// none to fix up when it's unmarked
+	for (unsigned int page = (pc >> 8); page <= (last >> 8); page++) {
+		uint8_t p = (uint8_t)page;
+		const uint32_t *words = &m_Context.codebytes[p * (0x100 / 32)];
+		bool code = false;
+		for (unsigned int i = 0; i < 0x100 / 32; i++)
+			code = code || (words[i] != 0);
+		if (!code)
+			m_Context.codepages[p] = 0;
+	}
+}
+
+void System65Silt::Execute(const NativeCode *code, int budget)
+{
+	m_Arena.Seal();
+	int left = reinterpret_cast<EntryFunc>(m_Entry)(&m_Register, code->ptr, budget);
+	m_CycleCount += budget - left;
+	m_TickCycles += budget - left;
 
-		// Begin execution
-		call native
+	// The block stopped after writing over translated code
+	if (m_Context.codewrite != SILT_NO_CODE_WRITE) {
+		InvalidateCode((uint16_t)m_Context.codewrite);
+		m_Context.codewrite = SILT_NO_CODE_WRITE;
+	}
+}
+
+void System65Silt::Dispatch(int budget)
+{
+	if (m_InterruptPending.load(std::memory_order_relaxed) && HandleInterrupt())
+		return;
 
-		// Save VM state
-		mov edx, state
-		mov [edx]Registers.pc, di
-		mov [edx]Registers.a, al
-		mov [edx]Registers.s, ah
-		mov [edx]Registers.x, bl
-		mov [edx]Registers.y, bh
-		mov [edx]Registers.p, cl
+	if (m_CompiledReady)
+		InstallCompiled();
 
-		// pop all registers back
-		popad
+	// check to see if the compiled code already exists in our cache, and
+	// run it, and whatever it's chained to
+	uint16_t pc = m_Register.pc;
+	if (IsBlockValid(pc)) {
+		Execute(&m_Blocks[pc], budget);
+		return;
 	}
-}
\ No newline at end of file
+
+	// Otherwise it's interpreted, until it's hot enough to be worth
+	// translating and the compiler thread has got to it
+	if (m_BlockHits[pc] < SILT_HOT_THRESHOLD)
+		m_BlockHits[pc]++;
+	else if (!IsBlockQueued(pc))
+		QueueCompile(pc);
+	Interpret();
+}
+
+bool System65Silt::HandleInterrupt(void)
+{
+	m_InterruptPending.exchange(false);
+	bool nmi = m_NMInterrupt.exchange(false);
+	m_Context.stopat.store(0, std::memory_order_relaxed);
+
+	// If I is set, an IRQ is skipped
+	if ((m_Register.p & 0x04) && !nmi)
+		return false;
+
+	Helper_Push(m_Register.pc);
+	Helper_Push((uint8_t)((m_Register.p & ~0x10) | 0x20));
+	m_Register.p |= 0x04;
+	m_Register.pc = Helper_PeekWord(nmi ? 0xFFFA : 0xFFFE);
+	m_CycleCount += 7;
+	m_TickCycles += 7;
+	return true;
+}
+
+int System65Silt::Emit_Exit(uint8_t *&out, int offset, uint16_t target, bool backward, BlockExit &exit)
+{
+	int size = Emit(out, {
+		0x66, 0xBF, (uint8_t)(target & 0xFF), (uint8_t)(target >> 8) // mov di,<imm:target>
+	});
+	if (backward) {
+		// The cmp is a relaxed load, as long as stopat is a plain int32_t
+		static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "stopat must be read as an int32_t");
+		static_assert(ATOMIC_INT_LOCK_FREE == 2, "stopat must be lock-free");
+		uint32_t stopat = offsetof(BlockContext, stopat);
+		size += Emit(out, {
+			0x41, 0x3B, 0xAD,           // cmp ebp,[r13+<imm:stopat>]
+			(uint8_t)(stopat & 0xFF), (uint8_t)(stopat >> 8), 0x00, 0x00,
+			0x7E, 0x05                  // jle <ret>
+		});
+	}
+
+	exit.target = target;
+	exit.patch = offset + size + 1;
+	return size + Emit(out, {
+		0xE9, 0x00, 0x00, 0x00, 0x00, // jmp <ret, or the block at target>
+		0xC3                          // ret
+	});
+}
+
+void System65Silt::Link(const NativeCode &code, int exit, const NativeCode *to)
+{
+	uint8_t *patch = code.ptr + code.exits[exit].patch;
+	int32_t rel = (to != NULL) ? (int32_t)(to->ptr - (patch + 4)) : 0;
+	uint8_t bytes[4] = {
+		(uint8_t)(rel & 0xFF), (uint8_t)((rel >> 8) & 0xFF),
+		(uint8_t)((rel >> 16) & 0xFF), (uint8_t)((rel >> 24) & 0xFF)
+	};
+	// Writing unseals the page, so skip stubs that already go there
+	if (memcmp(patch, bytes, sizeof(bytes)) != 0)
+		m_Arena.Write(patch, bytes, sizeof(bytes));
+}
+
+void System65Silt::LinkBlock(uint16_t pc)
+{
+	const NativeCode &code = m_Blocks[pc];
+
+	// Stubs are listed under their target even before there's a block there
+	for (int i = 0; i < code.exitcount; i++) {
+		uint16_t target = code.exits[i].target;
+		std::vector<ExitRef> &refs = m_Incoming[target];
+		bool listed = false;
+		for (size_t j = 0; (j < refs.size()) && !listed; j++)
+			listed = (refs[j].block == pc) && (refs[j].exit == i);
+		if (!listed)
+			refs.push_back({ pc, i });
+
+		if (IsBlockValid(target))
+			Link(code, i, &m_Blocks[target]);
+	}
+
+	// The lists also keep stubs of blocks that have since been replaced, so
+	// check that each one still goes here
+	IncomingMap::iterator iter = m_Incoming.find(pc);
+	if (iter == m_Incoming.end())
+		return;
+	for (size_t j = 0; j < iter->second.size(); j++) {
+		const ExitRef &ref = iter->second[j];
+		if (IsBlockValid(ref.block) && (ref.exit < m_Blocks[ref.block].exitcount) &&
+			(m_Blocks[ref.block].exits[ref.exit].target == pc))
+			Link(m_Blocks[ref.block], ref.exit, &code);
+	}
+}
+
+void System65Silt::EmitEntry(void)
+{
+	uint8_t *out = m_Entry;
+
+	// save the callee-saved registers that get used
+	*out++ = 0x53;                         // push rbx
+	*out++ = 0x55;                         // push rbp
+	*out++ = 0x41; *out++ = 0x54;          // push r12
+	*out++ = 0x41; *out++ = 0x55;          // push r13
+#ifdef _WIN64
+	*out++ = 0x57;                         // push rdi
+	*out++ = 0x56;                         // push rsi
+	*out++ = 0x48; *out++ = 0x89; *out++ = 0xCF; // mov rdi,rcx
+	*out++ = 0x48; *out++ = 0x89; *out++ = 0xD6; // mov rsi,rdx
+	*out++ = 0x44; *out++ = 0x89; *out++ = 0xC2; // mov edx,r8d
+#endif // _WIN64
+
+	// realign the stack, so blocks start out like any other function
+	*out++ = 0x48; *out++ = 0x83; *out++ = 0xEC; *out++ = 0x08; // sub rsp,8
+
+	// keep the state ptr across the call, and start off the budget
+	*out++ = 0x49; *out++ = 0x89; *out++ = 0xFC; // mov r12,rdi
+	*out++ = 0x89; *out++ = 0xD5;          // mov ebp,edx
+	*out++ = 0x48; *out++ = 0x89; *out++ = 0xFA; // mov rdx,rdi
+
+	// point R13 at the block context
+	*out++ = 0x49; *out++ = 0xBD;          // mov r13,<imm:&m_Context>
+	EmitPointer(out, &m_Context);
+
+	// Load the VM state; no REX prefixes, since AH and BH are involved
+	*out++ = 0x0F; *out++ = 0xB7; *out++ = 0x7A; *out++ = offsetof(Registers, pc); // movzx edi,WORD PTR [rdx+pc]
+	*out++ = 0x8A; *out++ = 0x42; *out++ = offsetof(Registers, a); // mov al,[rdx+a]
+	*out++ = 0x8A; *out++ = 0x62; *out++ = offsetof(Registers, s); // mov ah,[rdx+s]
+	*out++ = 0x8A; *out++ = 0x5A; *out++ = offsetof(Registers, x); // mov bl,[rdx+x]
+	*out++ = 0x8A; *out++ = 0x7A; *out++ = offsetof(Registers, y); // mov bh,[rdx+y]
+	*out++ = 0x8A; *out++ = 0x4A; *out++ = offsetof(Registers, p); // mov cl,[rdx+p]
+
+	// Begin execution
+	*out++ = 0xFF; *out++ = 0xD6;          // call rsi
+
+	// Save VM state
+	*out++ = 0x4C; *out++ = 0x89; *out++ = 0xE2; // mov rdx,r12
+	*out++ = 0x66; *out++ = 0x89; *out++ = 0x7A; *out++ = offsetof(Registers, pc); // mov [rdx+pc],di
+	*out++ = 0x88; *out++ = 0x42; *out++ = offsetof(Registers, a); // mov [rdx+a],al
+	*out++ = 0x88; *out++ = 0x62; *out++ = offsetof(Registers, s); // mov [rdx+s],ah
+	*out++ = 0x88; *out++ = 0x5A; *out++ = offsetof(Registers, x); // mov [rdx+x],bl
+	*out++ = 0x88; *out++ = 0x7A; *out++ = offsetof(Registers, y); // mov [rdx+y],bh
+	*out++ = 0x88; *out++ = 0x4A; *out++ = offsetof(Registers, p); // mov [rdx+p],cl
+	*out++ = 0x89; *out++ = 0xE8;          // mov eax,ebp
+
+	// pop all registers back
+	*out++ = 0x48; *out++ = 0x83; *out++ = 0xC4; *out++ = 0x08; // add rsp,8
+#ifdef _WIN64
+	*out++ = 0x5E;                         // pop rsi
+	*out++ = 0x5F;                         // pop rdi
+#endif // _WIN64
+	*out++ = 0x41; *out++ = 0x5D;          // pop r13
+	*out++ = 0x41; *out++ = 0x5C;          // pop r12
+	*out++ = 0x5D;                         // pop rbp
+	*out++ = 0x5B;                         // pop rbx
+	*out++ = 0xC3;                         // ret
+
+	assert((size_t)(out - m_Entry) <= m_EntrySize);
+}
+
+void System65Silt::FlushCache(void)
+{
+	// Anything in the works was translated for the cache as it was
+	DropCompiles();
+
+	// The entries in m_Blocks are left to be overwritten
+	std::fill(m_BlockValid.begin(), m_BlockValid.end(), 0);
+	m_Incoming.clear();
+	memset(m_Context.codepages, 0, sizeof(m_Context.codepages));
+	memset(m_Context.codebytes, 0, sizeof(m_Context.codebytes));
+	for (unsigned int i = 0; i < 0x100; i++)
+		m_PageWriters[i].clear();
+	m_Arena.Reset();
+}
+
+void System65Silt::EmitPointer(uint8_t *&out, const void *ptr)
+{
+	uint64_t val = (uint64_t)(uintptr_t)ptr;
+	for (int i = 0; i < 8; i++)
+		*out++ = (uint8_t)(val >> (i * 8));
+}
+
+int System65Silt::Emit(uint8_t *&out, std::initializer_list<uint8_t> code)
+{
+	if (out != NULL) {
+		memcpy(out, code.begin(), code.size());
+		out += code.size();
+	}
+	return (int)code.size();
+}
+
+int System65Silt::Emit_LoadPointer(uint8_t *&out, const void *ptr)
+{
+	if (out != NULL) {
+		*out++ = 0x48; // mov rsi,<imm:ptr>
+		*out++ = 0xBE;
+		EmitPointer(out, ptr);
+	}
+	return 10;
+}
@@ -1,18 +1,38 @@
 #ifndef SYSTEM65SILT_CPP
 #define SYSTEM65SILT_CPP
 
-#include <windows.h>
+#ifdef WIN32
+	#include <windows.h>
+#endif // WIN32
 
 // Standard libs
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
-#include <map>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-// Project headers
-#include "Silt_AsmHelpers.h"
+// Project libs
+#include "System65Silt/CodeArena.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define SILT_HOST_X64 //!< Defined when the host can run the code Silt emits
+#endif
+
+#define SILT_MAX_BLOCK_BYTES 256 //!< Most bytes of guest code translated into one block
+#define SILT_CODE_CACHE_SIZE (16 * 1024 * 1024) //!< Bytes of host memory set aside for translated code
+#define SILT_NO_CODE_WRITE 0xFFFFFFFF //!< Value of BlockContext::codewrite when no block has written to translated code
+#define SILT_HOT_THRESHOLD 16 //!< Times a block is interpreted before it's queued for translation; at most 255
 
 /** \file System65Silt.hpp
  * Interface for the \ref System65Silt class.
@@ -36,6 +56,97 @@
  * y  <-> BH
  * p  <-> CL
  * ip <-> DI
+ *
+ * The emitted code is x86-64. Blocks are plain functions with no arguments
+ * that keep the VM registers in the host registers above; RDX, RSI and R8
+ * are scratch, and R9 is scratch for the code checking stores. EBP holds
+ * the cycle budget, counting down as blocks run, and R13 points at
+ * m_Context, which has a table of the N and Z flags for each byte value
+ * and the pages holding translated code. Because AH and BH can't be
+ * encoded in an instruction with a REX prefix, anything touching them only
+ * uses the legacy registers. Guest memory is reached by embedding 64-bit
+ * pointers into it (or into the stack page) as immediates, so blocks are
+ * only valid for this machine's memory.
+ *
+ * Every documented NMOS 6502 instruction is translated, with the same flags
+ * and cycle counts as the real chip, including the page crossing penalties
+ * and the <tt>JMP ($xxFF)</tt> bug. <tt>p</tt> is kept in CL exactly as it
+ * would be pushed, so flags are worked out from the host's flags after each
+ * instruction. Each block is scanned by AnalyzeFlags() before it's
+ * translated, and an N, V, Z or C result that is set again before anything
+ * could read it isn't worked out at all. Decimal mode ADC and SBC are left
+ * to \ref Helper_DecimalADC and \ref Helper_DecimalSBC, which the block
+ * calls when D is set.
+ *
+ * A block runs from its first instruction up to the first jump, branch,
+ * return or interrupt, or up to SILT_MAX_BLOCK_BYTES of guest code.
+ *
+ * Not every block is worth translating, since a lot of code only ever runs
+ * once. New code is run by Interpret() instead, a block at a time, on the
+ * same memory and registers, and m_BlockHits counts how many times each
+ * address has been started at. Once that reaches SILT_HOT_THRESHOLD the
+ * block is queued for translation, and from then on it runs natively.
+ * Control goes between the two at block boundaries: a translated block
+ * whose exit has nothing to link to returns, and whatever is there is
+ * interpreted. Writes from the interpreter go through Helper_Poke(), so
+ * they catch self-modifying code like Poke() does, and code that has been
+ * thrown away for being written over starts counting again from 0.
+ *
+ * Translation happens on a compiler thread of its own, started by the
+ * constructor, so the emulation never waits on it; a queued block carries
+ * on being interpreted until it's done. The compiler thread only works
+ * from copies of the guest code and of m_Context.codepages taken when the
+ * block was queued, and writes the code into a buffer of its own.
+ * Dispatch() installs finished blocks between blocks, on the emulating
+ * thread: the code is copied into m_Arena and the block becomes runnable
+ * by setting its bit in m_BlockValid, so no half-installed block can ever
+ * be reached. A block whose guest code changed while it was being
+ * translated, or that writes without checking to a page that has code on
+ * it by then, is dropped instead, and queued again the next time it's run.
+ * Since when a block stops being interpreted depends on how fast the
+ * compiler thread is, how far Tick() overruns its cycle count can differ
+ * from run to run, though what the guest does never does.
+ *
+ * A block that ends by going to a known address (a jump, a JSR, a branch or
+ * just the next instruction) does so through an exit stub: <tt>mov
+ * di,target</tt> then a <tt>jmp</tt> that starts out going to a
+ * <tt>ret</tt> right after it. Once there's a block at the target, the
+ * <tt>jmp</tt> is patched to go straight to it, so a loop runs without
+ * coming back to Tick(). A branch gets a stub for each way it can go. Every
+ * cycle through the blocks takes at least one exit back to the same address
+ * or an earlier one, so only those exits check the budget; they return once
+ * it has come down to m_Context.stopat, which is normally 0 but is raised
+ * past any budget while an interrupt is pending. RTS, RTI, BRK and indirect
+ * jumps always return, to have their target looked up.
+ *
+ * Self-modifying code is caught a page at a time. Every page a block was
+ * translated from is marked in m_Context.codepages, and its bytes in
+ * m_Context.codebytes; a write to a marked byte throws away the blocks with
+ * code at that address, unlinking the stubs going to them. Whether a store
+ * has to be checked is worked out when it's translated: one that can only
+ * reach unmarked pages is a plain <tt>mov</tt>, and its block is listed in
+ * m_PageWriters against those pages, so that marking one of them later
+ * throws the block away to be translated with the check. Stores through a
+ * pointer are always checked. A checked store that would change a marked
+ * byte leaves the address in m_Context.codewrite and returns from the block
+ * straight after the instruction, so nothing stale runs; Execute() then
+ * invalidates the code there. Poke() does the same for writes from outside.
+ * Pushes aren't checked, so code on the stack page isn't supported.
+ *
+ * Blocks are entered through a trampoline emitted by EmitEntry() when the
+ * machine is created, which saves the host's callee-saved registers, loads
+ * the VM registers from \ref Registers, calls the block and stores them
+ * back. It follows the System V calling convention, or the Windows x64 one
+ * when built for Windows. On any other host the constructor throws.
+ *
+ * Blocks are found by a direct lookup of the guest PC in m_Blocks, gated by
+ * the m_BlockValid bitmap, so throwing blocks away only has to clear bits.
+ * They are written one after another into a \ref CodeArena of
+ * SILT_CODE_CACHE_SIZE bytes, which is never writable and executable at
+ * once; whatever was compiled since the last block ran is made executable
+ * in one go just before the next one runs. A block that has gone stale
+ * keeps its space until the arena fills up, at which point the whole cache
+ * is flushed and compiling starts over.
  */
 
 class System65Silt
@@ -55,10 +166,14 @@ public:
 		*/
 	~System65Silt();
 
-	/** Runs 1 instruction of the CPU and returns.
+	/** Runs 1 block of the CPU and returns.
 		*
-		* \note This is currently not a cycle-accurate emulation; an executed
-		* instruction may take multiple cycles to run
+		* A pending interrupt is taken instead, if it can be. The cycles run
+		* count toward the next Tick(unsigned int).
+		*
+		* \note This is currently not a cycle-accurate emulation; a block is
+		* several instructions, and may run on into the blocks chained to it
+		* until it next jumps backwards
 		*/
 	void Tick(void);
 
@@ -67,8 +182,13 @@ public:
 		* \param[in] cycleLimit Number of consecutive cycles to run before stopping
 		*
 		* \note A count of less than 1 returns immediately.
-		* \note Because the dynarec will run multiple instructions at once, it
-		* is difficult to run an exact number of emulated cycles each time.
+		* \note As with \ref System65, the executed cycle count before
+		* returning will be <em>at least</em> \c cycleLimit, and any extra
+		* cycles are taken off the next call's count. Blocks only stop at a
+		* backward jump, so the extra can be up to a loop's worth of cycles.
+		* \note An interrupt raised with Interrupt() is taken before the next
+		* block runs, and makes a running block return at its next backward
+		* jump.
 		*/
 	void Tick(unsigned int cycleLimit);
 
@@ -90,6 +210,12 @@ public:
 	/** Returns the contents of the program counter register. */
 	uint16_t GetRegister_PC(void) { return m_Register.pc; }
 
+	/** Returns the number of cycles run since the last ResetCycleCount(). */
+	unsigned int GetCycleCount(void) { return m_CycleCount; }
+
+	/** Resets the cycle counter. */
+	void ResetCycleCount(void) { m_CycleCount = 0; }
+
 	/** Returns the byte at the given address in the vm's memory.
 		*
 		* \param[in] addr Address to retrieve the byte from
@@ -170,6 +296,8 @@ public:
 		* \note Although the <tt>RESET</tt> signal is considered an interrupt
 		* from a technical standpoint, it is currently handled independent of
 		* this method.
+		* \note This may be called from another thread while Tick() runs; a
+		* running block returns at its next backward jump to take it.
 		*
 		* \see Reset
 		*/
@@ -272,21 +400,152 @@ private:
 
 	Registers m_Register; //!< Registers for this emulated CPU
 
+	unsigned int m_CycleCount; //!< Tracks the number of cycles executed so far.
+	unsigned int m_TickCycles; //!< Cycles run toward the next Tick(unsigned int), starting with what the last one overran
+
+	std::atomic<bool> m_InterruptPending; //!< Whether an interrupt is to be taken before the next block; may be set from another thread \see Interrupt
+	std::atomic<bool> m_NMInterrupt; //!< Whether the pending interrupt is non-maskable
+
+	/** Host registers, numbered as in the x86 ModRM byte. */
+	enum HostReg {
+		REG_AL = 0, //!< a
+		REG_CL = 1, //!< p
+		REG_DL = 2, //!< Scratch
+		REG_BL = 3, //!< x
+		REG_AH = 4, //!< s
+		REG_DH = 6, //!< Scratch
+		REG_BH = 7  //!< y
+	};
+
+	/** Memory addressing modes an instruction can take its operand from. */
+	enum AddrMode {
+		AM_IMM, //!< Immediate
+		AM_ZPG, //!< Zeropage
+		AM_ZPX, //!< Zeropage, X-indexed
+		AM_ZPY, //!< Zeropage, Y-indexed
+		AM_ABS, //!< Absolute
+		AM_ABX, //!< Absolute, X-indexed
+		AM_ABY, //!< Absolute, Y-indexed
+		AM_INX, //!< Indexed indirect
+		AM_INY  //!< Indirect indexed
+	};
+
+	/** Flags in <tt>p</tt> that are tracked for liveness. */
+	enum FlagMask {
+		FLAG_C = 0x01, //!< Carry
+		FLAG_Z = 0x02, //!< Zero
+		FLAG_V = 0x40, //!< Overflow
+		FLAG_N = 0x80, //!< Negative
+		FLAGS_TRACKED = 0xC3 //!< All of the above
+	};
+
+	/** An exit stub of a block, which goes to a known guest address. */
+	struct BlockExit {
+		uint16_t target; //!< Guest address the exit goes to
+		int patch; //!< Offset in the block of the rel32 of the stub's <tt>jmp</tt>
+	};
+
 	/** Structure representing a chunk of native translated code.
 	 */
 	struct NativeCode {
 		uint8_t *ptr; //!< Pointer to a buffer containing the native code
 		int size; //!< Size of the buffer for the native code
-		int cyclecount; //!< Number of emulated instructions in this code block
+		int cyclecount; //!< Number of emulated cycles in this code block, not counting page crossings or taken branches
+		int guestsize; //!< Number of bytes of guest code the block was translated from
+		int exitcount; //!< Number of entries used in <tt>exits</tt>
+		BlockExit exits[2]; //!< Exit stubs; for a branch, taken then not taken
+	};
+
+	/** An exit stub, by the block it's in. */
+	struct ExitRef {
+		uint16_t block; //!< Address of the block
+		int exit; //!< Index into the block's NativeCode::exits
 	};
 
+	/** How the block being compiled ends, as set by the instruction ending it.
+	 *
+	 * Instructions that go somewhere unknown until run time set DI
+	 * themselves and leave <tt>count</tt> at 0.
+	 */
+	struct {
+		int count; //!< Number of exits to known addresses: 0, 1, or 2 for a branch
+		uint16_t target[2]; //!< Where each exit goes; for a branch, taken then not taken
+		uint8_t flag; //!< Flag tested by a branch
+		bool set; //!< Whether the branch is taken when the flag is set
+		uint8_t penalty; //!< Cycles a branch takes when it's taken
+		BlockExit exits[2]; //!< The stubs emitted for the exits
+	} m_BlockEnd;
+
+	uint8_t m_FlagsLiveAfter[SILT_MAX_BLOCK_BYTES + 3]; //!< Flags read after each instruction of the block being compiled, by offset from its start
+	uint8_t m_FlagsLive; //!< Flags read after the instruction being compiled; the others needn't be worked out
+
 	uint8_t *m_Memory; //!< Pointer to system memory for this system
 
 	uint16_t m_StackBase; //!< Address that the stack is based at in internal memory
 	uint8_t *m_EffectiveStackBase; //!< Address that the stack is based at in real memory
 
-	typedef std::map<uint16_t, NativeCode> CacheMap; //!< Typedef for the native code cache map
-	CacheMap m_Cache; //!< The native code cache map declaration
+	std::vector<NativeCode> m_Blocks; //!< Block compiled at each guest address, if any; 0x10000 entries
+	std::vector<uint32_t> m_BlockValid; //!< Bitmap of the entries in m_Blocks that can be run; bit (pc & 31) of word (pc >> 5)
+	std::vector<uint8_t> m_BlockHits; //!< Times a block has been interpreted at each guest address, up to SILT_HOT_THRESHOLD; 0x10000 entries
+
+	typedef std::unordered_map<uint16_t, std::vector<ExitRef>> IncomingMap; //!< Typedef for the exit stub index
+	IncomingMap m_Incoming; //!< Exit stubs going to each address, linked or not, so they can be linked and unlinked
+
+	/** Data the blocks reach through R13. */
+	struct BlockContext {
+		uint8_t nz[0x100]; //!< N and Z flags for each byte value, as they go in p
+		uint8_t codepages[0x100]; //!< Nonzero for each page that has translated code on it
+		uint32_t codebytes[0x10000 / 32]; //!< Bitmap of the bytes translated code came from; bit (addr & 31) of word (addr >> 5)
+		uint32_t codewrite; //!< Address of translated code a block wrote to, or SILT_NO_CODE_WRITE
+		std::atomic<int32_t> stopat; //!< Budget at or below which backward exits return; INT_MAX while an interrupt is pending. Blocks read it with a plain cmp
+	} m_Context;
+
+	std::vector<uint16_t> m_PageWriters[0x100]; //!< Blocks with unchecked stores that can reach each page
+
+	/** A block for the compiler thread to translate, and what it made of it. */
+	struct CompileJob {
+		uint16_t pc; //!< Address of the block
+		uint8_t guest[SILT_MAX_BLOCK_BYTES + 2]; //!< Guest code from <tt>pc</tt> on, as it was when the block was queued
+		uint8_t codepages[0x100]; //!< m_Context.codepages as it was when the block was queued
+		NativeCode code; //!< The translated block; <tt>ptr</tt> isn't set until it's installed
+		std::vector<uint8_t> native; //!< The translated code, or empty if the block couldn't be translated
+		std::vector<uint8_t> writepages; //!< Pages the block has unchecked stores to
+	};
+
+	// Only touched by the compiler thread
+	std::vector<uint8_t> m_CompileMemory; //!< Copy of the guest code being translated, at its own address; 0x10000 + SILT_MAX_BLOCK_BYTES + 2 entries
+	uint8_t m_CompilePages[0x100]; //!< m_Context.codepages as the block being translated sees it, with its own pages marked
+	std::vector<uint8_t> m_CompileWrites; //!< Pages the block being translated has unchecked stores to
+
+	std::vector<uint32_t> m_BlockQueued; //!< Bitmap of the addresses queued for the compiler thread, laid out like m_BlockValid
+
+	std::thread m_Compiler; //!< Compiler thread, running CompilerMain()
+	std::mutex m_CompileLock; //!< Guards the members below
+	std::condition_variable m_CompileWake; //!< Signalled when a block is queued or translated, or the compiler thread is to stop
+	std::deque<CompileJob> m_CompileQueue; //!< Blocks waiting to be translated
+	std::vector<CompileJob> m_Compiled; //!< Blocks translated and waiting to be installed
+	bool m_Compiling; //!< Whether the compiler thread is translating a block
+	bool m_CompilerStop; //!< Tells the compiler thread to stop
+	std::atomic<bool> m_CompiledReady; //!< Whether m_Compiled has anything in it, so Dispatch() can check without the lock
+
+	CodeArena m_Arena; //!< Memory the blocks in m_Blocks are written to and run from
+	CodeArena m_EntryArena; //!< Memory holding the entry trampoline, which outlives any flush
+
+	/** Signature of the entry trampoline.
+	 *
+	 * \param[in,out] state VM registers to load before, and store after,
+	 * running the block
+	 * \param[in] code Block to run
+	 * \param[in] budget Cycles to run; chained blocks keep running until
+	 * at least this many have been
+	 *
+	 * \return What's left of the budget, which is negative if it was
+	 * overrun
+	 */
+	typedef int (*EntryFunc)(Registers *state, const uint8_t *code, int budget);
+
+	uint8_t *m_Entry; //!< Entry trampoline, in m_EntryArena
+	size_t m_EntrySize; //!< Size of the buffer at m_Entry
 
 	/** Operator for accessing memory like an array
 	 */
@@ -295,19 +554,447 @@ private:
 		return m_Memory[offs];
 	}
 
-	/** Translates the target code into native and caches the result.
+	/** Queues the block at <tt>pc</tt> for the compiler thread. */
+	void QueueCompile(uint16_t pc);
+
+	/** Body of the compiler thread, which translates queued blocks until
+	 * it's told to stop.
+	 */
+	void CompilerMain(void);
+
+	/** Translates a queued block, on the compiler thread.
+	 *
+	 * \param[in,out] job Block to translate; receives the code
+	 *
+	 * \throws std::runtime_error if the block starts with an undocumented
+	 * opcode
+	 */
+	void Translate(CompileJob &job);
+
+	/** Installs every block the compiler thread has finished. */
+	void InstallCompiled(void);
+
+	/** Copies a translated block into m_Arena and links it in, unless it's
+	 * gone stale while it was being translated.
+	 *
+	 * \param[in] job Translated block
+	 *
+	 * \return false if the block was dropped
+	 *
+	 * \throws std::bad_alloc if the block doesn't fit even in an empty arena
+	 */
+	bool Install(const CompileJob &job);
+
+	/** Throws away every queued and translated block, waiting for the
+	 * compiler thread to finish the one it's on.
 	 */
-	const NativeCode *Compile(uint16_t iptr);
+	void DropCompiles(void);
+
+	/** Returns whether the block at <tt>pc</tt> is queued for the compiler
+	 * thread.
+	 */
+	bool IsBlockQueued(uint16_t pc) const
+	{
+		return (m_BlockQueued[pc >> 5] & (1u << (pc & 31))) != 0;
+	}
+
+	/** Marks the block at <tt>pc</tt> as queued, or not. */
+	void SetBlockQueued(uint16_t pc, bool queued)
+	{
+		if (queued)
+			m_BlockQueued[pc >> 5] |= 1u << (pc & 31);
+		else
+			m_BlockQueued[pc >> 5] &= ~(1u << (pc & 31));
+	}
 
 	/** Performs the actual recompilation of code
+	 *
+	 * Only runs on the compiler thread.
+	 *
+	 * \param[in] in Guest code to translate, in m_CompileMemory
+	 * \param[in] out Where to emit the native code, or NULL to only size it
+	 * \param[out] cyclecount Receives the cycle count of the block
+	 * \param[out] guestsize Receives the number of bytes of guest code
+	 * translated
+	 *
+	 * \return Size of the native code
+	 */
+	int CompileBlock(const uint8_t *in, uint8_t *out, int &cyclecount, int &guestsize);
+
+	/** Works out which flags each instruction of a block sets that are read
+	 * before they're set again, into m_FlagsLiveAfter.
+	 *
+	 * Every flag is live at the end of the block, and after a store that
+	 * could leave it early, since the code after that can't be seen.
+	 *
+	 * \param[in] in First instruction of the block
+	 */
+	void AnalyzeFlags(const uint8_t *in);
+
+	/** Returns whether any of <tt>flags</tt> is read after the instruction
+	 * being compiled.
+	 */
+	bool IsLive(uint8_t flags) const
+	{
+		return (m_FlagsLive & flags) != 0;
+	}
+
+	/** Runs the cached native code, and any blocks chained to it.
+	 *
+	 * \param[in] code Block to start at
+	 * \param[in] budget Cycles to run before returning at a backward exit
+	 */
+	void Execute(const NativeCode *code, int budget);
+
+	/** Interprets the block at the PC, without translating it.
+	 *
+	 * The block ends where CompileBlock() would end it, and its cycles are
+	 * counted as Execute() counts them.
+	 *
+	 * \throws std::runtime_error if the block starts with an undocumented
+	 * opcode
+	 */
+	void Interpret(void);
+
+	/** Sets N and Z in <tt>p</tt> from a result, for Interpret(). */
+	void SetNZ(uint8_t val);
+
+	/** Sets N, Z and C in <tt>p</tt> as CMP, CPX and CPY do, for
+	 * Interpret().
+	 *
+	 * \param[in] reg Value of the register compared
+	 * \param[in] val Value it's compared with
+	 */
+	void Compare(uint8_t reg, uint8_t val);
+
+	/** Takes a pending interrupt, or runs the block at the PC, interpreting
+	 * it unless it's hot enough to be translated.
+	 *
+	 * \param[in] budget Cycles to run before returning at a backward exit
+	 */
+	void Dispatch(int budget);
+
+	/** Takes the pending interrupt, pushing the PC and P and going through
+	 * the NMI or IRQ vector.
+	 *
+	 * \return false if it was an IRQ with I set, which is dropped
+	 */
+	bool HandleInterrupt(void);
+
+	/** Sets the block being compiled to end with a jump to <tt>target</tt>. */
+	void SetExit(uint16_t target)
+	{
+		m_BlockEnd.count = 1;
+		m_BlockEnd.target[0] = target;
+	}
+
+	/** Emits an exit stub going to <tt>target</tt>.
+	 *
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] offset Offset of the stub in the block
+	 * \param[in] target Guest address the exit goes to
+	 * \param[in] backward Whether to check the budget first
+	 * \param[out] exit Receives the target and where to patch the stub
+	 *
+	 * \return Size of the emitted code
+	 */
+	static int Emit_Exit(uint8_t *&out, int offset, uint16_t target, bool backward, BlockExit &exit);
+
+	/** Points an exit stub at a block, or back at its <tt>ret</tt>.
+	 *
+	 * \param[in] code Block the stub is in
+	 * \param[in] exit Index of the stub in NativeCode::exits
+	 * \param[in] to Block to go to, or NULL to unlink the stub
+	 */
+	void Link(const NativeCode &code, int exit, const NativeCode *to);
+
+	/** Links a newly compiled block to the blocks it goes to, and the blocks
+	 * going to it to it.
+	 */
+	void LinkBlock(uint16_t pc);
+
+	/** Points every stub going to <tt>pc</tt> back at its <tt>ret</tt>. */
+	void UnlinkBlock(uint16_t pc);
+
+	/** Throws away the block at <tt>pc</tt>, if there is one, unlinks the
+	 * stubs going to it and unmarks its code. \see UnmarkCodePages
+	 */
+	void InvalidateBlock(uint16_t pc);
+
+	/** Throws away every block translated from the byte at <tt>addr</tt>,
+	 * after it's been written to.
+	 */
+	void InvalidateCode(uint16_t addr);
+
+	/** Marks a block's code in m_Context.codebytes, and the pages holding
+	 * it in m_Context.codepages.
+	 *
+	 * The blocks in m_PageWriters for each page that wasn't marked before
+	 * are thrown away, since their stores to it aren't checked.
+	 *
+	 * \param[in] pc Address of the block
+	 * \param[in] guestsize Number of bytes of guest code in the block
+	 *
+	 * \return true if any page wasn't marked before
+	 */
+	bool MarkCodePages(uint16_t pc, int guestsize);
+
+	/** Unmarks the code of a block that's been thrown away.
+	 *
+	 * Its bytes are cleared in m_Context.codebytes, then those of the
+	 * blocks still valid that share them are put back. Each of its pages
+	 * with no code bytes left is cleared in m_Context.codepages, so stores
+	 * to it stop taking the bitmap check, and blocks translated from then on
+	 * can store to it unchecked through m_PageWriters again.
+	 *
+	 * \param[in] pc Address of the block
+	 * \param[in] guestsize Number of bytes of guest code in the block
 	 */
-	int CompileBlock(const uint8_t *in, uint8_t *out);
+	void UnmarkCodePages(uint16_t pc, int guestsize);
 
-	/** Runs the cached native code.
+	/** Returns whether <tt>addr</tt> is in m_Context.codebytes. */
+	bool IsCodeByte(uint16_t addr) const
+	{
+		return (m_Context.codebytes[addr >> 5] & (1u << (addr & 31))) != 0;
+	}
+
+	/** Emits the entry trampoline into m_Entry. */
+	void EmitEntry(void);
+
+	/** Returns whether there's a block for <tt>pc</tt> that can be run. */
+	bool IsBlockValid(uint16_t pc) const
+	{
+		return (m_BlockValid[pc >> 5] & (1u << (pc & 31))) != 0;
+	}
+
+	/** Marks the block at <tt>pc</tt> as runnable, or not. */
+	void SetBlockValid(uint16_t pc, bool valid)
+	{
+		if (valid)
+			m_BlockValid[pc >> 5] |= 1u << (pc & 31);
+		else
+			m_BlockValid[pc >> 5] &= ~(1u << (pc & 31));
+	}
+
+	/** Throws away every compiled block, emptying m_Arena, and everything
+	 * queued for the compiler thread.
+	 */
+	void FlushCache(void);
+
+	/** Writes a 64-bit pointer into the code stream as an immediate. */
+	static void EmitPointer(uint8_t *&out, const void *ptr);
+
+	/** Emits native code.
+	 *
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] code Bytes to emit
+	 *
+	 * \return Size of the emitted code
+	 */
+	static int Emit(uint8_t *&out, std::initializer_list<uint8_t> code);
+
+	/** Emits <tt>mov rsi,ptr</tt>.
+	 *
+	 * \return Size of the emitted code
+	 */
+	static int Emit_LoadPointer(uint8_t *&out, const void *ptr);
+
+	/** Emits code pointing RSI+RDX at an absolute, indexed guest address.
+	 *
+	 * The index register is zero-extended into EDX. If adding it to
+	 * <tt>base</tt> can't pass <tt>$FFFF</tt>, RSI is loaded with a pointer
+	 * straight to <tt>base</tt>; otherwise the 16-bit sum is formed in DX so
+	 * that it wraps around like on the 6502.
+	 *
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] base Absolute address from the instruction
+	 * \param[in] index ModRM byte for <tt>movzx edx,reg8</tt>: 0xD3 for X
+	 * (BL) or 0xD7 for Y (BH)
+	 * \param[in] penalty Whether to take a cycle from EBP if the sum crosses
+	 * a page
+	 *
+	 * \return Size of the emitted code
+	 */
+	int Emit_AbsIndexed(uint8_t *&out, uint16_t base, uint8_t index, bool penalty);
+
+	/** Emits code pointing RSI+RDX at the operand of an instruction.
+	 *
+	 * \param[in] in Instruction
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] mode Addressing mode; anything but AM_IMM
+	 * \param[in] penalty Whether to take a cycle from EBP if indexing
+	 * crosses a page, as reads do
+	 *
+	 * \return Size of the emitted code
+	 */
+	int Emit_Address(const uint8_t *in, uint8_t *&out, AddrMode mode, bool penalty);
+
+	/** Emits code loading the operand of an instruction into DL.
+	 *
+	 * Page crossings are counted as for any read.
+	 *
+	 * \see Emit_Address
+	 */
+	int Emit_Operand(const uint8_t *in, uint8_t *&out, AddrMode mode);
+
+	/** Returns the size of an instruction with the given addressing mode. */
+	static int InstructionSize(AddrMode mode);
+
+	/** Works out the range of addresses an instruction could write to.
+	 *
+	 * \param[in] in Instruction
+	 * \param[in] mode Addressing mode of the write
+	 * \param[out] first Receives the lowest address
+	 * \param[out] last Receives the highest address, which can be past
+	 * $FFFF for an indexed write
+	 *
+	 * \return false for an indirect write, which can go anywhere
+	 */
+	static bool Helper_StoreRange(const uint8_t *in, AddrMode mode, unsigned int &first, unsigned int &last);
+
+	/** Checks whether a write from an instruction has to be checked for
+	 * landing on translated code, which it does if it can reach a page in
+	 * m_CompilePages, or goes through a pointer.
+	 *
+	 * \param[in] in Instruction
+	 * \param[in] mode Addressing mode of the write
+	 */
+	bool Helper_StoreChecked(const uint8_t *in, AddrMode mode);
+
+	/** Works out the addressing mode of an instruction that writes to
+	 * memory by address.
+	 *
+	 * \param[in] opcode Opcode of the instruction
+	 * \param[out] mode Receives the addressing mode of the write
+	 *
+	 * \return false if the instruction doesn't write to memory, or only
+	 * pushes
+	 */
+	static bool Helper_StoreMode(uint8_t opcode, AddrMode &mode);
+
+	/** Emits code copying the guest address of a write into R8D, if the
+	 * write is checked.
+	 *
+	 * Goes straight after Emit_Address, while RDX still holds what it
+	 * formed.
+	 *
+	 * \param[in] in Instruction doing the write
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] mode Addressing mode of the write
+	 *
+	 * \return Size of the emitted code
+	 *
+	 * \see Emit_StoreCheck
+	 */
+	int Emit_StoreAddress(const uint8_t *in, uint8_t *&out, AddrMode mode);
+
+	/** Emits the check after a write, if it's checked, or lists the pages
+	 * it can reach in m_CompileWrites if not.
+	 *
+	 * The check looks the address in R8D up in m_Context.codepages, then
+	 * in m_Context.codebytes; if it's translated code, the address goes in
+	 * m_Context.codewrite and the block returns at the next instruction.
+	 *
+	 * \param[in] in Instruction doing the write
+	 * \param[in,out] out Where to emit the code, or NULL to only size it
+	 * \param[in] mode Addressing mode of the write
+	 * \param[in] count Cycles of the block up to and including the
+	 * instruction
+	 *
+	 * \return Size of the emitted code
+	 */
+	int Emit_StoreCheck(const uint8_t *in, uint8_t *&out, AddrMode mode, int count);
+
+	/** Emits code setting N and Z in CL from EDX, which must be
+	 * zero-extended.
 	 *
-	 * \note Throws if the cache doesn't have a matching code block.
+	 * \return Size of the emitted code
 	 */
-	void Execute(const NativeCode *code);
+	static int Emit_UpdateNZ(uint8_t *&out);
+
+	/** Emits code setting N and Z in CL from an 8-bit register, unless
+	 * neither is live.
+	 *
+	 * \return Size of the emitted code
+	 */
+	int Emit_SetNZ(uint8_t *&out, HostReg reg);
+
+	/** Emits <tt>mov rsi,m_EffectiveStackBase</tt> and
+	 * <tt>movzx edx,ah</tt>, pointing RSI+RDX at the top of the stack.
+	 *
+	 * \return Size of the emitted code
+	 */
+	int Emit_StackPointer(uint8_t *&out);
+
+	/** Emits a call to a decimal mode helper.
+	 *
+	 * The helper is passed AL, DL and CL, and its result goes back into AL
+	 * and CL. Everything else the VM keeps in registers is preserved.
+	 *
+	 * \return Size of the emitted code
+	 */
+	static int Emit_CallDecimal(uint8_t *&out, uint16_t (*helper)(uint8_t a, uint8_t val, uint8_t p));
+
+	/** Emits a load into a register, setting N and Z. */
+	int Emit_Load(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles);
+
+	/** Emits a store from a register. */
+	int Emit_Store(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles);
+
+	/** Emits AND, EOR or ORA.
+	 *
+	 * \param[in] opcode x86 opcode of the <tt>op al,dl</tt> form: 0x20
+	 * (and), 0x30 (xor) or 0x08 (or)
+	 */
+	int Emit_Logical(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, uint8_t opcode, int cycles);
+
+	/** Emits the rest of BIT, once the operand is in DL. */
+	int Emit_BitTest(uint8_t *&out);
+
+	/** Emits ADC, or SBC if <tt>subtract</tt> is set. */
+	int Emit_AddSub(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, bool subtract, int cycles);
+
+	/** Emits CMP, CPX or CPY. */
+	int Emit_Compare(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, HostReg reg, int cycles);
+
+	/** Emits a shift, rotate, increment or decrement of a register or of
+	 * memory.
+	 *
+	 * \param[in] opcode x86 opcode: 0xD0 (shift or rotate by 1) or 0xFE
+	 * (inc/dec)
+	 * \param[in] op The operation, from the reg field of the ModRM byte:
+	 * 0 (inc/rol), 1 (dec), 2 (rcl), 3 (rcr), 4 (shl) or 5 (shr)
+	 * \param[in] reg Register to work on, or REG_DL for memory
+	 * \param[in] mode Addressing mode of the memory; ignored for a register
+	 */
+	int Emit_Modify(const uint8_t *&in, uint8_t *&out, int &count, AddrMode mode, uint8_t opcode, uint8_t op, HostReg reg, int cycles);
+
+	/** Emits an instruction that just runs a fixed piece of native code. */
+	static int Emit_Implied(const uint8_t *&in, uint8_t *&out, int &count, int cycles, std::initializer_list<uint8_t> code);
+
+	/** Ends the block with a conditional branch; its exits are emitted by
+	 * CompileBlock().
+	 *
+	 * \param[in] flag Flag tested
+	 * \param[in] set Whether the branch is taken when the flag is set
+	 */
+	int Emit_Branch(const uint8_t *&in, uint8_t *&out, int &count, bool &stop, uint8_t flag, bool set);
+
+	/** Adds a byte to A in decimal mode, as an NMOS 6502 does.
+	 *
+	 * \param[in] a Value of A
+	 * \param[in] val Value to add
+	 * \param[in] p Value of P
+	 *
+	 * \return New P in the high byte, new A in the low byte
+	 */
+	static uint16_t Helper_DecimalADC(uint8_t a, uint8_t val, uint8_t p);
+
+	/** Subtracts a byte from A in decimal mode, as an NMOS 6502 does.
+	 *
+	 * \see Helper_DecimalADC
+	 */
+	static uint16_t Helper_DecimalSBC(uint8_t a, uint8_t val, uint8_t p);
 
 	/**
 	 * \param[in] addr Address to read the value from
@@ -356,7 +1043,8 @@ private:
 		* These methods translate input address data and mode and return the
 		* actual address to read/write. Each specific opcode that reads from or
 		* writes to an address invokes one of these, but these functions read
-		* directly from the machine state.
+		* directly from the machine state. They're only used by Interpret();
+		* translated code works its addresses out itself.
 		*
 		* Unless otherwise noted, each function returns an \em index to the memory
 		* array as a \c uint16_t, which can be treated as an absolute pointer in
@@ -438,8 +1126,6 @@ private:
 		* condition is true. As <tt>PC</tt> itself is incremented during
 		* instruction execution by two the effective address range for the
 		* target instruction must be with -126 to +129 bytes of the branch.
-		*
-		* \note This method is unused.
 		*/
 	uint16_t Addr_REL(uint8_t *in); //!< Relative; <tt>OPC $BB</tt> branch target is PC + offest <tt>$BB</tt>; bit 7 (V?) signifies negative offset
 
@@ -485,20 +1171,25 @@ private:
 	/** @} */
 
 	//--------------------------------------------------------------------------
-	// NOP
-	int i_nop(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-
-	// JMP
-	int i_jmpabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-	int i_jmpind(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-
-	// JSR
-	int i_jsrabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 
-	// RTS
-	int i_rts(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	/** \defgroup module_emitters Instruction emitters
+		*
+		* Each of these translates the instruction at <tt>in</tt> and is named
+		* after its mnemonic and addressing mode. They all work the same way:
+		*
+		* \param[in,out] in Instruction to translate; advanced past it
+		* \param[in,out] out Where to emit the native code, or NULL to only size
+		* it; advanced past what was emitted
+		* \param[in,out] count Cycle count of the block so far; the instruction's
+		* base cycle count is added to it, and any page crossing or taken
+		* branch is taken from EBP at run time
+		* \param[out] stop Set if the block has to end after this instruction
+		*
+		* \return Size of the native code
+		* @{
+		*/
 
-	// LDA
+	// Load/Store
 	int i_ldaimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_ldazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_ldazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
@@ -507,16 +1198,170 @@ private:
 	int i_ldaaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_ldainx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_ldainy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-
-	// LDX
 	int i_ldximm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-
-	// LDY
+	int i_ldxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldxzpy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldxaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_ldyimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
-
-	// STA
+	int i_ldyzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldyzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldyabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_ldyabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_staabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
 	int i_staabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_staaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stainx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stainy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stxzpy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_stxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_styzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_styzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_styabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Register Transfer
+	int i_tax(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_tay(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_txa(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_tya(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Stack Operations
+	int i_tsx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_txs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_pha(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_php(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_pla(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_plp(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Logical Operations
+	int i_andimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andinx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_andiny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eoraby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eorinx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_eoriny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_oraimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_orazpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_orazpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_oraabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_oraabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_oraaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_orainx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_orainy(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bitzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bitabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Arithmetic Operations
+	int i_adcimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adcabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adcabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adcaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adcinx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_adciny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbcimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbcabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbcabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbcaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbcinx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sbciny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpaby(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpinx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cmpiny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpximm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpxzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpxabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpyimm(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpyzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cpyabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Increments and Decrements
+	int i_inczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_inczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_incabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_incabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_inx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_iny(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_deczpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_deczpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_decabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_decabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_dex(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_dey(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Shifts
+	int i_aslacc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_aslzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_aslzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_aslabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_aslabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_lsracc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_lsrzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_lsrzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_lsrabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_lsrabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rolacc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rolzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rolzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rolabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rolabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_roracc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rorzpg(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rorzpx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rorabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rorabx(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Jumps and Calls
+	int i_jmpabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_jmpind(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_jsrabs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rts(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Branches
+	int i_bcc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bcs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_beq(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bmi(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bne(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bpl(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bvc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_bvs(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// Status Flag Changes
+	int i_clc(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cld(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_cli(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_clv(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sec(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sed(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_sei(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+
+	// System Functions
+	int i_brk(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_nop(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	int i_rti(const uint8_t *&in, uint8_t *&out, int &count, bool &stop);
+	/** @} */
 };
 
 #endif // SYSTEM65SILT_CPP
\ No newline at end of file
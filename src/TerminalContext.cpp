@@ -0,0 +1,289 @@
+#include "TerminalContext.hpp"
+
+#ifdef WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <conio.h>
+#else
+	#include <unistd.h>
+	#include <errno.h>
+	#include <poll.h>
+#endif // WIN32
+
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Public
+//------------------------------------------------------------------------------
+
+const char *TerminalContext::m_CP437[256] = {
+	" ", "\xE2\x98\xBA", "\xE2\x98\xBB", "\xE2\x99\xA5", "\xE2\x99\xA6", "\xE2\x99\xA3", "\xE2\x99\xA0", "\xE2\x80\xA2",
+	"\xE2\x97\x98", "\xE2\x97\x8B", "\xE2\x97\x99", "\xE2\x99\x82", "\xE2\x99\x80", "\xE2\x99\xAA", "\xE2\x99\xAB", "\xE2\x98\xBC",
+	"\xE2\x96\xBA", "\xE2\x97\x84", "\xE2\x86\x95", "\xE2\x80\xBC", "\xC2\xB6", "\xC2\xA7", "\xE2\x96\xAC", "\xE2\x86\xA8",
+	"\xE2\x86\x91", "\xE2\x86\x93", "\xE2\x86\x92", "\xE2\x86\x90", "\xE2\x88\x9F", "\xE2\x86\x94", "\xE2\x96\xB2", "\xE2\x96\xBC",
+	" ", "!", "\"", "#", "$", "%", "&", "'",
+	"(", ")", "*", "+", ",", "-", ".", "/",
+	"0", "1", "2", "3", "4", "5", "6", "7",
+	"8", "9", ":", ";", "<", "=", ">", "?",
+	"@", "A", "B", "C", "D", "E", "F", "G",
+	"H", "I", "J", "K", "L", "M", "N", "O",
+	"P", "Q", "R", "S", "T", "U", "V", "W",
+	"X", "Y", "Z", "[", "\\", "]", "^", "_",
+	"`", "a", "b", "c", "d", "e", "f", "g",
+	"h", "i", "j", "k", "l", "m", "n", "o",
+	"p", "q", "r", "s", "t", "u", "v", "w",
+	"x", "y", "z", "{", "|", "}", "~", "\xE2\x8C\x82",
+	"\xC3\x87", "\xC3\xBC", "\xC3\xA9", "\xC3\xA2", "\xC3\xA4", "\xC3\xA0", "\xC3\xA5", "\xC3\xA7",
+	"\xC3\xAA", "\xC3\xAB", "\xC3\xA8", "\xC3\xAF", "\xC3\xAE", "\xC3\xAC", "\xC3\x84", "\xC3\x85",
+	"\xC3\x89", "\xC3\xA6", "\xC3\x86", "\xC3\xB4", "\xC3\xB6", "\xC3\xB2", "\xC3\xBB", "\xC3\xB9",
+	"\xC3\xBF", "\xC3\x96", "\xC3\x9C", "\xC2\xA2", "\xC2\xA3", "\xC2\xA5", "\xE2\x82\xA7", "\xC6\x92",
+	"\xC3\xA1", "\xC3\xAD", "\xC3\xB3", "\xC3\xBA", "\xC3\xB1", "\xC3\x91", "\xC2\xAA", "\xC2\xBA",
+	"\xC2\xBF", "\xE2\x8C\x90", "\xC2\xAC", "\xC2\xBD", "\xC2\xBC", "\xC2\xA1", "\xC2\xAB", "\xC2\xBB",
+	"\xE2\x96\x91", "\xE2\x96\x92", "\xE2\x96\x93", "\xE2\x94\x82", "\xE2\x94\xA4", "\xE2\x95\xA1", "\xE2\x95\xA2", "\xE2\x95\x96",
+	"\xE2\x95\x95", "\xE2\x95\xA3", "\xE2\x95\x91", "\xE2\x95\x97", "\xE2\x95\x9D", "\xE2\x95\x9C", "\xE2\x95\x9B", "\xE2\x94\x90",
+	"\xE2\x94\x94", "\xE2\x94\xB4", "\xE2\x94\xAC", "\xE2\x94\x9C", "\xE2\x94\x80", "\xE2\x94\xBC", "\xE2\x95\x9E", "\xE2\x95\x9F",
+	"\xE2\x95\x9A", "\xE2\x95\x94", "\xE2\x95\xA9", "\xE2\x95\xA6", "\xE2\x95\xA0", "\xE2\x95\x90", "\xE2\x95\xAC", "\xE2\x95\xA7",
+	"\xE2\x95\xA8", "\xE2\x95\xA4", "\xE2\x95\xA5", "\xE2\x95\x99", "\xE2\x95\x98", "\xE2\x95\x92", "\xE2\x95\x93", "\xE2\x95\xAB",
+	"\xE2\x95\xAA", "\xE2\x94\x98", "\xE2\x94\x8C", "\xE2\x96\x88", "\xE2\x96\x84", "\xE2\x96\x8C", "\xE2\x96\x90", "\xE2\x96\x80",
+	"\xCE\xB1", "\xC3\x9F", "\xCE\x93", "\xCF\x80", "\xCE\xA3", "\xCF\x83", "\xC2\xB5", "\xCF\x84",
+	"\xCE\xA6", "\xCE\x98", "\xCE\xA9", "\xCE\xB4", "\xE2\x88\x9E", "\xCF\x86", "\xCE\xB5", "\xE2\x88\xA9",
+	"\xE2\x89\xA1", "\xC2\xB1", "\xE2\x89\xA5", "\xE2\x89\xA4", "\xE2\x8C\xA0", "\xE2\x8C\xA1", "\xC3\xB7", "\xE2\x89\x88",
+	"\xC2\xB0", "\xE2\x88\x99", "\xC2\xB7", "\xE2\x88\x9A", "\xE2\x81\xBF", "\xC2\xB2", "\xE2\x96\xA0", "\xC2\xA0",
+};
+
+volatile sig_atomic_t TerminalContext::m_Active = 0;
+#ifndef WIN32
+struct termios TerminalContext::m_OldTermios;
+bool TerminalContext::m_TermiosSaved = false;
+struct sigaction TerminalContext::m_OldSigInt;
+struct sigaction TerminalContext::m_OldSigTerm;
+#endif // WIN32
+
+TerminalContext::TerminalContext(bool unicode) :
+	m_Unicode(unicode),
+	m_CursorX(-1),
+	m_CursorY(-1)
+{
+	// A full redraw with every cell being a 3-byte glyph fits without growing
+	m_Out.reserve(EMUSCREEN_WIDTH*EMUSCREEN_HEIGHT*4);
+
+#ifdef WIN32
+	// Windows 10 consoles only understand escape sequences when asked to
+	HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode;
+	if (GetConsoleMode(out, &mode))
+		SetConsoleMode(out, mode | 0x0004); // ENABLE_VIRTUAL_TERMINAL_PROCESSING
+	if (m_Unicode)
+		SetConsoleOutputCP(65001); // CP_UTF8
+#else
+	// Input from a pipe or file is left alone; ReadKey() polls it instead
+	m_TermiosSaved = isatty(STDIN_FILENO) && (tcgetattr(STDIN_FILENO, &m_OldTermios) == 0);
+	if (m_TermiosSaved) {
+		struct termios raw = m_OldTermios;
+		raw.c_lflag &= ~(ICANON | ECHO);
+		raw.c_cc[VMIN] = 0;
+		raw.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+	}
+
+	// Being killed mustn't leave the terminal in raw mode on the alternate
+	// screen; the handler runs once, then the signal is raised again
+	struct sigaction sa;
+	sa.sa_handler = HandleSignal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESETHAND;
+	sigaction(SIGINT, &sa, &m_OldSigInt);
+	sigaction(SIGTERM, &sa, &m_OldSigTerm);
+
+	// A signal that was being ignored, as under nohup, still is
+	if (m_OldSigInt.sa_handler == SIG_IGN)
+		sigaction(SIGINT, &m_OldSigInt, NULL);
+	if (m_OldSigTerm.sa_handler == SIG_IGN)
+		sigaction(SIGTERM, &m_OldSigTerm, NULL);
+#endif // WIN32
+
+	// Nor must exiting without running the destructor
+	static bool registered = false;
+	if (!registered)
+		registered = (atexit(Restore) == 0);
+	m_Active = 1;
+
+	// Alternate screen, hide the cursor, plain attributes, clear
+	static const char init[] = "\x1B[?1049h\x1B[?25l\x1B[0m\x1B[2J";
+	Send(init, sizeof(init) - 1);
+}
+
+TerminalContext::~TerminalContext()
+{
+	Restore();
+
+#ifndef WIN32
+	sigaction(SIGINT, &m_OldSigInt, NULL);
+	sigaction(SIGTERM, &m_OldSigTerm, NULL);
+#endif // WIN32
+}
+
+void TerminalContext::Present(ScreenBuffer &screen)
+{
+	if (!screen.IsDirty())
+		return;
+
+	m_Out.clear();
+	screen.ForEachDirty([this, &screen](unsigned int x, unsigned int y, uint8_t c) {
+		if ((int)y != m_CursorY) {
+			MoveCursor(x, y);
+		} else if ((int)x != m_CursorX) {
+			// For a short gap on the same row, resending the cells in between
+			// is cheaper than a cursor movement sequence.
+			if ((m_CursorX >= 0) && ((int)x > m_CursorX) && ((int)x - m_CursorX <= 2)) {
+				for (int i = m_CursorX; i < (int)x; i++)
+					PutGlyph(screen.GetChar(i, y));
+			} else {
+				MoveCursor(x, y);
+			}
+		}
+
+		PutGlyph(c);
+
+		// Past the last column, terminals differ in where the cursor ends up
+		m_CursorX = (x + 1 < EMUSCREEN_WIDTH) ? (int)(x + 1) : -1;
+		if (m_CursorX < 0)
+			m_CursorY = -1;
+	});
+	screen.ClearDirty();
+
+	Send(m_Out.data(), m_Out.size());
+}
+
+void TerminalContext::Redraw(ScreenBuffer &screen)
+{
+	static const char clear[] = "\x1B[0m\x1B[2J";
+	Send(clear, sizeof(clear) - 1);
+	m_CursorX = m_CursorY = -1;
+	screen.Invalidate();
+}
+
+int TerminalContext::ReadKey(void)
+{
+#ifdef WIN32
+	if (!_kbhit())
+		return -1;
+	return _getch();
+#else
+	// Raw mode makes read() return straight away, but input that isn't a
+	// terminal would block, so check that something is waiting first
+	struct pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+	if ((poll(&fd, 1, 0) <= 0) || !(fd.revents & POLLIN))
+		return -1;
+
+	unsigned char c;
+	if (read(STDIN_FILENO, &c, 1) != 1)
+		return -1;
+	return c;
+#endif // WIN32
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void TerminalContext::PutGlyph(uint8_t c)
+{
+	if (m_Unicode) {
+		m_Out.append(m_CP437[c]);
+		return;
+	}
+
+	// Rough ASCII approximations of the glyphs
+	if ((c >= 0x20) && (c < 0x7F))
+		m_Out.push_back((char)c);
+	else if ((c == 0xB3) || (c == 0xBA))
+		m_Out.push_back('|');
+	else if ((c == 0xC4) || (c == 0xCD))
+		m_Out.push_back('-');
+	else if ((c >= 0xB4) && (c <= 0xDA))
+		m_Out.push_back('+');
+	else if (c == 0x00)
+		m_Out.push_back(' ');
+	else
+		m_Out.push_back('?');
+}
+
+void TerminalContext::MoveCursor(unsigned int x, unsigned int y)
+{
+	// CUP is 1-based
+	char seq[16];
+	int len = 0;
+	unsigned int row = y + 1, col = x + 1;
+
+	seq[len++] = '\x1B';
+	seq[len++] = '[';
+	if (row >= 10)
+		seq[len++] = (char)('0' + row / 10);
+	seq[len++] = (char)('0' + row % 10);
+	seq[len++] = ';';
+	if (col >= 100)
+		seq[len++] = (char)('0' + col / 100);
+	if (col >= 10)
+		seq[len++] = (char)('0' + (col / 10) % 10);
+	seq[len++] = (char)('0' + col % 10);
+	seq[len++] = 'H';
+	m_Out.append(seq, len);
+
+	m_CursorX = (int)x;
+	m_CursorY = (int)y;
+}
+
+void TerminalContext::Restore(void)
+{
+	if (!m_Active)
+		return;
+	m_Active = 0;
+
+	// Show the cursor and go back to the normal screen
+	static const char fini[] = "\x1B[0m\x1B[?25h\x1B[?1049l";
+	Send(fini, sizeof(fini) - 1);
+
+#ifndef WIN32
+	if (m_TermiosSaved)
+		tcsetattr(STDIN_FILENO, TCSANOW, &m_OldTermios);
+#endif // WIN32
+}
+
+#ifndef WIN32
+void TerminalContext::HandleSignal(int sig)
+{
+	int saved = errno;
+	Restore();
+	errno = saved;
+
+	// SA_RESETHAND has put the default action back, so this ends the
+	// process as the signal would have once the handler returns
+	raise(sig);
+}
+#endif // WIN32
+
+void TerminalContext::Send(const char *data, size_t len)
+{
+#ifdef WIN32
+	HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+	while (len > 0) {
+		DWORD written;
+		if (!WriteFile(out, data, (DWORD)len, &written, NULL))
+			return;
+		data += written;
+		len -= written;
+	}
+#else
+	while (len > 0) {
+		ssize_t written = write(STDOUT_FILENO, data, len);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		data += written;
+		len -= written;
+	}
+#endif // WIN32
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef TERMINALCONTEXT_HPP
+#define TERMINALCONTEXT_HPP
+
+// Standard libs
+#include <signal.h>
+#include <stdint.h>
+
+#include <string>
+
+#ifndef WIN32
+	#include <termios.h>
+#endif // WIN32
+
+// Project libs
+#include "ScreenBuffer.hpp"
+
+/** \file TerminalContext.hpp
+ * Interface for the \ref TerminalContext class.
+ */
+
+/**
+ * The class for driving a text terminal with ANSI escape sequences.
+ *
+ * This class is the terminal counterpart to SFMLContext: it shows the emulator
+ * screen on whatever terminal the emulator was started from, which is handy
+ * when running over SSH.
+ *
+ * Only the cells that are dirty in the \ref ScreenBuffer are sent, and the
+ * cursor is only moved when the next changed cell isn't where the cursor
+ * already is. Each frame is encoded into one buffer and sent with a single
+ * write, so an idle screen costs nothing and a register update costs a few
+ * dozen bytes.
+ *
+ * Glyphs are sent as the UTF-8 equivalent of code page 437, so the frame
+ * borders look the same as with the font atlas. Terminals that can't show
+ * UTF-8 can be given plain ASCII instead.
+ *
+ * The terminal is put back how it was found when the context is destroyed,
+ * and also if the process exits without destroying it, or is stopped by
+ * SIGINT or SIGTERM. When stdin isn't a terminal, it's left as it is and
+ * only read from when there's input waiting.
+ *
+ * \note The terminal should be at least EMUSCREEN_WIDTH x EMUSCREEN_HEIGHT.
+ * \note Only one TerminalContext should exist at a time.
+ */
+
+class TerminalContext
+{
+	public:
+		/** Switches the terminal to the alternate screen, hides the cursor and,
+		 * if stdin is a terminal, puts the input in unbuffered mode.
+		 *
+		 * \param[in] unicode Whether to send glyphs as UTF-8; if false, the
+		 * box-drawing characters are approximated with ASCII
+		 */
+		TerminalContext(bool unicode = true);
+
+		/** Restores the terminal to how it was found. */
+		~TerminalContext();
+
+		/** Sends the cells that changed since the last call, then marks them
+		 * clean.
+		 *
+		 * \param[in,out] screen Character grid to present
+		 */
+		void Present(ScreenBuffer &screen);
+
+		/** Clears the terminal, forcing the next Present() to send every cell.
+		 *
+		 * \param[in,out] screen Character grid whose cells should all be resent
+		 */
+		void Redraw(ScreenBuffer &screen);
+
+		/** Returns the next key that was pressed, without waiting.
+		 *
+		 * \return The key, or -1 if no key is waiting
+		 */
+		int ReadKey(void);
+
+	protected:
+	private:
+		static const char *m_CP437[256]; //!< UTF-8 encoding of each code page 437 glyph
+
+		bool m_Unicode; //!< Whether glyphs are sent as UTF-8
+		int m_CursorX; //!< Column the terminal cursor is at, or -1 if unknown
+		int m_CursorY; //!< Row the terminal cursor is at, or -1 if unknown
+		std::string m_Out; //!< Output for the current frame; kept to avoid reallocating
+
+		static volatile sig_atomic_t m_Active; //!< Whether the terminal needs restoring
+#ifndef WIN32
+		static struct termios m_OldTermios; //!< Terminal settings to restore on exit
+		static bool m_TermiosSaved; //!< Whether m_OldTermios is valid
+		static struct sigaction m_OldSigInt; //!< SIGINT handler to put back when the context is destroyed
+		static struct sigaction m_OldSigTerm; //!< SIGTERM handler to put back when the context is destroyed
+#endif // WIN32
+
+		/** Appends the encoding of glyph <tt>c</tt> to the output. */
+		void PutGlyph(uint8_t c);
+
+		/** Appends a cursor movement to <tt>x</tt>,<tt>y</tt> to the output. */
+		void MoveCursor(unsigned int x, unsigned int y);
+
+		/** Writes a string straight to the terminal.
+		 *
+		 * \note Safe to call from a signal handler.
+		 */
+		static void Send(const char *data, size_t len);
+
+		/** Leaves the alternate screen, shows the cursor and restores the
+		 * input settings, if that hasn't been done already.
+		 *
+		 * \note Safe to call from a signal handler.
+		 */
+		static void Restore(void);
+
+#ifndef WIN32
+		/** Restores the terminal, then lets the signal do what it would
+		 * have done.
+		 *
+		 * \param[in] sig Signal that was raised
+		 */
+		static void HandleSignal(int sig);
+#endif // WIN32
+};
+
+#endif // TERMINALCONTEXT_HPP
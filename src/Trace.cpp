@@ -1,10 +1,14 @@
 #include "System65/System65.hpp"
 
+#include <exception>
+#include <sstream>
+#include <thread>
+
 //------------------------------------------------------------------------------
 // Public
 //------------------------------------------------------------------------------
 
-void System65::StartRecordTrace(std::string filename, unsigned int instructioncount)
+void System65::StartRecordTrace(std::string filename, unsigned int instructioncount, Trace::AsyncRecord::Backpressure backpressure)
 {
 	if (instructioncount == 0)
 		return;
@@ -12,26 +16,31 @@ void System65::StartRecordTrace(std::string filename, unsigned int instructionco
 	if (filename.empty())
 		return;
 
-	m_TraceFrameCount = instructioncount;
+	m_TraceFrameCount = (instructioncount > UINT_MAX - m_InstructionCount) ? UINT_MAX : m_InstructionCount + instructioncount;
 	m_TraceFilename = filename;
 
-	m_Trace = new YAML::Emitter();
+	m_Trace = std::make_unique<Trace::AsyncRecord>(filename, backpressure);
 
-	*m_Trace << YAML::Comment("System65 Diagnostic Trace v0");
-	std::stringstream sInsnCount;
-	sInsnCount << "Expected instruction count: " << instructioncount;
-	*m_Trace << YAML::Comment(sInsnCount.str());
-	*m_Trace << YAML::Key << "progname" << YAML::Value << filename.c_str();
+	// The first frame has to capture memory as it is now
+	m_TraceFullFrame = true;
+	m_TraceFrame.writecount = 0;
+	m_TraceFrame.overflow = false;
+	m_TraceFrame.interrupt = TRACE_INTERRUPT_NONE;
+	m_WriteLogEnabled = true;
 }
 
 void System65::EndRecordTrace(void)
 {
-	*m_Trace << YAML::Comment("End of trace file");
-	std::ofstream tracefile(m_TraceFilename);
-	tracefile << *m_Trace->c_str();
-	tracefile.flush();
-	delete m_Trace;
-	m_Trace = nullptr;
+	if (!m_Trace)
+		return;
+
+	m_WriteLogEnabled = false;
+
+	// Take the recorder out first, so a failed write still ends the trace
+	std::unique_ptr<Trace::AsyncRecord> trace = std::move(m_Trace);
+	trace->Close();
+	if (trace->GetDroppedFrames())
+		std::cerr << "Trace dropped " << trace->GetDroppedFrames() << " frames" << std::endl;
 }
 
 bool System65::IsTraceRunning(void)
@@ -39,43 +48,258 @@ bool System65::IsTraceRunning(void)
 	return (m_Trace != nullptr);
 }
 
+bool System65::PlayTrace(std::string filename, unsigned int instructioncount, unsigned int threads)
+{
+	if (m_Trace)
+		throw std::runtime_error("can't play back a trace while recording one");
+
+	Trace::BinaryPlayback playback(filename);
+	Trace::FrameView frame;
+	if (!playback.Next(frame))
+		throw std::runtime_error("trace file " + filename + " has no frames");
+
+	// The count includes the first frame, as it does when recording
+	uint32_t first = frame.number;
+	uint32_t last = (instructioncount == 0) ? UINT32_MAX :
+		((instructioncount - 1 > UINT32_MAX - first) ? UINT32_MAX : first + instructioncount - 1);
+
+	// Segments start at the first frame and at each keyframe after it
+	std::vector<uint32_t> starts(1, first);
+	for (const Trace::KeyframeEntry &k : playback.GetKeyframes()) {
+		if ((k.number > first) && (k.number < last))
+			starts.push_back(k.number);
+	}
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min(threads, (unsigned int)starts.size());
+
+	if (threads == 1) {
+		// The first frame holds every non-zero byte of memory, so it sets the
+		// machine up as it was when recording started
+		std::vector<uint8_t> memory(MAX_MEM_SIZE, 0x00);
+		for (size_t i = 0; i < frame.writecount; i++)
+			memory[frame.writes[i].addr] = frame.writes[i].val;
+
+		uint64_t frames = 0;
+		if (PlaySegment(playback, frame, memory.data(), last, frames, std::cerr) != 0)
+			return false;
+		std::cout << "Trace matched " << (frames + 1) << " frames" << std::endl;
+		return true;
+	}
+
+	// Outcome of each segment
+	struct Segment {
+		uint32_t diverged; // First frame that didn't match, or 0
+		uint64_t frames; // Frames that matched
+		std::string report; // Report for the frame that didn't match
+		std::exception_ptr error; // Error reading the segment, if any
+	};
+	std::vector<Segment> segments(starts.size());
+	std::atomic<size_t> next(0);
+
+	// Each worker takes the next segment that nobody has started yet, using
+	// its own machine and its own handle on the file
+	auto worker = [&]() {
+		System65 vm(memorysize);
+		vm.m_StackBase = m_StackBase;
+		vm.m_InterruptVector = m_InterruptVector;
+		vm.MapFramebuffer(m_Framebuffer->GetBase());
+
+		std::unique_ptr<Trace::BinaryPlayback> reader;
+		std::vector<uint8_t> memory(MAX_MEM_SIZE);
+		for (size_t i = next++; i < starts.size(); i = next++) {
+			Segment &seg = segments[i];
+			seg.diverged = 0;
+			seg.frames = 0;
+			try {
+				if (!reader)
+					reader = std::make_unique<Trace::BinaryPlayback>(filename);
+				Trace::FrameView start;
+				reader->Seek(starts[i], start, memory.data());
+				uint32_t end = (i + 1 < starts.size()) ? starts[i + 1] : last;
+				std::ostringstream report;
+				seg.diverged = vm.PlaySegment(*reader, start, memory.data(), end, seg.frames, report);
+				seg.report = report.str();
+			}
+			catch (...) {
+				seg.error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned int t = 0; t < threads; t++)
+		pool.emplace_back(worker);
+	for (std::thread &t : pool)
+		t.join();
+
+	uint64_t frames = 1;
+	unsigned int divergences = 0;
+	for (const Segment &seg : segments) {
+		if (seg.error)
+			std::rethrow_exception(seg.error);
+		frames += seg.frames;
+		if (seg.diverged) {
+			std::cerr << seg.report;
+			divergences++;
+		}
+	}
+
+	if (divergences) {
+		std::cerr << divergences << " of " << segments.size() << " segments diverged" << std::endl;
+		return false;
+	}
+	std::cout << "Trace matched " << frames << " frames in " << segments.size() << " segments" << std::endl;
+	return true;
+}
+
 //------------------------------------------------------------------------------
 // Private
 //------------------------------------------------------------------------------
 
-void System65::RecordFrame(unsigned int frameNumber, uint8_t oldMemory[0x10000], uint8_t newMemory[0x10000])
+uint32_t System65::PlaySegment(Trace::BinaryPlayback &playback, const Trace::FrameView &start, const uint8_t *memory,
+	uint32_t last, uint64_t &frames, std::ostream &report)
 {
-	if (m_Trace == nullptr)
-		throw;
+	// The trace's view of memory is kept alongside to compare against
+	std::vector<uint8_t> expected(memory, memory + MAX_MEM_SIZE);
+	memcpy(m_Memory->data(), memory, MAX_MEM_SIZE);
+	for (unsigned int page = 0; page < (MAX_MEM_SIZE >> 8); page++)
+		m_PageWrites[page]++;
+	m_Framebuffer->Invalidate();
 
-	*m_Trace << YAML::BeginMap;
-	*m_Trace << YAML::Key << "frame" << YAML::Value << frameNumber;
-	*m_Trace << YAML::Key << "a" << YAML::Value << a;
-	*m_Trace << YAML::Key << "x" << YAML::Value << x;
-	*m_Trace << YAML::Key << "y" << YAML::Value << y;
-	*m_Trace << YAML::Key << "pf" << YAML::Value << pf;
-	*m_Trace << YAML::Key << "s" << YAML::Value << s;
-	*m_Trace << YAML::Key << "pc" << YAML::Value << pc;
-
-	*m_Trace << YAML::Key << "memory" << YAML::Value;
-	// If there is no oldMemory[] then write all of the memory values
-	if (oldMemory == nullptr) {
-		*m_Trace << YAML::BeginSeq;
-		for (unsigned int i = 0; i > 0x10000; i++) {
-			*m_Trace << newMemory[i];
+	a = start.a;
+	x = start.x;
+	y = start.y;
+	pf = start.p;
+	s = start.s;
+	pc = start.pc;
+	m_InstructionCount = start.number;
+	m_GenerateInterrupt = false;
+
+	Trace::FrameView frame;
+	uint32_t diverged = 0;
+	frames = 0;
+
+	m_WriteLogEnabled = true;
+	while ((m_InstructionCount < last) && playback.Next(frame) && (frame.number <= last)) {
+		m_TraceFrame.writecount = 0;
+		m_TraceFrame.overflow = false;
+		m_TraceFrame.interrupt = TRACE_INTERRUPT_NONE;
+
+		// Catch up to the frame; the trace may have skipped some
+		unsigned int ticks = 0;
+		while (m_InstructionCount < frame.number) {
+			unsigned int before = m_InstructionCount;
+			Dispatch();
+			if (m_InstructionCount == before)
+				break; // Unhandled opcode; the registers won't match below
+			ticks++;
 		}
-		*m_Trace << YAML::EndSeq;
-	} else { // Otherwise compare new memory
-		*m_Trace << YAML::BeginMap;
-		for (unsigned int i = 0; i > 0x10000; i++) {
-			if (oldMemory[i] != newMemory[i])
-				*m_Trace << YAML::Key << i << YAML::Value << newMemory[i];
+
+		for (size_t i = 0; i < frame.writecount; i++)
+			expected[frame.writes[i].addr] = frame.writes[i].val;
+
+		bool same = (m_InstructionCount == frame.number) && (a == frame.a) && (x == frame.x) && (y == frame.y) &&
+			(pf == frame.p) && (s == frame.s) && (pc == frame.pc);
+
+		const uint8_t *mem = m_Memory->data();
+		if (same && ((ticks != 1) || m_TraceFrame.overflow)) {
+			same = (memcmp(mem, expected.data(), MAX_MEM_SIZE) == 0);
+		} else if (same) {
+			// The trace only has bytes that changed, and the log has every
+			// write; check both against what memory holds now
+			for (size_t i = 0; same && (i < frame.writecount); i++)
+				same = (mem[frame.writes[i].addr] == frame.writes[i].val);
+			for (unsigned int i = 0; same && (i < m_TraceFrame.writecount); i++)
+				same = (mem[m_TraceFrame.writes[i].addr] == expected[m_TraceFrame.writes[i].addr]);
 		}
-		*m_Trace << YAML::EndMap;
+
+		if (!same) {
+			ReportDivergence(frame, expected, report);
+			diverged = frame.number;
+			break;
+		}
+		frames++;
+	}
+	m_WriteLogEnabled = false;
+	m_TraceFrame.writecount = 0;
+	m_TraceFrame.overflow = false;
+	m_TraceFrame.interrupt = TRACE_INTERRUPT_NONE;
+
+	return diverged;
+}
+
+void System65::ReportDivergence(const Trace::FrameView &frame, const std::vector<uint8_t> &expected, std::ostream &out)
+{
+	std::ios::fmtflags flags = out.flags();
+
+	out << "Trace diverged at frame " << std::dec << frame.number;
+	if (m_InstructionCount != frame.number)
+		out << " (emulator is at instruction " << m_InstructionCount << ")";
+	out << std::endl;
+
+	out << std::hex << std::uppercase << std::setfill('0');
+	out << "  reg  trace  emulator" << std::endl;
+
+	const char *names[6] = { "a", "x", "y", "p", "s", "pc" };
+	const unsigned int traced[6] = { frame.a, frame.x, frame.y, frame.p, frame.s, frame.pc };
+	const unsigned int actual[6] = { a, x, y, pf, s, pc };
+	for (unsigned int i = 0; i < 6; i++) {
+		int width = (i == 5) ? 4 : 2;
+		out << "  " << std::setw(3) << std::setfill(' ') << std::left << names[i] << std::right << std::setfill('0')
+			<< "  $" << std::setw(width) << traced[i] << std::string(5 - width, ' ')
+			<< "$" << std::setw(width) << actual[i] << std::string(7 - width, ' ')
+			<< ((traced[i] != actual[i]) ? "<--" : "") << std::endl;
 	}
 
-	*m_Trace << YAML::EndMap;
+	const uint8_t *mem = m_Memory->data();
+	unsigned int diffs = 0;
+	for (unsigned int addr = 0; addr < MAX_MEM_SIZE; addr++) {
+		if (mem[addr] == expected[addr])
+			continue;
+		if (diffs == 0)
+			out << "  addr   trace  emulator" << std::endl;
+		if (diffs < TRACE_MAX_REPORTED_DIFFS)
+			out << "  $" << std::setw(4) << addr << "  $" << std::setw(2) << (unsigned int)expected[addr]
+				<< "    $" << std::setw(2) << (unsigned int)mem[addr] << std::endl;
+		diffs++;
+	}
+	if (diffs > TRACE_MAX_REPORTED_DIFFS)
+		out << "  ...and " << std::dec << (diffs - TRACE_MAX_REPORTED_DIFFS) << " more bytes" << std::endl;
+	else if (diffs == 0)
+		out << "  memory matches" << std::endl;
 
-	if (frameNumber == m_TraceFrameCount)
+	out.flags(flags);
+	out << std::setfill(' ');
+}
+
+void System65::RecordFrame(void)
+{
+	if (!m_Trace)
+		throw;
+
+	m_TraceFrame.number = m_InstructionCount;
+	m_TraceFrame.a = a;
+	m_TraceFrame.x = x;
+	m_TraceFrame.y = y;
+	m_TraceFrame.p = pf;
+	m_TraceFrame.s = s;
+	m_TraceFrame.pc = pc;
+
+	// Writes made outside of Dispatch() (Poke(), LoadProgram()) land in the
+	// log too, and can overflow it; compare all of memory in that case, and
+	// after frames were dropped.
+	if (m_TraceFullFrame || m_TraceFrame.overflow || m_Trace->NeedsFullFrame())
+		m_Trace->Snap(m_InstructionCount, a, x, y, pf, s, pc, m_Memory->data());
+	else
+		m_Trace->Push(m_TraceFrame);
+
+	m_TraceFullFrame = false;
+	m_TraceFrame.writecount = 0;
+	m_TraceFrame.overflow = false;
+	m_TraceFrame.interrupt = TRACE_INTERRUPT_NONE;
+
+	if (m_InstructionCount >= m_TraceFrameCount)
 		EndRecordTrace(); // Set frame count reached, so write out the file
-}
\ No newline at end of file
+}
@@ -0,0 +1,134 @@
+#include "Trace/AsyncRecord.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+Trace::AsyncRecord::AsyncRecord(std::string filename, Backpressure backpressure, size_t capacity) :
+	m_Backpressure(backpressure),
+	m_Head(0),
+	m_CachedTail(0),
+	m_Dropped(0),
+	m_NeedsFullFrame(false),
+	m_Tail(0),
+	m_Stop(false)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+	m_Ring.resize(size);
+	m_Mask = size - 1;
+
+	if (((filename.size() >= 4) && (filename.compare(filename.size() - 4, 4, ".yml") == 0)) ||
+		((filename.size() >= 5) && (filename.compare(filename.size() - 5, 5, ".yaml") == 0)))
+		m_Record = std::make_unique<Yaml>(filename);
+	else
+		m_Record = std::make_unique<BinaryRecord>(filename);
+	m_Writer = std::thread(&AsyncRecord::WriterMain, this);
+}
+
+Trace::AsyncRecord::~AsyncRecord()
+{
+	try {
+		Close();
+	}
+	catch (...) {
+	}
+}
+
+void Trace::AsyncRecord::Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem)
+{
+	Drain();
+
+	std::lock_guard<std::mutex> lock(m_RecordLock);
+	if (m_Error)
+		return;
+	try {
+		m_Record->Snap(instructioncount, a, x, y, p, s, pc, mem);
+	}
+	catch (...) {
+		m_Error = std::current_exception();
+	}
+	m_NeedsFullFrame = false;
+}
+
+void Trace::AsyncRecord::Close(void)
+{
+	if (!m_Writer.joinable())
+		return;
+
+	m_Stop.store(true, std::memory_order_release);
+	m_Writer.join();
+
+	std::lock_guard<std::mutex> lock(m_RecordLock);
+	if (!m_Error) {
+		try {
+			m_Record->Close();
+		}
+		catch (...) {
+			m_Error = std::current_exception();
+		}
+	}
+	if (m_Error)
+		std::rethrow_exception(m_Error);
+}
+
+bool Trace::AsyncRecord::WaitForRoom(size_t head)
+{
+	if (m_Backpressure == BACKPRESSURE_DROP) {
+		m_Dropped++;
+		m_NeedsFullFrame = true;
+		return false;
+	}
+
+	do {
+		std::this_thread::yield();
+		m_CachedTail = m_Tail.load(std::memory_order_acquire);
+	} while (head - m_CachedTail > m_Mask);
+
+	return true;
+}
+
+void Trace::AsyncRecord::Drain(void)
+{
+	size_t head = m_Head.load(std::memory_order_relaxed);
+	while (m_Tail.load(std::memory_order_acquire) != head)
+		std::this_thread::yield();
+	m_CachedTail = head;
+}
+
+void Trace::AsyncRecord::WriterMain(void)
+{
+	size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+	for (;;) {
+		// Read the stop flag first, so that every frame pushed before it was
+		// set is seen below
+		bool stop = m_Stop.load(std::memory_order_acquire);
+		size_t head = m_Head.load(std::memory_order_acquire);
+
+		if (tail == head) {
+			if (stop)
+				return;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(m_RecordLock);
+		while (tail != head) {
+			// Once something failed, keep draining so the VM never blocks
+			if (!m_Error) {
+				try {
+					m_Record->Snap(m_Ring[tail & m_Mask]);
+				}
+				catch (...) {
+					m_Error = std::current_exception();
+				}
+			}
+			tail++;
+
+			if ((tail & (PUBLISH_INTERVAL - 1)) == 0)
+				m_Tail.store(tail, std::memory_order_release);
+		}
+		m_Tail.store(tail, std::memory_order_release);
+	}
+}
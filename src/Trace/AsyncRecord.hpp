@@ -0,0 +1,146 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project libs
+#include "Trace/BinaryRecord.hpp"
+#include "Trace/Frame.hpp"
+#include "Trace/Recorder.hpp"
+#include "Trace/Yaml.hpp"
+
+namespace Trace {
+	/** \class AsyncRecord
+	* Records a trace on a background thread.
+	*
+	* The VM thread only copies each \ref Frame into a ring buffer with Push();
+	* a writer thread takes frames out of the ring and encodes them with a
+	* \ref Recorder, which also does the file I/O: a \ref Yaml if the
+	* filename ends in ".yml" or ".yaml", or else a \ref BinaryRecord. The ring has exactly one
+	* producer and one consumer, so it needs no locks: each side owns one
+	* index, and only reads the other side's index when its cached copy says
+	* the ring is full (or empty).
+	*
+	* When the writer falls behind and the ring fills up, the VM thread either
+	* waits for room (BACKPRESSURE_BLOCK) or throws the frame away and counts it
+	* (BACKPRESSURE_DROP). A trace with dropped frames is missing their memory
+	* writes, so after a drop NeedsFullFrame() returns true until the VM records
+	* a full frame with Snap(), which brings the trace back in sync.
+	*
+	* \note Push() and Snap() must only be called from one thread.
+	*/
+	class AsyncRecord
+	{
+	public:
+		/** What to do when the ring is full. */
+		enum Backpressure {
+			BACKPRESSURE_BLOCK, //!< Wait for the writer to make room
+			BACKPRESSURE_DROP //!< Drop the frame and count it
+		};
+
+		/** Opens the trace file and starts the writer thread.
+		*
+		* \param[in] filename File to record to; without an extension, a binary
+		* trace is written to <tt>filename</tt>.btr
+		* \param[in] backpressure What to do when the ring is full
+		* \param[in] capacity Number of frames the ring holds; rounded up to a
+		* power of two
+		*
+		* \throws std::invalid_argument if <tt>filename</tt> is empty
+		* \throws std::runtime_error if the file can't be opened
+		*/
+		AsyncRecord(std::string filename = "trace", Backpressure backpressure = BACKPRESSURE_BLOCK, size_t capacity = 65536);
+
+		/** Stops the writer thread and closes the file.
+		*
+		* \note Errors are lost here; call Close() to see them.
+		*/
+		~AsyncRecord();
+
+		/** Queues a frame for the writer thread.
+		*
+		* \param[in] frame Frame to record
+		*
+		* \return Whether the frame was queued; false if it was dropped
+		*/
+		bool Push(const Frame &frame)
+		{
+			size_t head = m_Head.load(std::memory_order_relaxed);
+			if (head - m_CachedTail > m_Mask) {
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+				if ((head - m_CachedTail > m_Mask) && !WaitForRoom(head))
+					return false;
+			}
+
+			m_Ring[head & m_Mask] = frame;
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Records a frame that stores all of memory.
+		*
+		* Waits for the writer to catch up, then encodes the frame on the
+		* calling thread. This is for the first frame of a trace, and for
+		* frames whose write log isn't usable.
+		*
+		* \see Recorder::Snap
+		*/
+		void Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem);
+
+		/** Returns whether frames were dropped since the last full frame. */
+		bool NeedsFullFrame(void) const { return m_NeedsFullFrame; }
+
+		/** Returns the number of frames dropped so far. */
+		uint64_t GetDroppedFrames(void) const { return m_Dropped; }
+
+		/** Writes out every queued frame, stops the writer thread and flushes
+		* the file. Does nothing if already closed.
+		*
+		* \throws std::runtime_error if the writer failed at any point
+		*/
+		void Close(void);
+
+	private:
+		static const size_t PUBLISH_INTERVAL = 1024; //!< Frames the writer encodes before handing their slots back
+
+		std::unique_ptr<Recorder> m_Record; //!< Encoder and file; guarded by m_RecordLock
+		std::mutex m_RecordLock; //!< Held by whichever thread is using m_Record
+		std::thread m_Writer; //!< The writer thread
+
+		std::vector<Frame> m_Ring; //!< The ring buffer
+		size_t m_Mask; //!< Ring capacity minus one
+		Backpressure m_Backpressure; //!< What to do when the ring is full
+
+		// Producer side
+		alignas(64) std::atomic<size_t> m_Head; //!< Next slot to be filled; only the producer writes it
+		size_t m_CachedTail; //!< Producer's last look at m_Tail
+		uint64_t m_Dropped; //!< Frames dropped so far
+		bool m_NeedsFullFrame; //!< Whether a frame was dropped since the last full frame
+
+		// Consumer side
+		alignas(64) std::atomic<size_t> m_Tail; //!< Next slot to be encoded; only the consumer writes it
+		std::atomic<bool> m_Stop; //!< Tells the writer to drain the ring and exit
+		std::exception_ptr m_Error; //!< First error the writer ran into
+
+		/** Handles a full ring according to m_Backpressure.
+		*
+		* \return Whether there is room now
+		*/
+		bool WaitForRoom(size_t head);
+
+		/** Waits until the writer has encoded every queued frame. */
+		void Drain(void);
+
+		/** Body of the writer thread. */
+		void WriterMain(void);
+	};
+}
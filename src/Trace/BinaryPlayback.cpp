@@ -0,0 +1,272 @@
+#include "Trace/BinaryPlayback.hpp"
+
+#include <string.h>
+
+#include <stdexcept>
+
+// Project libs
+#include "Trace/BinaryRecord.hpp"
+
+Trace::BinaryPlayback::BinaryPlayback(std::string filename) :
+	m_Filename(filename),
+	m_Format(TRACE_FORMAT_V0),
+	m_Pos(0),
+	m_BlockFrame(0),
+	m_HasIndex(false)
+{
+	if ((m_Filename.size() < 4) || (m_Filename.compare(m_Filename.size() - 4, 4, ".btr") != 0))
+		m_Filename.append(".btr");
+
+	m_File = std::make_unique<MappedFile>(m_Filename);
+
+	const uint8_t *p = Peek(2);
+	if (!p)
+		Corrupt();
+	m_Format = p[0];
+	m_Pos = 2;
+	if ((m_Format != TRACE_FORMAT_V0) && (m_Format != TRACE_FORMAT_V1))
+		throw std::runtime_error("unknown version of trace file " + m_Filename);
+
+	memset(&m_State, 0, sizeof(m_State));
+	m_Block.count = 0;
+
+	if (m_Format == TRACE_FORMAT_V1)
+		ReadIndex();
+}
+
+bool Trace::BinaryPlayback::Next(FrameView &frame)
+{
+	if (m_Format == TRACE_FORMAT_V0)
+		return NextV0(frame);
+	else
+		return NextV1(frame);
+}
+
+bool Trace::BinaryPlayback::Seek(uint32_t number, FrameView &frame, uint8_t *memory)
+{
+	// Start from the last keyframe at or before the frame, or else from the
+	// beginning
+	size_t k = m_Keyframes.size();
+	while ((k > 0) && (m_Keyframes[k - 1].number > number))
+		k--;
+
+	memset(&m_State, 0, sizeof(m_State));
+	bool found = false;
+	if (k > 0) {
+		SeekFile(m_Keyframes[k - 1].offset);
+		const uint8_t *p = Peek(TRACE_BLOCK_HEADER_SIZE);
+		if (!p)
+			Corrupt();
+		size_t size = (size_t)GetLE(p + 9, 4);
+		if ((p[0] != TRACE_BLOCK_TYPE_KEYFRAME) || !(p = Peek(TRACE_BLOCK_HEADER_SIZE + size)))
+			Corrupt();
+
+		Frame state;
+		if (!DecodeKeyframe(p + TRACE_BLOCK_HEADER_SIZE, size, state, memory))
+			Corrupt();
+		m_State.number = (uint32_t)GetLE(p + 1, 4);
+		m_State.a = state.a;
+		m_State.x = state.x;
+		m_State.y = state.y;
+		m_State.p = state.p;
+		m_State.s = state.s;
+		m_State.pc = state.pc;
+		m_Pos += TRACE_BLOCK_HEADER_SIZE + size;
+		found = true;
+	} else {
+		SeekFile(2);
+		memset(memory, 0, 0x10000);
+	}
+
+	// Replay up to the frame
+	FrameView next;
+	uint32_t peek;
+	while (PeekNumber(peek) && (peek <= number)) {
+		Next(next);
+		for (size_t i = 0; i < next.writecount; i++)
+			memory[next.writes[i].addr] = next.writes[i].val;
+		m_State = next;
+		found = true;
+	}
+
+	frame = m_State;
+	frame.writes = nullptr;
+	frame.writecount = 0;
+	return found;
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void Trace::BinaryPlayback::SeekFile(uint64_t offset)
+{
+	m_Pos = offset;
+	m_Block.count = 0;
+	m_BlockFrame = 0;
+}
+
+void Trace::BinaryPlayback::ReadIndex(void)
+{
+	// A trace that wasn't closed properly has no index; it can still be read
+	// from the start
+	uint64_t filesize = m_File->GetSize();
+	if (filesize < 2 + TRACE_BLOCK_HEADER_SIZE + TRACE_INDEX_TRAILER_SIZE)
+		return;
+	const uint8_t *p = m_File->Map(filesize - TRACE_INDEX_TRAILER_SIZE, TRACE_INDEX_TRAILER_SIZE);
+	if (memcmp(p + 8, TRACE_INDEX_MAGIC, 4) != 0)
+		return;
+
+	uint64_t offset = GetLE(p, 8);
+	if ((offset < 2) || (offset > filesize - TRACE_BLOCK_HEADER_SIZE - TRACE_INDEX_TRAILER_SIZE))
+		Corrupt();
+	p = m_File->Map(offset, (size_t)(filesize - offset));
+	if (!p)
+		Corrupt();
+
+	uint32_t count = (uint32_t)GetLE(p + 5, 4);
+	if ((p[0] != TRACE_BLOCK_TYPE_INDEX) || (GetLE(p + 9, 4) != filesize - offset - TRACE_BLOCK_HEADER_SIZE) ||
+		((uint64_t)count * 12 != filesize - offset - TRACE_BLOCK_HEADER_SIZE - TRACE_INDEX_TRAILER_SIZE))
+		Corrupt();
+
+	p += TRACE_BLOCK_HEADER_SIZE;
+	m_Keyframes.resize(count);
+	for (uint32_t i = 0; i < count; i++, p += 12) {
+		m_Keyframes[i].number = (uint32_t)GetLE(p, 4);
+		m_Keyframes[i].offset = GetLE(p + 4, 8);
+		if ((m_Keyframes[i].offset >= offset) || ((i > 0) && (m_Keyframes[i].number < m_Keyframes[i - 1].number)))
+			Corrupt();
+	}
+	m_HasIndex = true;
+}
+
+bool Trace::BinaryPlayback::PeekNumber(uint32_t &number)
+{
+	if (m_Format == TRACE_FORMAT_V0) {
+		const uint8_t *p = Peek(6);
+		if (!p)
+			return false;
+		number = (uint32_t)GetLE(p, 4);
+		return true;
+	}
+
+	if (!LoadBlock())
+		return false;
+	number = m_Block.number[m_BlockFrame];
+	return true;
+}
+
+bool Trace::BinaryPlayback::LoadBlock(void)
+{
+	while (m_BlockFrame >= m_Block.count) {
+		const uint8_t *p = Peek(TRACE_BLOCK_HEADER_SIZE);
+		if (!p) {
+			if (m_Pos != m_File->GetSize())
+				Corrupt();
+			return false;
+		}
+
+		uint32_t first = (uint32_t)GetLE(p + 1, 4);
+		uint32_t count = (uint32_t)GetLE(p + 5, 4);
+		size_t size = (size_t)GetLE(p + 9, 4);
+		if (!(p = Peek(TRACE_BLOCK_HEADER_SIZE + size)))
+			Corrupt();
+
+		// Start reading the next block from disk while this one decodes
+		m_File->Prefetch(m_Pos + TRACE_BLOCK_HEADER_SIZE + size, TRACE_BLOCK_HEADER_SIZE + size);
+
+		// Keyframes are only needed for seeking, and unknown block types are
+		// skipped, so newer writers can add their own
+		if (p[0] == TRACE_BLOCK_TYPE_FRAMES) {
+			if (!DecodeBlock(p + TRACE_BLOCK_HEADER_SIZE, size, first, count, m_Block))
+				Corrupt();
+			m_BlockFrame = 0;
+		}
+		m_Pos += TRACE_BLOCK_HEADER_SIZE + size;
+	}
+	return true;
+}
+
+bool Trace::BinaryPlayback::NextV0(FrameView &frame)
+{
+	// Frame header: 4 byte frame number, 2 byte length of the rest
+	const uint8_t *p = Peek(6);
+	if (!p) {
+		if (m_Pos != m_File->GetSize())
+			Corrupt();
+		return false;
+	}
+
+	uint32_t number = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+	m_Writes.clear();
+
+	// Continuation frames repeat the frame number, so keep reading until it
+	// changes
+	for (;;) {
+		size_t length = p[4] | (p[5] << 8);
+		if ((length == 0) || !(p = Peek(6 + length)))
+			Corrupt();
+		const uint8_t *end = p + 6 + length;
+		p += 6;
+
+		uint8_t mask = *p++;
+		size_t regsize = ((mask & 0x20) ? 2 : 0);
+		for (unsigned int bit = 0; bit < 5; bit++)
+			regsize += (mask >> bit) & 1;
+		if ((mask & 0xC0) || (regsize > (size_t)(end - p)) || (((end - p) - regsize) % 3))
+			Corrupt();
+
+		if (mask & 0x01) m_State.a = *p++;
+		if (mask & 0x02) m_State.x = *p++;
+		if (mask & 0x04) m_State.y = *p++;
+		if (mask & 0x08) m_State.p = *p++;
+		if (mask & 0x10) m_State.s = *p++;
+		if (mask & 0x20) {
+			m_State.pc = (uint16_t)(p[0] | (p[1] << 8));
+			p += 2;
+		}
+
+		while (p < end) {
+			MemoryWrite w;
+			w.addr = (uint16_t)(p[0] | (p[1] << 8));
+			w.val = p[2];
+			m_Writes.push_back(w);
+			p += 3;
+		}
+		m_Pos += 6 + length;
+
+		if (!(p = Peek(6)))
+			break;
+		if ((p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) != number)
+			break;
+	}
+
+	m_State.number = number;
+	frame = m_State;
+	frame.writes = m_Writes.data();
+	frame.writecount = m_Writes.size();
+	return true;
+}
+
+bool Trace::BinaryPlayback::NextV1(FrameView &frame)
+{
+	if (!LoadBlock())
+		return false;
+
+	uint32_t i = m_BlockFrame++;
+	frame.number = m_Block.number[i];
+	frame.a = m_Block.a[i];
+	frame.x = m_Block.x[i];
+	frame.y = m_Block.y[i];
+	frame.p = m_Block.p[i];
+	frame.s = m_Block.s[i];
+	frame.pc = m_Block.pc[i];
+	frame.writes = m_Block.writes.data() + m_Block.writestart[i];
+	frame.writecount = m_Block.writestart[i + 1] - m_Block.writestart[i];
+	return true;
+}
+
+void Trace::BinaryPlayback::Corrupt(void) const
+{
+	throw std::runtime_error("trace file " + m_Filename + " is corrupt or truncated");
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Project libs
+#include "Trace/Columnar.hpp"
+#include "Trace/Frame.hpp"
+#include "Trace/MappedFile.hpp"
+
+namespace Trace {
+	/** One frame read back from a trace.
+	*
+	* Unlike \ref Frame, the registers always hold the full machine state (the
+	* reader carries unchanged registers over from the previous frame) and the
+	* writes point into the reader's own storage, so a frame is never copied.
+	* A view is only valid until the next call to BinaryPlayback::Next().
+	*/
+	struct FrameView {
+		uint32_t number; //!< Frame number; the instruction count
+		uint8_t a; //!< Accumulator
+		uint8_t x; //!< X index
+		uint8_t y; //!< Y index
+		uint8_t p; //!< Processor status flags
+		uint8_t s; //!< Stack pointer
+		uint16_t pc; //!< Program counter
+		const MemoryWrite *writes; //!< Memory changes made during the frame, in order
+		size_t writecount; //!< Number of entries in <tt>writes</tt>
+	};
+
+	/** \class BinaryPlayback
+	* Reads back a binary trace written by \ref BinaryRecord.
+	*
+	* The file is read through a \ref MappedFile, so frames are decoded
+	* straight from the mapping without being read into a buffer first, and
+	* the next block is prefetched while the current one is decoded.
+	*
+	* Both versions of the format are read. Version 0 continuation frames are
+	* joined back into the frame they belong to, and version 1 blocks are
+	* decoded a whole block at a time, so Next() is usually just an index
+	* into already decoded columns.
+	*
+	* Seek() jumps to any frame. With a version 1 trace that has an index, it
+	* loads the nearest keyframe before the frame and replays at most a block
+	* or so of frames from there; otherwise it has to replay from the start.
+	*/
+	class BinaryPlayback
+	{
+	public:
+		/** Opens a trace file and reads its header.
+		*
+		* \param[in] filename File to read; ".btr" is appended if it isn't
+		* already there
+		*
+		* \throws std::runtime_error if the file can't be opened or isn't a
+		* trace of a known version
+		*/
+		BinaryPlayback(std::string filename);
+
+		/** Reads the next frame.
+		*
+		* \param[out] frame Receives the frame; see \ref FrameView
+		*
+		* \return false at the end of the trace
+		*
+		* \throws std::runtime_error if the trace is corrupt or truncated
+		*/
+		bool Next(FrameView &frame);
+
+		/** Moves to a frame and rebuilds the machine state there.
+		*
+		* Afterwards, <tt>frame</tt> holds the registers as of the last frame
+		* numbered <tt>number</tt> or lower, <tt>memory</tt> holds memory
+		* after that frame, and Next() carries on with the frame after it.
+		* The writes in <tt>frame</tt> are not set.
+		*
+		* \param[in] number Frame number to move to
+		* \param[out] frame Receives the registers
+		* \param[out] memory Receives all 64KB of memory
+		*
+		* \return false if the trace has no frame numbered <tt>number</tt> or
+		* lower
+		*
+		* \throws std::runtime_error if the trace is corrupt or truncated
+		*/
+		bool Seek(uint32_t number, FrameView &frame, uint8_t *memory);
+
+		/** Returns whether the trace has a keyframe index. */
+		bool HasIndex(void) const { return m_HasIndex; }
+
+		/** Returns the keyframes listed in the index, in frame order. */
+		const std::vector<KeyframeEntry> &GetKeyframes(void) const { return m_Keyframes; }
+
+		/** Returns the size of the trace file, in bytes. */
+		uint64_t GetFileSize(void) const { return m_File->GetSize(); }
+
+		/** Returns when the trace file was last modified. \see MappedFile::GetModifiedTime */
+		uint64_t GetFileModifiedTime(void) const { return m_File->GetModifiedTime(); }
+
+		/** Returns the major version of the trace, TRACE_FORMAT_V0 or TRACE_FORMAT_V1. */
+		uint8_t GetFormat(void) const { return m_Format; }
+
+	protected:
+	private:
+		std::string m_Filename; //!< Filename of the trace file
+		std::unique_ptr<MappedFile> m_File; //!< The trace file, mapped
+		uint8_t m_Format; //!< Major version of the trace
+		uint64_t m_Pos; //!< File offset of the next unread byte
+
+		FrameView m_State; //!< Registers of the last frame returned
+		std::vector<MemoryWrite> m_Writes; //!< Writes of the current version 0 frame
+
+		DecodedBlock m_Block; //!< Current version 1 block
+		uint32_t m_BlockFrame; //!< Index of the next frame in m_Block
+
+		bool m_HasIndex; //!< Whether the trace ends with an index
+		std::vector<KeyframeEntry> m_Keyframes; //!< Keyframes listed in the index
+
+		/** Returns a pointer to the <tt>size</tt> bytes at m_Pos, valid until the next call.
+		*
+		* \return nullptr if the file ends first
+		*/
+		const uint8_t *Peek(size_t size) { return m_File->Map(m_Pos, size); }
+
+		/** Moves to <tt>offset</tt> and forgets the current block. */
+		void SeekFile(uint64_t offset);
+
+		/** Reads the index at the end of a version 1 trace, if it has one. */
+		void ReadIndex(void);
+
+		/** Returns the number of the frame Next() would return.
+		*
+		* \return false at the end of the trace
+		*/
+		bool PeekNumber(uint32_t &number);
+
+		/** Decodes the next block of frames, skipping other blocks.
+		*
+		* \return false at the end of the trace
+		*/
+		bool LoadBlock(void);
+
+		/** Reads a version 0 frame, joining continuation frames. */
+		bool NextV0(FrameView &frame);
+
+		/** Reads a version 1 frame, decoding the next block when needed. */
+		bool NextV1(FrameView &frame);
+
+		/** Throws the error for a corrupt trace. */
+		[[noreturn]] void Corrupt(void) const;
+	};
+}
@@ -1,14 +1,64 @@
 #include "Trace/BinaryRecord.hpp"
 
-Trace::BinaryRecord::BinaryRecord(std::string filename) :
-	m_Filename(filename)
+#include <string.h>
+
+#include <stdexcept>
+
+// Format (version 0.1), all values little-endian:
+// 0x0000: 2 byte: file major, minor version
+// then any number of frames:
+// 0x0000: 4 byte: frame number (instruction count)
+// 0x0004: 2 byte: length of the rest of the frame
+// cpu state:
+//  1 byte: identifier for register(s):
+//   0x01: a
+//   0x02: x
+//   0x04: y
+//   0x08: p
+//   0x10: s
+//   0x20: pc
+//   ? bytes: list of changed values for registers, in above order
+// list of changed memory locations:
+//  2 byte: address
+//  1 byte: value
+//
+// What we end up with is something like:
+// 0x01 0x00 0x00 0x00 0x08 0x00 0x01 0x3F 0x00 0x00 0xFF 0x01 0x00 0x01
+//
+// The above is example data, which is:
+// frame 1, register a has value 0x3F now, address 0x0000 has 0xFF and 0x0001 has 0x01.
+//
+// If more memory changed than fits in the 16-bit length, the rest follows in
+// more frames with the same frame number and no registers; applying frames in
+// order gives the right result either way.
+//
+// Version 1.0 is described in BinaryRecord.hpp and Columnar.hpp. The index
+// block at the end is:
+//  for each keyframe: 4 byte frame number, 8 byte offset of its block
+//  8 byte: offset of the index block itself
+//  4 byte: TRACE_INDEX_MAGIC
+
+Trace::BinaryRecord::BinaryRecord(std::string filename, uint8_t format) :
+	m_Format(format),
+	m_Filename(filename),
+	m_Buffer(BUFFER_SIZE),
+	m_BufferUsed(0),
+	m_FirstFrame(true),
+	m_FileOffset(0),
+	m_FramesSinceKeyframe(0)
 {
 	// Throw if the filename is blank
 	if (m_Filename.empty())
-		throw;
+		throw std::invalid_argument("trace filename is empty");
+	if ((format != TRACE_FORMAT_V0) && (format != TRACE_FORMAT_V1))
+		throw std::invalid_argument("unknown trace format");
+
+	memset(&m_OldState, 0, sizeof(m_OldState));
+	memset(&m_LastFrame, 0, sizeof(m_LastFrame));
 
 	// Allocate the memory snapshot
 	m_OldMemory = std::make_unique<std::vector<uint8_t>>(0x10000, 0x00);
+	m_DiffWrites.resize(0x10000);
 
 	// Append the extension and open the file
 	std::string appendedfilename;
@@ -17,130 +67,289 @@ Trace::BinaryRecord::BinaryRecord(std::string filename) :
 	m_File = std::make_unique<std::ofstream>(appendedfilename, std::ios::binary | std::ios::trunc);
 
 	if (!m_File->good())
-		throw;
-
-	*m_File << m_FileMajorVersion << m_FileMinorVersion;
+		throw std::runtime_error("could not open trace file " + appendedfilename);
 
-	if (!m_File->good())
-		throw;
+	m_Buffer[m_BufferUsed++] = m_Format;
+	m_Buffer[m_BufferUsed++] = (m_Format == TRACE_FORMAT_V0) ? 0x01 : 0x00; // minor version
 }
 
 Trace::BinaryRecord::~BinaryRecord()
 {
+	// Destructors can't throw, so a failed write is lost here
+	try {
+		Close();
+	}
+	catch (...) {
+	}
+}
+
+void Trace::BinaryRecord::Close(void)
+{
+	if (!m_File->is_open())
+		return;
+
+	WriteBlock();
+
+	if (m_Format == TRACE_FORMAT_V1) {
+		// Index: each keyframe's number and offset, then the index's own
+		// offset and the magic, so it can be found from the end of the file
+		m_Block.clear();
+		m_Block.resize(TRACE_BLOCK_HEADER_SIZE);
+		for (size_t i = 0; i < m_Keyframes.size(); i++) {
+			PutLE(m_Block, m_Keyframes[i].number, 4);
+			PutLE(m_Block, m_Keyframes[i].offset, 8);
+		}
+		PutLE(m_Block, m_FileOffset + m_BufferUsed, 8);
+		m_Block.insert(m_Block.end(), TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC + 4);
+		PutBlockHeader(TRACE_BLOCK_TYPE_INDEX, 0, (uint32_t)m_Keyframes.size());
+		WriteRaw();
+	}
+
+	Flush();
 	m_File->close();
 }
 
-// TODO: Write the "native" values to the file instead of stuffing them into a buffer.
-void Trace::BinaryRecord::Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, std::shared_ptr<std::vector<uint8_t>> mem)
+void Trace::BinaryRecord::Flush(void)
 {
+	WriteBlock();
+	if (m_BufferUsed) {
+		m_File->write(reinterpret_cast<const char*>(m_Buffer.data()), m_BufferUsed);
+		m_FileOffset += m_BufferUsed;
+		m_BufferUsed = 0;
+	}
+	m_File->flush();
+
 	if (!m_File->good())
-		throw; // TODO: throw something specific
-
-	// Format:
-	// 0x0000: 4 byte: frame number (instruction count)
-	// 0x0004: 2 byte: length (not including frame number)
-	// cpu state:
-	//  1 byte: identifier for register(s):
-	//   0x01: a
-	//   0x02: x
-	//   0x04: y
-	//   0x08: p
-	//   0x10: s
-	//   0x20: pc
-	//   ? bytes: list of changed values for registers, in above order
-	// list of changed memory locations:
-	//  2 byte: address
-	//  1 byte: value
-	//
-	// What we end up with is something like:
-	// 0x00 0x00 0x00 0x01 0x00 0x08 0x01 0x3F 0x00 0x00 0xFF 0x00 0x01 0x01
-	//
-	// The above is example data, which is:
-	// frame 1, register a has value 0x3F now, address 0x0000 has 0xFF and 0x0001 has 0x01.
-
-	std::vector<uint8_t> buf(196622); // maximum frame size, assuming 14 + (65536*3) bytes per frame
-	unsigned len = 0; // length of the frame
+		throw std::runtime_error("could not write to trace file " + m_Filename);
+}
 
-	uint8_t RegsModified = 0; // Which registers have been modified
+void Trace::BinaryRecord::Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem)
+{
+	WriteKeyframe();
 
-	// We build the buffer as we go
-	//HACK: more little endian writing
-	buf[0] = instructioncount&0xff;
-	buf[1] = (instructioncount >> 8) & 0xff;
-	buf[2] = (instructioncount >> 16) & 0xff;
-	buf[3] = (instructioncount >> 24) & 0xff;
-	len += 7; // incrementing the length on each write
+	// Compare memory. Most instructions change a byte or two, so whole chunks
+	// are compared first and only the ones that differ are scanned.
+	uint8_t *old = m_OldMemory->data();
+	MemoryWrite *writes = m_DiffWrites.data();
+	size_t count = 0;
+	for (unsigned int chunk = 0; chunk < 0x10000; chunk += COMPARE_CHUNK) {
+		if (memcmp(mem + chunk, old + chunk, COMPARE_CHUNK) == 0)
+			continue;
 
-	// Compare registers
-	if (a != m_OldState.a) {
-		RegsModified |= 0b00000001;
-		buf[len]= a;
-		len++;
-		m_OldState.a = a;
+		for (unsigned int i = chunk; i < chunk + COMPARE_CHUNK; i++) {
+			if (mem[i] == old[i])
+				continue;
+			writes[count].addr = (uint16_t)i;
+			writes[count].val = mem[i];
+			count++;
+		}
+		memcpy(old + chunk, mem + chunk, COMPARE_CHUNK);
 	}
-	if (a != m_OldState.x) {
-		RegsModified |= 0b00000010;
-		buf[len] = x;
-		len++;
-		m_OldState.x = x;
+
+	Frame frame;
+	frame.number = instructioncount;
+	frame.a = a;
+	frame.x = x;
+	frame.y = y;
+	frame.p = p;
+	frame.s = s;
+	frame.pc = pc;
+	Encode(frame, writes, count);
+}
+
+void Trace::BinaryRecord::Snap(const Frame &frame)
+{
+	WriteKeyframe();
+
+	// Keep the snapshot current for the other overload, and for keyframes
+	uint8_t *old = m_OldMemory->data();
+	for (unsigned int i = 0; i < frame.writecount; i++)
+		old[frame.writes[i].addr] = frame.writes[i].val;
+
+	Encode(frame, frame.writes, frame.writecount);
+}
+
+void Trace::BinaryRecord::Encode(const Frame &frame, const MemoryWrite *writes, size_t count)
+{
+	m_LastFrame.number = frame.number;
+	m_LastFrame.a = frame.a;
+	m_LastFrame.x = frame.x;
+	m_LastFrame.y = frame.y;
+	m_LastFrame.p = frame.p;
+	m_LastFrame.s = frame.s;
+	m_LastFrame.pc = frame.pc;
+	m_FramesSinceKeyframe++;
+
+	if (m_Format == TRACE_FORMAT_V0) {
+		EncodeV0(frame, writes, count);
+		return;
 	}
-	if (a != m_OldState.y) {
-		RegsModified |= 0b00000100;
-		buf[len] = y;
-		len++;
-		m_OldState.y = y;
+
+	m_Encoder.Add(frame, writes, count);
+	if (m_Encoder.IsFull())
+		WriteBlock();
+}
+
+void Trace::BinaryRecord::EncodeV0(const Frame &frame, const MemoryWrite *writes, size_t count)
+{
+	// Make sure the whole frame fits, so nothing below has to check
+	Reserve(count*3 + ((count / MAX_FRAME_WRITES) + 1) * 14);
+
+	size_t start = BeginFrame(frame.number);
+	uint8_t *buf = m_Buffer.data();
+	EncodeRegisters(frame.a, frame.x, frame.y, frame.p, frame.s, frame.pc);
+
+	size_t inframe = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (inframe == MAX_FRAME_WRITES) {
+			EndFrame(start);
+			start = BeginFrame(frame.number);
+			buf[m_BufferUsed++] = 0; // no registers
+			inframe = 0;
+		}
+
+		buf[m_BufferUsed++] = (uint8_t)(writes[i].addr & 0xff);
+		buf[m_BufferUsed++] = (uint8_t)((writes[i].addr >> 8) & 0xff);
+		buf[m_BufferUsed++] = writes[i].val;
+		inframe++;
 	}
-	if (a != m_OldState.p) {
-		RegsModified |= 0b00001000;
-		buf[len] = p;
-		len++;
-		m_OldState.p = p;
+
+	EndFrame(start);
+}
+
+void Trace::BinaryRecord::WriteBlock(void)
+{
+	if (m_Encoder.GetFrameCount() == 0)
+		return;
+
+	uint32_t first = m_Encoder.GetFirstFrame();
+	uint32_t count = m_Encoder.GetFrameCount();
+
+	m_Block.clear();
+	m_Block.resize(TRACE_BLOCK_HEADER_SIZE);
+	m_Encoder.Finish(m_Block);
+	PutBlockHeader(TRACE_BLOCK_TYPE_FRAMES, first, count);
+	WriteRaw();
+}
+
+void Trace::BinaryRecord::WriteKeyframe(void)
+{
+	// Keyframes only go between blocks. The start of the trace doesn't need
+	// one, since the first frame stores all of memory anyway.
+	if ((m_Format != TRACE_FORMAT_V1) || (m_Encoder.GetFrameCount() != 0))
+		return;
+	if (m_FramesSinceKeyframe < TRACE_KEYFRAME_INTERVAL)
+		return;
+
+	KeyframeEntry entry;
+	entry.number = m_LastFrame.number;
+	entry.offset = m_FileOffset + m_BufferUsed;
+	m_Keyframes.push_back(entry);
+
+	m_Block.clear();
+	m_Block.resize(TRACE_BLOCK_HEADER_SIZE);
+	EncodeKeyframe(m_LastFrame, m_OldMemory->data(), m_Block);
+	PutBlockHeader(TRACE_BLOCK_TYPE_KEYFRAME, m_LastFrame.number, 0);
+	WriteRaw();
+
+	m_FramesSinceKeyframe = 0;
+}
+
+void Trace::BinaryRecord::WriteRaw(void)
+{
+	// The file header is still in the buffer before the first block
+	if (m_BufferUsed) {
+		m_File->write(reinterpret_cast<const char*>(m_Buffer.data()), m_BufferUsed);
+		m_FileOffset += m_BufferUsed;
+		m_BufferUsed = 0;
+	}
+	m_File->write(reinterpret_cast<const char*>(m_Block.data()), m_Block.size());
+	m_FileOffset += m_Block.size();
+
+	if (!m_File->good())
+		throw std::runtime_error("could not write to trace file " + m_Filename);
+}
+
+void Trace::BinaryRecord::PutBlockHeader(uint8_t type, uint32_t first, uint32_t count)
+{
+	uint32_t size = (uint32_t)(m_Block.size() - TRACE_BLOCK_HEADER_SIZE);
+	const uint32_t fields[3] = { first, count, size };
+	m_Block[0] = type;
+	for (unsigned int f = 0; f < 3; f++)
+		for (unsigned int b = 0; b < 4; b++)
+			m_Block[1 + f*4 + b] = (uint8_t)((fields[f] >> (b*8)) & 0xff);
+}
+
+void Trace::BinaryRecord::Reserve(size_t size)
+{
+	if (BUFFER_SIZE - m_BufferUsed >= size)
+		return;
+
+	m_File->write(reinterpret_cast<const char*>(m_Buffer.data()), m_BufferUsed);
+	m_FileOffset += m_BufferUsed;
+	m_BufferUsed = 0;
+	if (!m_File->good())
+		throw std::runtime_error("could not write to trace file " + m_Filename);
+}
+
+void Trace::BinaryRecord::EncodeRegisters(uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc)
+{
+	uint8_t *buf = m_Buffer.data();
+	size_t mask = m_BufferUsed++;
+	uint8_t RegsModified = 0; // Which registers have been modified
+
+	// Compare registers
+	if (m_FirstFrame || (a != m_OldState.a)) {
+		RegsModified |= 0x01;
+		buf[m_BufferUsed++] = a;
 	}
-	if (a != m_OldState.s) {
-		RegsModified |= 0b00010000;
-		buf[len] = s;
-		len++;
-		m_OldState.s = s;
+	if (m_FirstFrame || (x != m_OldState.x)) {
+		RegsModified |= 0x02;
+		buf[m_BufferUsed++] = x;
 	}
-	if (a != m_OldState.pc) {
-		RegsModified |= 0b00100000;
-		buf[len] = (pc&0xff); // more little endian writing
-		buf[len + 1] = ((pc >> 8) & 0xff);
-		len += 2;
-		m_OldState.pc = pc;
+	if (m_FirstFrame || (y != m_OldState.y)) {
+		RegsModified |= 0x04;
+		buf[m_BufferUsed++] = y;
 	}
-
-	buf[7] = RegsModified;
-
-	// Compare memory
-	//for (unsigned i = 0; i < 0x10000; i++) {
-	//for (std::vector<uint8_t>::iterator it = mem.begin(); it != mem.end(); ++it) {
-	for (unsigned i = 0; i < 0x10000; i++) {
-		if ((*mem)[i] != (*m_OldMemory)[i]) {
-			// TODO: Figure out how to write the address natively
-			// although it might not be portable.
-			// writing it in little endian for now
-			buf[len] = (uint8_t)(i & 0xff);
-			len++;
-			buf[len] = (uint8_t)((i >> 8) & 0xff);
-			len++;
-			buf[len] = (*mem)[i];
-			len++;
-		}
-		m_OldMemory->at(i) = (*mem)[i];
+	if (m_FirstFrame || (p != m_OldState.p)) {
+		RegsModified |= 0x08;
+		buf[m_BufferUsed++] = p;
+	}
+	if (m_FirstFrame || (s != m_OldState.s)) {
+		RegsModified |= 0x10;
+		buf[m_BufferUsed++] = s;
+	}
+	if (m_FirstFrame || (pc != m_OldState.pc)) {
+		RegsModified |= 0x20;
+		buf[m_BufferUsed++] = (uint8_t)(pc & 0xff);
+		buf[m_BufferUsed++] = (uint8_t)((pc >> 8) & 0xff);
 	}
+	buf[mask] = RegsModified;
 
-	// len should now be at the appropriate length for this frame
-	// so let's actually update the length byte and write it
-	// doing it little-endian manually again.
-	buf[4] = (len & 0xff);
-	buf[5] = ((len >> 8) & 0xff);
-	len += 2;
-	for (unsigned i = 0; i < len; i++)
-		*m_File << buf[i];
+	m_OldState.a = a;
+	m_OldState.x = x;
+	m_OldState.y = y;
+	m_OldState.p = p;
+	m_OldState.s = s;
+	m_OldState.pc = pc;
+	m_FirstFrame = false;
+}
 
-	m_File->flush();
+size_t Trace::BinaryRecord::BeginFrame(uint32_t instructioncount)
+{
+	size_t start = m_BufferUsed;
+	uint8_t *buf = m_Buffer.data() + start;
+	buf[0] = (uint8_t)(instructioncount & 0xff);
+	buf[1] = (uint8_t)((instructioncount >> 8) & 0xff);
+	buf[2] = (uint8_t)((instructioncount >> 16) & 0xff);
+	buf[3] = (uint8_t)((instructioncount >> 24) & 0xff);
+	m_BufferUsed += 6; // length is filled in by EndFrame()
+	return start;
+}
 
-	if (!m_File->good())
-		throw;
-}
\ No newline at end of file
+void Trace::BinaryRecord::EndFrame(size_t start)
+{
+	size_t len = m_BufferUsed - (start + 6);
+	m_Buffer[start + 4] = (uint8_t)(len & 0xff);
+	m_Buffer[start + 5] = (uint8_t)((len >> 8) & 0xff);
+}
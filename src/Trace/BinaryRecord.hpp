@@ -1,11 +1,30 @@
 #pragma once
 
 // Standard libs
+#include <stdint.h>
+
 #include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
 
+// Project libs
+#include "Trace/Columnar.hpp"
+#include "Trace/Frame.hpp"
+#include "Trace/Recorder.hpp"
+
+#define TRACE_FORMAT_V0 0 //!< Row-wise frames; see BinaryRecord.cpp
+#define TRACE_FORMAT_V1 1 //!< Compressed, columnar blocks of frames; see Columnar.hpp
+
+#define TRACE_BLOCK_HEADER_SIZE 13 //!< Size of a version 1 block header: type, first frame, frame count, payload size
+#define TRACE_BLOCK_TYPE_FRAMES 0x01 //!< Version 1 block holding frames
+#define TRACE_BLOCK_TYPE_KEYFRAME 0x02 //!< Version 1 block holding the full machine state
+#define TRACE_BLOCK_TYPE_INDEX 0x03 //!< Version 1 block listing the keyframes; always the last block
+
+#define TRACE_KEYFRAME_INTERVAL 65536 //!< Fewest frames between keyframes
+#define TRACE_INDEX_MAGIC "BTRX" //!< Last 4 bytes of a trace that has an index
+#define TRACE_INDEX_TRAILER_SIZE 12 //!< Size of the end of the index: its offset, then TRACE_INDEX_MAGIC
+
 namespace Trace {
 	/** \class BinaryRecord
 	* The System65 CPU emulator execution tracing class, utilizing binary output
@@ -24,6 +43,30 @@ namespace Trace {
 	* of the binary format is to compact data as much as possible in order to
 	* minimize the disk footprint.
 	*
+	* Two formats can be written. Version 0 stores each frame as a row: frame
+	* number, length, changed registers and memory writes. Frames are encoded
+	* straight into a large output buffer that is reused for the whole session,
+	* and the buffer is only written to the file once it can't be guaranteed
+	* to hold another frame.
+	*
+	* Version 1, the default, gathers up to TRACE_BLOCK_FRAMES frames into a
+	* block, stores each field as its own delta-coded, Huffman-compressed column
+	* (see \ref BlockEncoder), and writes each block with a single write. A
+	* version 1 file is the two version bytes followed by blocks, each with a
+	* TRACE_BLOCK_HEADER_SIZE byte header: block type, first frame number,
+	* frame count and payload size, all little-endian.
+	*
+	* Every TRACE_KEYFRAME_INTERVAL frames or so, a version 1 trace also gets a
+	* keyframe block just before a block of frames. It holds the registers and
+	* all of memory as of the frame before the block, so a reader can start
+	* from there instead of the beginning of the file. Close() finishes the
+	* file with an index block listing the number and file offset of each
+	* keyframe. The index ends with its own offset and TRACE_INDEX_MAGIC, so a
+	* reader can find it from the end of the file.
+	*
+	* In either format, call Flush() before reading a trace that is still
+	* being recorded.
+	*
 	* \todo Get TraceRecord and TracePlayback to derive from the same base; the
 	* constructor and destructors can be part of the base, as well as a few of the
 	* members, but Snap() would be implemented independently because playback
@@ -34,7 +77,7 @@ namespace Trace {
 	* System65 object? Do I have a separate method for setting callbacks and require
 	* getters? Do I just pass all 9 arguments every time?
 	*/
-	class BinaryRecord
+	class BinaryRecord : public Recorder
 	{
 	public:
 		/** Initializes the trace recording.
@@ -43,20 +86,40 @@ namespace Trace {
 		* Tracing is done to <tt>filename</tt>.
 		*
 		* \param[in] filename File to record to; an extension is not needed.
+		* \param[in] format TRACE_FORMAT_V0 or TRACE_FORMAT_V1
 		*
-		* \throws Passes any throws related to file handling.
+		* \throws std::invalid_argument if <tt>filename</tt> is empty or
+		* <tt>format</tt> is unknown
+		* \throws std::runtime_error if the file can't be opened
 		*/
-		BinaryRecord(std::string filename = "trace");
+		BinaryRecord(std::string filename = "trace", uint8_t format = TRACE_FORMAT_V1);
 
-		/** Terminates the tracing session.
+		/** Terminates the tracing session, writing out any buffered frames.
+		*
+		* Call Close() first to find out whether that worked.
 		*/
 		~BinaryRecord();
 
+		/** Writes out any buffered frames and the index, and closes the file.
+		*
+		* Nothing can be recorded afterwards. Calling it again does nothing.
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void Close(void) override;
+
+		/** Writes any buffered frames to the file.
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void Flush(void);
+
 		/** Traces through a single step of execution.
 		*
 		* This method records the machine state, indexed on
-		* <tt>instructioncount</tt>. The caller should provide callback pointers to
-		* methods that return the necessary information about the current machine state.
+		* <tt>instructioncount</tt>. Only the registers and memory locations that
+		* changed since the previous call are stored; the first frame stores every
+		* register.
 		*
 		* \param[in] instructioncount The number of instructions that have been
 		* executed up to this point.
@@ -66,19 +129,52 @@ namespace Trace {
 		* \param[in] p Current value of the processor flags register
 		* \param[in] s Current value of the stack pointer
 		* \param[in] pc Current value of the program counter
-		* \param[in] memcb Callback function pointer for reading the VM's memory
+		* \param[in] mem The VM's memory, 64KB
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem) override;
+
+		/** Traces through a single step of execution, from a write log.
+		*
+		* Unlike the other overload, memory isn't compared; the memory delta
+		* is just the writes recorded in <tt>frame</tt>, so the cost doesn't
+		* depend on the size of memory. The first frame of a trace, and any
+		* frame whose write log overflowed, should go through the other
+		* overload instead.
+		*
+		* \param[in] frame Registers and memory writes of the frame
+		*
+		* \throws std::runtime_error if the file can't be written
 		*/
-		void Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, std::shared_ptr<std::vector<uint8_t>> mem);
+		void Snap(const Frame &frame) override;
 
 	protected:
 	private:
-		const uint8_t m_FileMajorVersion = 0x00; //!< Major version of the binary file format
-		const uint8_t m_FileMinorVersion = 0x00; //!< Minor version of the binary file format
+		uint8_t m_Format; //!< Major version of the binary file format, TRACE_FORMAT_V0 or TRACE_FORMAT_V1
+
+		static const size_t BUFFER_SIZE = 4 * 1024 * 1024; //!< Size of the output buffer
+		static const size_t MAX_FRAME_WRITES = (0xFFFF - 8) / 3; //!< Most memory changes that fit in one frame's 16-bit length
+		static const size_t COMPARE_CHUNK = 64; //!< Bytes of memory compared at a time when looking for changes
 
 		std::string m_Filename; //!< Filename of the trace file
 
 		std::unique_ptr<std::ofstream> m_File; //!< Output file for the trace stream
 
+		std::vector<uint8_t> m_Buffer; //!< Encoded frames that haven't been written yet
+		size_t m_BufferUsed; //!< Number of bytes of m_Buffer in use
+
+		bool m_FirstFrame; //!< Whether the next frame is the first; it records every register
+
+		std::vector<MemoryWrite> m_DiffWrites; //!< Memory changes found by the full-memory Snap(); kept to avoid reallocating
+		BlockEncoder m_Encoder; //!< Block being built, for version 1
+		std::vector<uint8_t> m_Block; //!< Encoded block, for version 1; kept to avoid reallocating
+
+		uint64_t m_FileOffset; //!< Bytes written to the file so far
+		Frame m_LastFrame; //!< Number and registers of the last frame encoded
+		uint32_t m_FramesSinceKeyframe; //!< Frames encoded since the last keyframe, or since the start
+		std::vector<KeyframeEntry> m_Keyframes; //!< Keyframes written so far, for the index
+
 		/** Struct representing the old state of the CPU (state on the previous recorded frame). */
 		struct {
 			uint8_t a;
@@ -89,6 +185,42 @@ namespace Trace {
 			uint16_t pc;
 		} m_OldState;
 
+		/** Encodes a frame in the file's format. */
+		void Encode(const Frame &frame, const MemoryWrite *writes, size_t count);
+
+		/** Encodes a frame as version 0 rows. */
+		void EncodeV0(const Frame &frame, const MemoryWrite *writes, size_t count);
+
+		/** Writes out the block being built, if it has any frames. */
+		void WriteBlock(void);
+
+		/** Writes a keyframe if a new block is about to start and one is due.
+		*
+		* This has to be called before m_OldMemory takes in the next frame.
+		*/
+		void WriteKeyframe(void);
+
+		/** Writes m_Block to the file, after anything still in m_Buffer. */
+		void WriteRaw(void);
+
+		/** Fills in the header at the start of m_Block. */
+		void PutBlockHeader(uint8_t type, uint32_t first, uint32_t count);
+
+		/** Makes sure a frame of up to <tt>size</tt> bytes fits in the buffer. */
+		void Reserve(size_t size);
+
+		/** Appends the register mask and changed registers to the buffer. */
+		void EncodeRegisters(uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc);
+
+		/** Starts a frame at the end of the buffer.
+		*
+		* \return Offset of the frame in m_Buffer
+		*/
+		size_t BeginFrame(uint32_t instructioncount);
+
+		/** Fills in the length of the frame that starts at <tt>start</tt>. */
+		void EndFrame(size_t start);
+
 		std::unique_ptr<std::vector<uint8_t>> m_OldMemory; //!< Snapshot of memory from the last call of Snap().
 	};
 }
\ No newline at end of file
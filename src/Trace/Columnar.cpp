@@ -0,0 +1,285 @@
+#include "Trace/Columnar.hpp"
+
+#include <string.h>
+
+#include "Trace/Huffman.hpp"
+
+// Block payload: for each column, in Column order:
+//  varint: raw size of the column
+//  1 byte: 0 if the column is stored as is, 1 if it is Huffman coded
+//  varint: size of what follows
+//  the column itself
+
+namespace {
+	const unsigned int REG_COUNT = 5;
+
+	enum Coding {
+		CODING_STORED = 0,
+		CODING_HUFFMAN = 1
+	};
+
+	/** Decoded columns plus a little padding, so varint reads can't run off the end. */
+	const size_t COLUMN_PADDING = 8;
+
+	/** Appends a column, Huffman coded if that makes it smaller. */
+	void PutColumn(std::vector<uint8_t> &out, const uint8_t *col, size_t size)
+	{
+		static thread_local std::vector<uint8_t> packed;
+
+		Trace::PutVarint(out, (uint32_t)size);
+
+		packed.clear();
+		if (size > HUFFMAN_HEADER_SIZE)
+			Trace::Huffman::Encode(col, size, packed);
+
+		if (!packed.empty() && (packed.size() < size)) {
+			out.push_back(CODING_HUFFMAN);
+			Trace::PutVarint(out, (uint32_t)packed.size());
+			out.insert(out.end(), packed.begin(), packed.end());
+		} else {
+			out.push_back(CODING_STORED);
+			Trace::PutVarint(out, (uint32_t)size);
+			out.insert(out.end(), col, col + size);
+		}
+	}
+
+	/** Reads a column written by PutColumn(); <tt>data</tt> is left after it.
+	*
+	* The column is unpacked into <tt>col</tt>, followed by COLUMN_PADDING
+	* zero bytes.
+	*
+	* \throws std::runtime_error if its sizes run past <tt>end</tt>
+	*/
+	bool GetColumn(const uint8_t *&data, const uint8_t *end, std::vector<uint8_t> &col)
+	{
+		uint32_t rawsize = Trace::GetVarint(data, end);
+		if (data >= end)
+			throw std::runtime_error("column runs past the end of its block");
+		uint8_t coding = *data++;
+		uint32_t packedsize = Trace::GetVarint(data, end);
+		if ((size_t)(end - data) < packedsize)
+			return false;
+
+		// Every Huffman code is at least a bit long, so a corrupt size can't
+		// make it allocate more than the packed data could hold
+		if (coding == CODING_STORED) {
+			if (packedsize != rawsize)
+				return false;
+		} else if (coding == CODING_HUFFMAN) {
+			if ((uint64_t)rawsize > (uint64_t)packedsize * 8)
+				return false;
+		} else {
+			return false;
+		}
+
+		col.resize(rawsize + COLUMN_PADDING);
+		memset(col.data() + rawsize, 0, COLUMN_PADDING);
+		if (coding == CODING_STORED) {
+			memcpy(col.data(), data, rawsize);
+		} else if (!Trace::Huffman::Decode(data, packedsize, col.data(), rawsize)) {
+			return false;
+		}
+		data += packedsize;
+		return true;
+	}
+
+	/** Returns the number of varints in a column, i.e. bytes that end one. */
+	size_t CountVarints(const std::vector<uint8_t> &col)
+	{
+		size_t n = 0;
+		for (size_t i = 0; i < col.size() - COLUMN_PADDING; i++)
+			n += (col[i] < 0x80);
+		return n;
+	}
+}
+
+//------------------------------------------------------------------------------
+// BlockEncoder
+//------------------------------------------------------------------------------
+
+Trace::BlockEncoder::BlockEncoder() :
+	m_First(0),
+	m_Count(0),
+	m_LastFrame(0),
+	m_LastPC(0),
+	m_LastAddr(0)
+{
+	memset(m_LastRegs, 0, sizeof(m_LastRegs));
+}
+
+void Trace::BlockEncoder::Add(const Frame &frame, const MemoryWrite *writes, size_t count)
+{
+	const uint8_t regs[REG_COUNT] = { frame.a, frame.x, frame.y, frame.p, frame.s };
+
+	if (m_Count == 0) {
+		m_First = frame.number;
+		m_LastFrame = frame.number - 1;
+		m_LastPC = 0;
+		m_LastAddr = 0;
+	}
+
+	PutVarint(m_Columns[COLUMN_FRAME], frame.number - m_LastFrame - 1);
+	PutVarint(m_Columns[COLUMN_PC], ZigZag((int16_t)(frame.pc - m_LastPC)));
+
+	uint8_t mask = 0;
+	for (unsigned int i = 0; i < REG_COUNT; i++) {
+		if ((m_Count == 0) || (regs[i] != m_LastRegs[i])) {
+			mask |= (uint8_t)(1 << i);
+			m_Columns[COLUMN_REGS].push_back(regs[i]);
+			m_LastRegs[i] = regs[i];
+		}
+	}
+	m_Columns[COLUMN_MASK].push_back(mask);
+
+	PutVarint(m_Columns[COLUMN_WCOUNT], (uint32_t)count);
+	for (size_t i = 0; i < count; i++) {
+		PutVarint(m_Columns[COLUMN_WADDR], ZigZag((int16_t)(writes[i].addr - m_LastAddr)));
+		m_Columns[COLUMN_WVAL].push_back(writes[i].val);
+		m_LastAddr = writes[i].addr;
+	}
+
+	m_LastFrame = frame.number;
+	m_LastPC = frame.pc;
+	m_Count++;
+}
+
+void Trace::BlockEncoder::Finish(std::vector<uint8_t> &out)
+{
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+		PutColumn(out, m_Columns[c].data(), m_Columns[c].size());
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+		m_Columns[c].clear();
+	m_Count = 0;
+}
+
+//------------------------------------------------------------------------------
+// Decoding
+//------------------------------------------------------------------------------
+
+bool Trace::DecodeBlock(const uint8_t *data, size_t size, uint32_t first, uint32_t count, DecodedBlock &block)
+{
+	// Unpack every column into its own buffer
+	static thread_local std::vector<uint8_t> columns[COLUMN_COUNT];
+	const uint8_t *end = data + size;
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++) {
+		if (!GetColumn(data, end, columns[c]))
+			return false;
+	}
+
+	block.count = count;
+	block.number.resize(count);
+	block.pc.resize(count);
+	block.a.resize(count);
+	block.x.resize(count);
+	block.y.resize(count);
+	block.p.resize(count);
+	block.s.resize(count);
+	block.writestart.resize(count + 1);
+	block.writes.clear();
+
+	const uint8_t *frames = columns[COLUMN_FRAME].data();
+	const uint8_t *pcs = columns[COLUMN_PC].data();
+	const uint8_t *masks = columns[COLUMN_MASK].data();
+	const uint8_t *regs = columns[COLUMN_REGS].data();
+	const uint8_t *wcounts = columns[COLUMN_WCOUNT].data();
+	const uint8_t *waddrs = columns[COLUMN_WADDR].data();
+	const uint8_t *wvals = columns[COLUMN_WVAL].data();
+	const uint8_t *regsend = regs + columns[COLUMN_REGS].size() - COLUMN_PADDING;
+	const uint8_t *wvalsend = wvals + columns[COLUMN_WVAL].size() - COLUMN_PADDING;
+
+	// Checking the column lengths up front means the loop below can't read
+	// past the end of a column, even if the data is corrupt
+	size_t totalwrites = wvalsend - wvals;
+	if ((columns[COLUMN_MASK].size() - COLUMN_PADDING != count) ||
+		(CountVarints(columns[COLUMN_FRAME]) != count) ||
+		(CountVarints(columns[COLUMN_PC]) != count) ||
+		(CountVarints(columns[COLUMN_WCOUNT]) != count) ||
+		(CountVarints(columns[COLUMN_WADDR]) != totalwrites))
+		return false;
+	block.writes.resize(totalwrites);
+
+	uint32_t number = first - 1;
+	uint16_t pc = 0, addr = 0;
+	uint8_t a = 0, x = 0, y = 0, p = 0, s = 0;
+	uint32_t nwrites = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		number += GetVarint(frames) + 1;
+		pc = (uint16_t)(pc + UnZigZag(GetVarint(pcs)));
+
+		uint8_t mask = masks[i];
+		if (regs + 5 > regsend) {
+			unsigned int needed = 0;
+			for (unsigned int r = 0; r < REG_COUNT; r++)
+				needed += (mask >> r) & 1;
+			if (regs + needed > regsend)
+				return false;
+		}
+		if (mask & 0x01) a = *regs++;
+		if (mask & 0x02) x = *regs++;
+		if (mask & 0x04) y = *regs++;
+		if (mask & 0x08) p = *regs++;
+		if (mask & 0x10) s = *regs++;
+
+		block.number[i] = number;
+		block.pc[i] = pc;
+		block.a[i] = a;
+		block.x[i] = x;
+		block.y[i] = y;
+		block.p[i] = p;
+		block.s[i] = s;
+		block.writestart[i] = nwrites;
+
+		uint32_t wcount = GetVarint(wcounts);
+		if (wcount > (size_t)(wvalsend - wvals))
+			return false;
+		for (uint32_t w = 0; w < wcount; w++) {
+			addr = (uint16_t)(addr + UnZigZag(GetVarint(waddrs)));
+			block.writes[nwrites].addr = addr;
+			block.writes[nwrites].val = *wvals++;
+			nwrites++;
+		}
+	}
+	block.writestart[count] = nwrites;
+
+	return (nwrites == block.writes.size());
+}
+
+//------------------------------------------------------------------------------
+// Keyframes
+//------------------------------------------------------------------------------
+
+void Trace::EncodeKeyframe(const Frame &state, const uint8_t *memory, std::vector<uint8_t> &out)
+{
+	out.push_back(state.a);
+	out.push_back(state.x);
+	out.push_back(state.y);
+	out.push_back(state.p);
+	out.push_back(state.s);
+	PutLE(out, state.pc, 2);
+	PutColumn(out, memory, 0x10000);
+}
+
+bool Trace::DecodeKeyframe(const uint8_t *data, size_t size, Frame &state, uint8_t *memory)
+{
+	static thread_local std::vector<uint8_t> column;
+	const uint8_t *end = data + size;
+
+	if (size < 7)
+		return false;
+	state.a = data[0];
+	state.x = data[1];
+	state.y = data[2];
+	state.p = data[3];
+	state.s = data[4];
+	state.pc = (uint16_t)GetLE(data + 5, 2);
+	state.writecount = 0;
+	state.overflow = false;
+	state.interrupt = TRACE_INTERRUPT_NONE;
+	data += 7;
+
+	if (!GetColumn(data, end, column) || (column.size() - COLUMN_PADDING != 0x10000))
+		return false;
+	memcpy(memory, column.data(), 0x10000);
+	return true;
+}
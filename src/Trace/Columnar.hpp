@@ -0,0 +1,209 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <stdexcept>
+#include <vector>
+
+// Project libs
+#include "Trace/Frame.hpp"
+
+/** \file Columnar.hpp
+ * Encoder and decoder for blocks of the version 1 trace format.
+ */
+
+#define TRACE_BLOCK_FRAMES 65536 //!< Most frames in one block
+#define TRACE_BLOCK_WRITES (1024 * 1024) //!< Once a block holds this many memory writes, it is closed early
+
+namespace Trace {
+	/** Columns of a block, in the order they are stored. */
+	enum Column {
+		COLUMN_FRAME, //!< Varint: frame number minus the previous one, minus one
+		COLUMN_PC, //!< Zigzag varint: PC minus the previous PC
+		COLUMN_MASK, //!< Byte: which of A, X, Y, P, S changed (bits 0-4)
+		COLUMN_REGS, //!< Byte: the registers that changed, in mask order
+		COLUMN_WCOUNT, //!< Varint: number of memory writes in the frame
+		COLUMN_WADDR, //!< Zigzag varint: write address minus the previous write address
+		COLUMN_WVAL, //!< Byte: value written
+		COLUMN_COUNT //!< Number of columns
+	};
+
+	/** Appends <tt>val</tt> as an LEB128 varint. */
+	inline void PutVarint(std::vector<uint8_t> &out, uint32_t val)
+	{
+		while (val >= 0x80) {
+			out.push_back((uint8_t)(val | 0x80));
+			val >>= 7;
+		}
+		out.push_back((uint8_t)val);
+	}
+
+	/** Reads an LEB128 varint; <tt>p</tt> is left after it.
+	*
+	* Nothing stops it reading up to 5 bytes, so the data has to be padded or
+	* known to hold the varint.
+	*/
+	inline uint32_t GetVarint(const uint8_t *&p)
+	{
+		uint32_t val = *p & 0x7F;
+		if (*p++ & 0x80) {
+			unsigned int shift = 7;
+			do {
+				val |= (uint32_t)(*p & 0x7F) << shift;
+				shift += 7;
+			} while ((*p++ & 0x80) && (shift < 35));
+		}
+		return val;
+	}
+
+	/** Reads an LEB128 varint that has to end before <tt>end</tt>; <tt>p</tt> is left after it.
+	*
+	* \throws std::runtime_error if the varint runs past <tt>end</tt>
+	*/
+	inline uint32_t GetVarint(const uint8_t *&p, const uint8_t *end)
+	{
+		uint32_t val = 0;
+		unsigned int shift = 0;
+		uint8_t byte;
+		do {
+			if (p >= end)
+				throw std::runtime_error("varint runs past the end of its data");
+			byte = *p++;
+			val |= (uint32_t)(byte & 0x7F) << shift;
+			shift += 7;
+		} while ((byte & 0x80) && (shift < 35));
+		return val;
+	}
+
+	/** Appends the low <tt>bytes</tt> bytes of <tt>val</tt>, little-endian. */
+	inline void PutLE(std::vector<uint8_t> &out, uint64_t val, unsigned int bytes)
+	{
+		for (unsigned int i = 0; i < bytes; i++)
+			out.push_back((uint8_t)(val >> (i * 8)));
+	}
+
+	/** Reads a <tt>bytes</tt> byte little-endian value. */
+	inline uint64_t GetLE(const uint8_t *p, unsigned int bytes)
+	{
+		uint64_t val = 0;
+		for (unsigned int i = 0; i < bytes; i++)
+			val |= (uint64_t)p[i] << (i * 8);
+		return val;
+	}
+
+	/** Maps a signed value to unsigned so small magnitudes stay small. */
+	inline uint32_t ZigZag(int32_t val) { return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31); }
+
+	/** Inverse of ZigZag(). */
+	inline int32_t UnZigZag(uint32_t val) { return (int32_t)(val >> 1) ^ -(int32_t)(val & 1); }
+
+	/** \class BlockEncoder
+	* Collects frames and encodes them as one block of the version 1 format.
+	*
+	* Frames are split into columns as they are added (see \ref Column). Each
+	* column is delta or varint coded so that typical values are small, then
+	* compressed with \ref Huffman, unless that doesn't help. The first frame
+	* of every block stores all of its registers, and every delta starts over,
+	* so a block can be decoded without looking at any other block.
+	*/
+	class BlockEncoder
+	{
+	public:
+		BlockEncoder();
+
+		/** Adds a frame to the block.
+		*
+		* \param[in] frame Frame number and registers; its writes are ignored
+		* \param[in] writes Memory writes made during the frame
+		* \param[in] count Number of writes
+		*/
+		void Add(const Frame &frame, const MemoryWrite *writes, size_t count);
+
+		/** Returns the number of frames in the block. */
+		uint32_t GetFrameCount(void) const { return m_Count; }
+
+		/** Returns the number of the first frame in the block. */
+		uint32_t GetFirstFrame(void) const { return m_First; }
+
+		/** Returns whether the block should be written out before adding more. */
+		bool IsFull(void) const { return (m_Count >= TRACE_BLOCK_FRAMES) || (m_Columns[COLUMN_WVAL].size() >= TRACE_BLOCK_WRITES); }
+
+		/** Encodes the block and starts a new one.
+		*
+		* \param[out] out Vector to append the encoded payload to
+		*/
+		void Finish(std::vector<uint8_t> &out);
+
+	private:
+		std::vector<uint8_t> m_Columns[COLUMN_COUNT]; //!< Raw column data for the block so far
+		uint32_t m_First; //!< Number of the first frame
+		uint32_t m_Count; //!< Number of frames
+		uint32_t m_LastFrame; //!< Number of the last frame added
+		uint16_t m_LastPC; //!< PC of the last frame added
+		uint16_t m_LastAddr; //!< Address of the last write added
+		uint8_t m_LastRegs[5]; //!< A, X, Y, P and S of the last frame added
+	};
+
+	/** A decoded block, one array per field.
+	*
+	* Registers are stored in full for every frame, not just when they change.
+	* The writes of frame <tt>i</tt> are <tt>writes[writestart[i]]</tt> up to
+	* <tt>writes[writestart[i+1]]</tt>.
+	*/
+	struct DecodedBlock {
+		uint32_t count; //!< Number of frames
+		std::vector<uint32_t> number; //!< Frame numbers
+		std::vector<uint16_t> pc; //!< Program counter
+		std::vector<uint8_t> a; //!< Accumulator
+		std::vector<uint8_t> x; //!< X index
+		std::vector<uint8_t> y; //!< Y index
+		std::vector<uint8_t> p; //!< Processor status flags
+		std::vector<uint8_t> s; //!< Stack pointer
+		std::vector<uint32_t> writestart; //!< Index of each frame's first write; has count + 1 entries
+		std::vector<MemoryWrite> writes; //!< All writes of the block, in order
+	};
+
+	/** Decodes a block payload written by BlockEncoder::Finish().
+	*
+	* \param[in] data Payload
+	* \param[in] size Size of the payload in bytes
+	* \param[in] first Number of the first frame, from the block header
+	* \param[in] count Number of frames, from the block header
+	* \param[out] block Decoded frames; its vectors are reused between calls
+	*
+	* \return Whether the payload was valid
+	*
+	* \throws std::runtime_error if a column's sizes run past the payload
+	*/
+	bool DecodeBlock(const uint8_t *data, size_t size, uint32_t first, uint32_t count, DecodedBlock &block);
+
+	/** Where a keyframe is, as listed in the index at the end of a trace. */
+	struct KeyframeEntry {
+		uint32_t number; //!< Frame number the keyframe holds the state after
+		uint64_t offset; //!< Offset of the keyframe's block in the file
+	};
+
+	/** Encodes a keyframe payload: the registers and all of memory.
+	*
+	* \param[in] state Registers; the frame number and writes are ignored
+	* \param[in] memory All 64KB of memory
+	* \param[out] out Vector to append the payload to
+	*/
+	void EncodeKeyframe(const Frame &state, const uint8_t *memory, std::vector<uint8_t> &out);
+
+	/** Decodes a keyframe payload written by EncodeKeyframe().
+	*
+	* \param[in] data Payload
+	* \param[in] size Size of the payload
+	* \param[out] state Receives the registers; the frame number is left alone
+	* \param[out] memory Receives all 64KB of memory
+	*
+	* \return false if the payload is corrupt
+	*
+	* \throws std::runtime_error if the memory column's sizes run past the
+	* payload
+	*/
+	bool DecodeKeyframe(const uint8_t *data, size_t size, Frame &state, uint8_t *memory);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Standard libs
+#include <stdint.h>
+
+/** \file Frame.hpp
+ * Plain records describing one frame of a trace.
+ */
+
+#define TRACE_MAX_FRAME_WRITES 8 //!< Memory writes a Frame can hold; an instruction makes at most 3, plus 3 for an interrupt taken before it
+
+#define TRACE_INTERRUPT_NONE 0 //!< No interrupt was raised
+#define TRACE_INTERRUPT_IRQ 1 //!< A maskable interrupt was raised
+#define TRACE_INTERRUPT_NMI 2 //!< A non-maskable interrupt was raised
+
+namespace Trace {
+	/** A single write to guest memory. */
+	struct MemoryWrite {
+		uint16_t addr; //!< Address that was written
+		uint8_t val; //!< Value that was written
+	};
+
+	/** The externally visible effects of one frame (one retired instruction).
+	*
+	* This is filled in by the core as it runs: the registers are copied at the
+	* end of the frame, and System65::Memory_Write() appends to <tt>writes</tt>
+	* while a trace is being recorded. Since it has a fixed size, it can be
+	* copied around without allocating.
+	*/
+	struct Frame {
+		uint32_t number; //!< Frame number; the instruction count
+		uint8_t a; //!< Accumulator
+		uint8_t x; //!< X index
+		uint8_t y; //!< Y index
+		uint8_t p; //!< Processor status flags
+		uint8_t s; //!< Stack pointer
+		uint16_t pc; //!< Program counter
+		uint8_t writecount; //!< Number of entries used in <tt>writes</tt>
+		bool overflow; //!< Whether more writes happened than <tt>writes</tt> can hold
+		uint8_t interrupt; //!< Interrupt raised from outside the CPU just before the frame, whose effects are part of it; TRACE_INTERRUPT_NONE, TRACE_INTERRUPT_IRQ or TRACE_INTERRUPT_NMI
+		MemoryWrite writes[TRACE_MAX_FRAME_WRITES]; //!< Memory writes made during the frame, in order
+	};
+}
@@ -0,0 +1,208 @@
+#include "Trace/Huffman.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+void Trace::Huffman::Encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+	uint64_t freq[256] = {};
+	for (size_t i = 0; i < size; i++)
+		freq[data[i]]++;
+
+	uint8_t lengths[256];
+	uint16_t codes[256];
+	BuildLengths(freq, lengths);
+	BuildCodes(lengths, codes);
+
+	for (unsigned int i = 0; i < 256; i += 2)
+		out.push_back((uint8_t)(lengths[i] | (lengths[i + 1] << 4)));
+
+	uint64_t bits = 0;
+	unsigned int count = 0;
+	for (size_t i = 0; i < size; i++) {
+		bits |= (uint64_t)codes[data[i]] << count;
+		count += lengths[data[i]];
+		while (count >= 8) {
+			out.push_back((uint8_t)bits);
+			bits >>= 8;
+			count -= 8;
+		}
+	}
+	if (count)
+		out.push_back((uint8_t)bits);
+}
+
+bool Trace::Huffman::Decode(const uint8_t *in, size_t insize, uint8_t *out, size_t outsize)
+{
+	if (insize < HUFFMAN_HEADER_SIZE)
+		return false;
+
+	uint8_t lengths[256];
+	for (unsigned int i = 0; i < 256; i += 2) {
+		lengths[i] = in[i / 2] & 0x0F;
+		lengths[i + 1] = in[i / 2] >> 4;
+	}
+	in += HUFFMAN_HEADER_SIZE;
+	insize -= HUFFMAN_HEADER_SIZE;
+
+	uint16_t codes[256];
+	if (!BuildCodes(lengths, codes))
+		return false;
+
+	// Every index whose low bits match a code maps to that code's symbol
+	struct Entry {
+		uint8_t symbol;
+		uint8_t length;
+	} table[1 << HUFFMAN_MAX_BITS];
+	memset(table, 0, sizeof(table));
+	for (unsigned int sym = 0; sym < 256; sym++) {
+		if (!lengths[sym])
+			continue;
+		for (unsigned int idx = codes[sym]; idx < (1u << HUFFMAN_MAX_BITS); idx += (1u << lengths[sym])) {
+			table[idx].symbol = (uint8_t)sym;
+			table[idx].length = lengths[sym];
+		}
+	}
+
+	uint64_t bits = 0;
+	unsigned int count = 0;
+	size_t pos = 0;
+	for (size_t i = 0; i < outsize; i++) {
+		if (count < HUFFMAN_MAX_BITS) {
+			// Refill a whole word at a time when possible
+			if (pos + 8 <= insize) {
+				uint64_t word;
+				memcpy(&word, in + pos, 8);
+				bits |= word << count;
+				unsigned int take = (63 - count) >> 3;
+				pos += take;
+				count += take * 8;
+				bits &= (count < 64) ? (((uint64_t)1 << count) - 1) : ~(uint64_t)0;
+			} else {
+				while ((count <= 56) && (pos < insize)) {
+					bits |= (uint64_t)in[pos++] << count;
+					count += 8;
+				}
+			}
+		}
+
+		const Entry &e = table[bits & ((1u << HUFFMAN_MAX_BITS) - 1)];
+		if ((e.length == 0) || (e.length > count))
+			return false;
+		out[i] = e.symbol;
+		bits >>= e.length;
+		count -= e.length;
+	}
+
+	return true;
+}
+
+void Trace::Huffman::BuildLengths(const uint64_t freq[256], uint8_t lengths[256])
+{
+	memset(lengths, 0, 256);
+
+	std::vector<unsigned int> symbols;
+	for (unsigned int i = 0; i < 256; i++)
+		if (freq[i])
+			symbols.push_back(i);
+
+	if (symbols.empty())
+		return;
+	if (symbols.size() == 1) {
+		lengths[symbols[0]] = 1;
+		return;
+	}
+
+	// Plain Huffman; if the tree is too deep, flatten the histogram and retry
+	std::vector<uint64_t> weights(256);
+	for (unsigned int i = 0; i < 256; i++)
+		weights[i] = freq[i];
+
+	for (;;) {
+		// Nodes 0..255 are leaves, the rest are internal
+		std::vector<uint64_t> weight;
+		std::vector<int> parent;
+		std::vector<unsigned int> heap;
+		for (unsigned int sym : symbols) {
+			heap.push_back((unsigned int)weight.size());
+			weight.push_back(weights[sym]);
+			parent.push_back(-1);
+		}
+
+		auto cmp = [&weight](unsigned int l, unsigned int r) { return weight[l] > weight[r]; };
+		std::make_heap(heap.begin(), heap.end(), cmp);
+		while (heap.size() > 1) {
+			std::pop_heap(heap.begin(), heap.end(), cmp);
+			unsigned int l = heap.back();
+			heap.pop_back();
+			std::pop_heap(heap.begin(), heap.end(), cmp);
+			unsigned int r = heap.back();
+			heap.pop_back();
+
+			unsigned int node = (unsigned int)weight.size();
+			weight.push_back(weight[l] + weight[r]);
+			parent.push_back(-1);
+			parent[l] = parent[r] = (int)node;
+			heap.push_back(node);
+			std::push_heap(heap.begin(), heap.end(), cmp);
+		}
+
+		unsigned int maxlen = 0;
+		for (size_t i = 0; i < symbols.size(); i++) {
+			unsigned int len = 0;
+			for (int n = (int)i; parent[n] >= 0; n = parent[n])
+				len++;
+			lengths[symbols[i]] = (uint8_t)len;
+			maxlen = std::max(maxlen, len);
+		}
+
+		if (maxlen <= HUFFMAN_MAX_BITS)
+			return;
+
+		for (unsigned int sym : symbols)
+			weights[sym] = (weights[sym] >> 1) + 1;
+	}
+}
+
+bool Trace::Huffman::BuildCodes(const uint8_t lengths[256], uint16_t codes[256])
+{
+	unsigned int count[HUFFMAN_MAX_BITS + 1] = {};
+	for (unsigned int i = 0; i < 256; i++) {
+		if (lengths[i] > HUFFMAN_MAX_BITS)
+			return false;
+		count[lengths[i]]++;
+	}
+	count[0] = 0;
+
+	// Kraft inequality; over-subscribed lengths aren't a prefix code
+	unsigned int left = 1;
+	for (unsigned int len = 1; len <= HUFFMAN_MAX_BITS; len++) {
+		left <<= 1;
+		if (count[len] > left)
+			return false;
+		left -= count[len];
+	}
+
+	unsigned int next[HUFFMAN_MAX_BITS + 1];
+	unsigned int code = 0;
+	for (unsigned int len = 1; len <= HUFFMAN_MAX_BITS; len++) {
+		code = (code + count[len - 1]) << 1;
+		next[len] = code;
+	}
+
+	for (unsigned int sym = 0; sym < 256; sym++) {
+		unsigned int len = lengths[sym];
+		if (!len) {
+			codes[sym] = 0;
+			continue;
+		}
+		unsigned int c = next[len]++;
+		unsigned int rev = 0;
+		for (unsigned int b = 0; b < len; b++)
+			rev |= ((c >> b) & 1) << (len - 1 - b);
+		codes[sym] = (uint16_t)rev;
+	}
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#define HUFFMAN_MAX_BITS 12 //!< Longest code the coder will produce; also the size of the decoding table index
+#define HUFFMAN_HEADER_SIZE 128 //!< Bytes used to store the code lengths, 4 bits per symbol
+
+namespace Trace {
+	/** \class Huffman
+	* A canonical, length-limited Huffman coder for bytes.
+	*
+	* This is the entropy coder for the columnar trace format. Codes are limited
+	* to HUFFMAN_MAX_BITS bits so that decoding is a single table lookup per
+	* symbol. Only the code lengths are stored (HUFFMAN_HEADER_SIZE bytes); both
+	* sides rebuild the same canonical codes from them.
+	*
+	* Bits are packed least-significant first, with each code stored
+	* bit-reversed, so the decoder can index its table straight from the low
+	* bits of its bit buffer.
+	*/
+	class Huffman
+	{
+	public:
+		/** Compresses <tt>size</tt> bytes.
+		*
+		* \param[in] data Bytes to compress
+		* \param[in] size Number of bytes
+		* \param[out] out Vector to append the code lengths and bitstream to
+		*/
+		static void Encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+		/** Decompresses data written by Encode().
+		*
+		* \param[in] in Code lengths followed by the bitstream
+		* \param[in] insize Number of bytes available at <tt>in</tt>
+		* \param[out] out Buffer to decode into
+		* \param[in] outsize Number of bytes to decode
+		*
+		* \return Whether the data was valid
+		*/
+		static bool Decode(const uint8_t *in, size_t insize, uint8_t *out, size_t outsize);
+
+	private:
+		/** Works out length-limited code lengths for a histogram. */
+		static void BuildLengths(const uint64_t freq[256], uint8_t lengths[256]);
+
+		/** Assigns canonical codes, bit-reversed, from code lengths.
+		*
+		* \return Whether the lengths describe a valid prefix code
+		*/
+		static bool BuildCodes(const uint8_t lengths[256], uint16_t codes[256]);
+	};
+}
@@ -0,0 +1,174 @@
+#include "Trace/MappedFile.hpp"
+
+#include <stdexcept>
+
+#ifndef WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif // WIN32
+
+namespace {
+	/** Whether the whole file can be mapped at once. */
+	const bool MAP_WHOLE_FILE = (sizeof(void*) >= 8);
+}
+
+Trace::MappedFile::MappedFile(const std::string &filename) :
+	m_Filename(filename),
+	m_Size(0),
+	m_ModifiedTime(0),
+	m_View(nullptr),
+	m_ViewOffset(0),
+	m_ViewSize(0)
+{
+#ifdef WIN32
+	m_Mapping = NULL;
+	m_File = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("could not open " + filename);
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(m_File, &size)) {
+		::CloseHandle(m_File);
+		throw std::runtime_error("could not get the size of " + filename);
+	}
+	m_Size = (uint64_t)size.QuadPart;
+
+	FILETIME modified;
+	if (!::GetFileTime(m_File, NULL, NULL, &modified)) {
+		::CloseHandle(m_File);
+		throw std::runtime_error("could not get the modification time of " + filename);
+	}
+	m_ModifiedTime = ((uint64_t)modified.dwHighDateTime << 32) | modified.dwLowDateTime;
+
+	// An empty file can't be mapped, but there's nothing to read anyway
+	if (m_Size) {
+		m_Mapping = ::CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_Mapping == NULL) {
+			::CloseHandle(m_File);
+			throw std::runtime_error("could not map " + filename);
+		}
+	}
+#else
+	m_File = ::open(filename.c_str(), O_RDONLY);
+	if (m_File < 0)
+		throw std::runtime_error("could not open " + filename);
+
+	struct stat st;
+	if (::fstat(m_File, &st) != 0) {
+		::close(m_File);
+		throw std::runtime_error("could not get the size of " + filename);
+	}
+	m_Size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+	m_ModifiedTime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000 + (uint64_t)st.st_mtimespec.tv_nsec;
+#else
+	m_ModifiedTime = (uint64_t)st.st_mtim.tv_sec * 1000000000 + (uint64_t)st.st_mtim.tv_nsec;
+#endif // __APPLE__
+#endif // WIN32
+
+	if (MAP_WHOLE_FILE && m_Size) {
+		try {
+			MapView(0, (size_t)m_Size);
+		}
+		catch (...) {
+#ifdef WIN32
+			::CloseHandle(m_Mapping);
+			::CloseHandle(m_File);
+#else
+			::close(m_File);
+#endif // WIN32
+			throw;
+		}
+	}
+}
+
+Trace::MappedFile::~MappedFile()
+{
+	UnmapView();
+#ifdef WIN32
+	if (m_Mapping != NULL)
+		::CloseHandle(m_Mapping);
+	::CloseHandle(m_File);
+#else
+	::close(m_File);
+#endif // WIN32
+}
+
+void Trace::MappedFile::Prefetch(uint64_t offset, size_t size)
+{
+	if ((offset < m_ViewOffset) || (offset >= m_ViewOffset + m_ViewSize))
+		return;
+	if (size > m_ViewOffset + m_ViewSize - offset)
+		size = (size_t)(m_ViewOffset + m_ViewSize - offset);
+
+#ifdef WIN32
+	// PrefetchVirtualMemory() needs Windows 8; FILE_FLAG_SEQUENTIAL_SCAN
+	// already makes the cache manager read ahead
+	(void)size;
+#else
+	// madvise() wants a page-aligned start
+	uintptr_t start = (uintptr_t)(m_View + (offset - m_ViewOffset));
+	uintptr_t page = (uintptr_t)::sysconf(_SC_PAGESIZE);
+	uintptr_t aligned = start & ~(page - 1);
+	::madvise((void*)aligned, size + (start - aligned), MADV_WILLNEED);
+#endif // WIN32
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void Trace::MappedFile::MapView(uint64_t offset, size_t size)
+{
+	UnmapView();
+
+	// Views have to start on an allocation boundary
+#ifdef WIN32
+	SYSTEM_INFO info;
+	::GetSystemInfo(&info);
+	uint64_t granularity = info.dwAllocationGranularity;
+#else
+	uint64_t granularity = (uint64_t)::sysconf(_SC_PAGESIZE);
+#endif // WIN32
+	uint64_t start = offset - (offset % granularity);
+	uint64_t end = offset + size;
+	if (!MAP_WHOLE_FILE && (end - start < MAPPEDFILE_WINDOW))
+		end = start + MAPPEDFILE_WINDOW;
+	if (end > m_Size)
+		end = m_Size;
+
+#ifdef WIN32
+	void *view = ::MapViewOfFile(m_Mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF),
+		(SIZE_T)(end - start));
+	if (view == NULL)
+		throw std::runtime_error("could not map " + m_Filename);
+#else
+	void *view = ::mmap(NULL, (size_t)(end - start), PROT_READ, MAP_SHARED, m_File, (off_t)start);
+	if (view == MAP_FAILED)
+		throw std::runtime_error("could not map " + m_Filename);
+	::madvise(view, (size_t)(end - start), MADV_SEQUENTIAL);
+#endif // WIN32
+
+	m_View = static_cast<const uint8_t*>(view);
+	m_ViewOffset = start;
+	m_ViewSize = (size_t)(end - start);
+}
+
+void Trace::MappedFile::UnmapView(void)
+{
+	if (!m_View)
+		return;
+
+#ifdef WIN32
+	::UnmapViewOfFile(m_View);
+#else
+	::munmap(const_cast<uint8_t*>(m_View), m_ViewSize);
+#endif // WIN32
+
+	m_View = nullptr;
+	m_ViewOffset = 0;
+	m_ViewSize = 0;
+}
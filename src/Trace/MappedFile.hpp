@@ -0,0 +1,107 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#ifdef WIN32
+	#include <windows.h>
+#endif // WIN32
+
+#define MAPPEDFILE_WINDOW (64 * 1024 * 1024) //!< Size of the sliding view on 32-bit hosts
+
+namespace Trace {
+	/** \class MappedFile
+	* A read-only file mapped into memory.
+	*
+	* Readers ask for a range of the file with Map() and get a pointer straight
+	* into the page cache, so nothing is copied. On 64-bit hosts the whole
+	* file is mapped once. A 32-bit process can't map a trace of several GB,
+	* so there Map() slides a window of MAPPEDFILE_WINDOW bytes or so along
+	* the file instead, remapping whenever a range falls outside it.
+	*
+	* The mapping is made with a hint that the file will be read from start to
+	* end, and Prefetch() asks the OS to start reading a range ahead of time.
+	*
+	* \note The size of the file is taken when it's opened; anything appended
+	* later isn't seen.
+	*/
+	class MappedFile
+	{
+	public:
+		/** Opens and maps a file.
+		*
+		* \param[in] filename File to map
+		*
+		* \throws std::runtime_error if the file can't be opened or mapped
+		*/
+		MappedFile(const std::string &filename);
+
+		/** Unmaps and closes the file. */
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile &operator=(const MappedFile&) = delete;
+
+		/** Returns the size of the file, in bytes. */
+		uint64_t GetSize(void) const { return m_Size; }
+
+		/** Returns when the file was last modified.
+		*
+		* The value is only meant to be compared with another one from the
+		* same host: nanoseconds since the epoch on POSIX hosts, or a
+		* FILETIME on Windows.
+		*/
+		uint64_t GetModifiedTime(void) const { return m_ModifiedTime; }
+
+		/** Returns a pointer to <tt>size</tt> bytes of the file at <tt>offset</tt>.
+		*
+		* The pointer is only valid until the next call to Map().
+		*
+		* \return nullptr if the range goes past the end of the file
+		*
+		* \throws std::runtime_error if the range can't be mapped
+		*/
+		const uint8_t *Map(uint64_t offset, size_t size)
+		{
+			if ((offset > m_Size) || (size > m_Size - offset))
+				return nullptr;
+			if ((offset < m_ViewOffset) || (offset + size > m_ViewOffset + m_ViewSize))
+				MapView(offset, size);
+			return m_View + (offset - m_ViewOffset);
+		}
+
+		/** Hints that <tt>size</tt> bytes at <tt>offset</tt> will be read soon.
+		*
+		* Ranges past the end of the file, or outside the current view on a
+		* 32-bit host, are ignored.
+		*/
+		void Prefetch(uint64_t offset, size_t size);
+
+	protected:
+	private:
+		std::string m_Filename; //!< Name of the file, for errors
+		uint64_t m_Size; //!< Size of the file
+		uint64_t m_ModifiedTime; //!< Last modification time of the file \see GetModifiedTime
+
+		const uint8_t *m_View; //!< Start of the mapped view
+		uint64_t m_ViewOffset; //!< File offset of m_View
+		size_t m_ViewSize; //!< Size of the mapped view
+
+#ifdef WIN32
+		HANDLE m_File; //!< File handle
+		HANDLE m_Mapping; //!< File mapping object
+#else
+		int m_File; //!< File descriptor
+#endif // WIN32
+
+		/** Maps a view holding <tt>size</tt> bytes at <tt>offset</tt>, replacing the current one. */
+		void MapView(uint64_t offset, size_t size);
+
+		/** Unmaps the current view, if any. */
+		void UnmapView(void);
+	};
+}
+
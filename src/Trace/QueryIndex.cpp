@@ -0,0 +1,199 @@
+#include "Trace/QueryIndex.hpp"
+
+#include <string.h>
+
+#include <fstream>
+#include <stdexcept>
+
+// Project libs
+#include "Trace/BinaryPlayback.hpp"
+#include "Trace/Columnar.hpp"
+
+namespace {
+	const size_t TABLE_ENTRIES = 0x10000 + 1; //!< Entries in each table of list starts
+	const size_t TABLE_SIZE = TABLE_ENTRIES * 8; //!< Size of each table of list starts, in bytes
+
+	/** Writes <tt>count</tt> values to <tt>out</tt>, <tt>bytes</tt> bytes each, little-endian. */
+	template <typename T>
+	void WriteArray(std::ofstream &out, const T *vals, size_t count, unsigned int bytes)
+	{
+		std::vector<uint8_t> buf;
+		buf.reserve(64 * 1024);
+		for (size_t i = 0; i < count; i++) {
+			Trace::PutLE(buf, vals[i], bytes);
+			if (buf.size() >= 64 * 1024 - 8) {
+				out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+				buf.clear();
+			}
+		}
+		out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+	}
+}
+
+void Trace::QueryIndex::Build(const std::string &tracefile, const std::string &indexfile)
+{
+	// Count the writes to each address and the frames at each PC first, so
+	// the lists can be laid out back to back and filled in on a second pass
+	std::vector<uint64_t> writestart(TABLE_ENTRIES, 0);
+	std::vector<uint64_t> pcstart(TABLE_ENTRIES, 0);
+	uint64_t tracesize, tracetime;
+	{
+		BinaryPlayback playback(tracefile);
+		FrameView frame;
+		while (playback.Next(frame)) {
+			pcstart[frame.pc + 1]++;
+			for (size_t i = 0; i < frame.writecount; i++)
+				writestart[frame.writes[i].addr + 1]++;
+		}
+		tracesize = playback.GetFileSize();
+		tracetime = playback.GetFileModifiedTime();
+	}
+	for (size_t i = 1; i < TABLE_ENTRIES; i++) {
+		writestart[i] += writestart[i - 1];
+		pcstart[i] += pcstart[i - 1];
+	}
+	uint64_t writes = writestart[TABLE_ENTRIES - 1];
+	uint64_t frames = pcstart[TABLE_ENTRIES - 1];
+
+	std::vector<uint32_t> writeframes((size_t)writes);
+	std::vector<uint8_t> writevalues((size_t)writes);
+	std::vector<uint32_t> pcframes((size_t)frames);
+	{
+		std::vector<uint64_t> writepos(writestart.begin(), writestart.end() - 1);
+		std::vector<uint64_t> pcpos(pcstart.begin(), pcstart.end() - 1);
+		BinaryPlayback playback(tracefile);
+		FrameView frame;
+		while (playback.Next(frame)) {
+			pcframes[(size_t)pcpos[frame.pc]++] = frame.number;
+			for (size_t i = 0; i < frame.writecount; i++) {
+				size_t w = (size_t)writepos[frame.writes[i].addr]++;
+				writeframes[w] = frame.number;
+				writevalues[w] = frame.writes[i].val;
+			}
+		}
+	}
+
+	std::ofstream out(indexfile, std::ios::binary | std::ios::trunc);
+	if (!out.good())
+		throw std::runtime_error("could not open index file " + indexfile);
+
+	std::vector<uint8_t> header(QUERYINDEX_MAGIC, QUERYINDEX_MAGIC + 4);
+	PutLE(header, tracesize, 8);
+	PutLE(header, tracetime, 8);
+	PutLE(header, frames, 8);
+	PutLE(header, writes, 8);
+	out.write(reinterpret_cast<const char*>(header.data()), header.size());
+	WriteArray(out, writestart.data(), writestart.size(), 8);
+	WriteArray(out, pcstart.data(), pcstart.size(), 8);
+	WriteArray(out, writeframes.data(), writeframes.size(), 4);
+	out.write(reinterpret_cast<const char*>(writevalues.data()), writevalues.size());
+	WriteArray(out, pcframes.data(), pcframes.size(), 4);
+
+	out.close();
+	if (!out.good())
+		throw std::runtime_error("could not write index file " + indexfile);
+}
+
+Trace::QueryIndex::QueryIndex(const std::string &indexfile) :
+	m_File(std::make_unique<MappedFile>(indexfile)),
+	m_WriteStart(TABLE_ENTRIES),
+	m_PCStart(TABLE_ENTRIES)
+{
+	const uint8_t *p = m_File->Map(0, QUERYINDEX_HEADER_SIZE);
+	if (!p || (memcmp(p, QUERYINDEX_MAGIC, 4) != 0))
+		throw std::runtime_error(indexfile + " is not a trace index");
+	m_TraceSize = GetLE(p + 4, 8);
+	m_TraceModifiedTime = GetLE(p + 12, 8);
+	m_FrameCount = GetLE(p + 20, 8);
+	m_WriteCount = GetLE(p + 28, 8);
+
+	m_WriteFramesOffset = QUERYINDEX_HEADER_SIZE + 2 * TABLE_SIZE;
+	m_WriteValuesOffset = m_WriteFramesOffset + m_WriteCount * 4;
+	m_PCFramesOffset = m_WriteValuesOffset + m_WriteCount;
+	if (m_File->GetSize() != m_PCFramesOffset + m_FrameCount * 4)
+		throw std::runtime_error("trace index " + indexfile + " is corrupt or truncated");
+
+	// The tables are small enough to keep, and then every list can be
+	// checked against the file size once, here
+	p = m_File->Map(QUERYINDEX_HEADER_SIZE, 2 * TABLE_SIZE);
+	for (size_t i = 0; i < TABLE_ENTRIES; i++) {
+		m_WriteStart[i] = GetLE(p + i * 8, 8);
+		m_PCStart[i] = GetLE(p + TABLE_SIZE + i * 8, 8);
+		if (((i > 0) && ((m_WriteStart[i] < m_WriteStart[i - 1]) || (m_PCStart[i] < m_PCStart[i - 1]))) ||
+			(m_WriteStart[i] > m_WriteCount) || (m_PCStart[i] > m_FrameCount))
+			throw std::runtime_error("trace index " + indexfile + " is corrupt");
+	}
+	if ((m_WriteStart[TABLE_ENTRIES - 1] != m_WriteCount) || (m_PCStart[TABLE_ENTRIES - 1] != m_FrameCount))
+		throw std::runtime_error("trace index " + indexfile + " is corrupt");
+}
+
+bool Trace::QueryIndex::LastChange(uint16_t addr, uint32_t before, ValueChange &change)
+{
+	uint64_t start = m_WriteStart[addr];
+	size_t count = (size_t)(m_WriteStart[addr + 1] - start);
+	if (count == 0)
+		return false;
+
+	// Find the last write before the frame
+	const uint8_t *frames = m_File->Map(m_WriteFramesOffset + start * 4, count * 4);
+	size_t lo = 0, hi = count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if ((uint32_t)GetLE(frames + mid * 4, 4) < before)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return false;
+
+	// Then back up over writes of the same value
+	size_t i = lo - 1;
+	const uint8_t *values = m_File->Map(m_WriteValuesOffset + start, count);
+	while ((i > 0) && (values[i - 1] == values[i]))
+		i--;
+	change.value = values[i];
+
+	frames = m_File->Map(m_WriteFramesOffset + (start + i) * 4, 4);
+	change.frame = (uint32_t)GetLE(frames, 4);
+	return true;
+}
+
+void Trace::QueryIndex::History(uint16_t addr, std::vector<ValueChange> &history)
+{
+	history.clear();
+	uint64_t start = m_WriteStart[addr];
+	size_t count = (size_t)(m_WriteStart[addr + 1] - start);
+	if (count == 0)
+		return;
+
+	// Values first, then frames, since only one mapping is valid at a time
+	const uint8_t *values = m_File->Map(m_WriteValuesOffset + start, count);
+	std::vector<size_t> changes;
+	for (size_t i = 0; i < count; i++) {
+		if ((i == 0) || (values[i] != values[i - 1])) {
+			ValueChange c;
+			c.value = values[i];
+			c.frame = 0;
+			history.push_back(c);
+			changes.push_back(i);
+		}
+	}
+
+	const uint8_t *frames = m_File->Map(m_WriteFramesOffset + start * 4, count * 4);
+	for (size_t c = 0; c < changes.size(); c++)
+		history[c].frame = (uint32_t)GetLE(frames + changes[c] * 4, 4);
+}
+
+void Trace::QueryIndex::FramesAtPC(uint16_t pc, std::vector<uint32_t> &frames)
+{
+	uint64_t start = m_PCStart[pc];
+	size_t count = (size_t)(m_PCStart[pc + 1] - start);
+	frames.resize(count);
+	if (count == 0)
+		return;
+
+	const uint8_t *p = m_File->Map(m_PCFramesOffset + start * 4, count * 4);
+	for (size_t i = 0; i < count; i++)
+		frames[i] = (uint32_t)GetLE(p + i * 4, 4);
+}
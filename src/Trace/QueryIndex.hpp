@@ -0,0 +1,123 @@
+#pragma once
+
+// Standard libs
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Project libs
+#include "Trace/MappedFile.hpp"
+
+#define QUERYINDEX_MAGIC "BTX2" //!< First 4 bytes of a query index
+#define QUERYINDEX_HEADER_SIZE 36 //!< Size of the query index header: magic, trace size, trace modification time, frame count, write count
+
+namespace Trace {
+	/** A value written to an address, and the frame that wrote it. */
+	struct ValueChange {
+		uint32_t frame; //!< Frame number
+		uint8_t value; //!< Value written
+	};
+
+	/** \class QueryIndex
+	* A side index of a trace for answering questions about it quickly.
+	*
+	* Build() reads a trace once and writes a .btx file that lists, for every
+	* address, the frames that wrote to it and the values written, and for
+	* every PC value, the frames that ended with PC there. Each list is sorted
+	* by frame number, so a question about one address or PC is a binary
+	* search or a scan of just that list, read straight from a
+	* \ref MappedFile, instead of a decode of the whole trace.
+	*
+	* The index file is laid out as follows, all values little-endian:
+	*  - QUERYINDEX_HEADER_SIZE byte header: QUERYINDEX_MAGIC, size of the
+	*    trace file (8 bytes), modification time of the trace file (8 bytes,
+	*    \see MappedFile::GetModifiedTime), number of frames (8 bytes), number
+	*    of writes (8 bytes)
+	*  - 65537 8-byte entries: index of the first write to each address in
+	*    the write lists below, then the number of writes
+	*  - 65537 8-byte entries: the same for PC values, into the PC list
+	*  - frame number of each write (4 bytes each), grouped by address
+	*  - value of each write (1 byte each), in the same order
+	*  - frame number of each frame (4 bytes each), grouped by PC
+	*
+	* \note Memory that the trace records as changing because it was compared,
+	* rather than logged (the first frame, and frames after dropped ones),
+	* only has the bytes that actually changed.
+	*/
+	class QueryIndex
+	{
+	public:
+		/** Builds an index for a trace.
+		*
+		* \param[in] tracefile Trace to index; the extension can be left out
+		* \param[in] indexfile Index file to (over)write
+		*
+		* \throws std::runtime_error if the trace can't be read or the index
+		* can't be written
+		*/
+		static void Build(const std::string &tracefile, const std::string &indexfile);
+
+		/** Opens an index.
+		*
+		* \param[in] indexfile Index file written by Build()
+		*
+		* \throws std::runtime_error if the file can't be opened or isn't an
+		* index
+		*/
+		QueryIndex(const std::string &indexfile);
+
+		/** Returns the size of the trace file the index was built from. */
+		uint64_t GetTraceSize(void) const { return m_TraceSize; }
+
+		/** Returns the modification time of the trace file the index was built from. */
+		uint64_t GetTraceModifiedTime(void) const { return m_TraceModifiedTime; }
+
+		/** Returns the number of frames in the trace. */
+		uint64_t GetFrameCount(void) const { return m_FrameCount; }
+
+		/** Finds the last time an address changed before a frame.
+		*
+		* Writes that stored the value the address already held are not
+		* changes, so the frame returned is the first of any run of them.
+		*
+		* \param[in] addr Address to look up
+		* \param[in] before Frame number; only earlier frames are considered
+		* \param[out] change Receives the frame and the new value
+		*
+		* \return false if the address wasn't written before <tt>before</tt>
+		*/
+		bool LastChange(uint16_t addr, uint32_t before, ValueChange &change);
+
+		/** Lists every change to an address, in frame order.
+		*
+		* \param[in] addr Address to look up
+		* \param[out] history Receives the changes
+		*/
+		void History(uint16_t addr, std::vector<ValueChange> &history);
+
+		/** Lists the frames that ended with PC at <tt>pc</tt>, in frame order.
+		*
+		* \param[in] pc PC value to look up
+		* \param[out] frames Receives the frame numbers
+		*/
+		void FramesAtPC(uint16_t pc, std::vector<uint32_t> &frames);
+
+	protected:
+	private:
+		std::unique_ptr<MappedFile> m_File; //!< The index file, mapped
+		uint64_t m_TraceSize; //!< Size of the trace file the index was built from
+		uint64_t m_TraceModifiedTime; //!< Modification time of the trace file the index was built from
+		uint64_t m_FrameCount; //!< Number of frames in the trace
+		uint64_t m_WriteCount; //!< Number of writes in the trace
+
+		std::vector<uint64_t> m_WriteStart; //!< Index of the first write to each address; 65537 entries
+		std::vector<uint64_t> m_PCStart; //!< Index of the first frame with each PC; 65537 entries
+
+		uint64_t m_WriteFramesOffset; //!< File offset of the frame numbers of the writes
+		uint64_t m_WriteValuesOffset; //!< File offset of the values of the writes
+		uint64_t m_PCFramesOffset; //!< File offset of the frame numbers grouped by PC
+	};
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Standard libs
+#include <stdint.h>
+
+// Project libs
+#include "Trace/Frame.hpp"
+
+namespace Trace {
+	/** \class Recorder
+	* Interface of the classes that write out a trace file.
+	*
+	* \ref AsyncRecord hands frames to one of these on its writer thread;
+	* \ref BinaryRecord writes the compact binary format that PlayTrace()
+	* reads, and \ref Yaml writes a readable one.
+	*/
+	class Recorder
+	{
+	public:
+		virtual ~Recorder() {}
+
+		/** Writes out anything buffered and closes the file.
+		*
+		* Nothing can be recorded afterwards. Calling it again does nothing.
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		virtual void Close(void) = 0;
+
+		/** Records a frame by comparing all of memory with the last frame.
+		*
+		* \param[in] instructioncount The number of instructions that have been
+		* executed up to this point.
+		* \param[in] a Current value of the accumulator
+		* \param[in] x Current value of the X index register
+		* \param[in] y Current value of the Y index register
+		* \param[in] p Current value of the processor flags register
+		* \param[in] s Current value of the stack pointer
+		* \param[in] pc Current value of the program counter
+		* \param[in] mem The VM's memory, 64KB
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		virtual void Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem) = 0;
+
+		/** Records a frame from its write log.
+		*
+		* \param[in] frame Registers and memory writes of the frame
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		virtual void Snap(const Frame &frame) = 0;
+	};
+}
@@ -1,62 +1,179 @@
 #include "Trace/Yaml.hpp"
 
+#include <string.h>
+
+#include <stdexcept>
+
+namespace {
+	/** Appends <tt>val</tt> to <tt>out</tt> as 0x and <tt>digits</tt> hex digits. */
+	void AppendHex(std::string &out, unsigned int val, unsigned int digits)
+	{
+		static const char hexdigits[] = "0123456789ABCDEF";
+		out += "0x";
+		while (digits--)
+			out += hexdigits[(val >> (digits * 4)) & 0x0F];
+	}
+
+	/** Appends a register line, e.g. "  a: 0x01". */
+	void AppendRegister(std::string &out, const char *name, unsigned int val, unsigned int digits)
+	{
+		out += "  ";
+		out += name;
+		out += ": ";
+		AppendHex(out, val, digits);
+		out += '\n';
+	}
+}
+
 Trace::Yaml::Yaml(std::string filename) :
 	m_Filename(filename),
-	m_Trace(nullptr),
-	m_FirstWrite(true)
+	m_FirstFrame(true),
+	m_OldMemory(0x10000, 0x00)
 {
 	if (m_Filename.empty())
-		throw;
+		throw std::invalid_argument("trace filename is empty");
+
+	if (((m_Filename.size() < 4) || (m_Filename.compare(m_Filename.size() - 4, 4, ".yml") != 0)) &&
+		((m_Filename.size() < 5) || (m_Filename.compare(m_Filename.size() - 5, 5, ".yaml") != 0)))
+		m_Filename.append(".yml");
 
-	// TODO: Move these to the initializer list
-	m_Trace = std::make_unique<YAML::Emitter>();
+	m_File = std::make_unique<std::ofstream>(m_Filename, std::ios::binary | std::ios::trunc);
+	if (!m_File->good())
+		throw std::runtime_error("could not open trace file " + m_Filename);
 
-	//std::unique_ptr<uint8_t> oldMemory(new uint8_t(0x10000));
-	auto m_OldMemory = std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(0x10000,0));
+	memset(&m_OldState, 0, sizeof(m_OldState));
 
-	*m_Trace << YAML::Comment("System65 Diagnostic Trace v0");
-	*m_Trace << YAML::Key << "progname" << YAML::Value << m_Filename.c_str();
+	// Filenames can hold anything, so quote it
+	m_Buffer.reserve(BUFFER_SIZE + 64);
+	m_Buffer += "# System65 Diagnostic Trace v0\nprogname: \"";
+	for (size_t i = 0; i < m_Filename.size(); i++) {
+		char c = m_Filename[i];
+		if ((c == '"') || (c == '\\'))
+			m_Buffer += '\\';
+		m_Buffer += c;
+	}
+	m_Buffer += "\"\nframes:\n";
 }
 
 Trace::Yaml::~Yaml()
 {
-	*m_Trace << YAML::Comment("End of trace file");
-	m_File << *m_Trace->c_str();
-	m_File.flush();
-}
-
-void Trace::Yaml::Snap(int instructioncount, uint8_t(*acb)(), uint8_t(*xcb)(), uint8_t(*ycb)(), uint8_t(*pcb)(), uint8_t(*scb)(), uint16_t(*pccb)(), uint8_t(*memcb)(uint16_t))
-{
-	*m_Trace << YAML::BeginMap;
-
-	std::stringstream anchorname;
-	anchorname << "frame" << instructioncount;
-	*m_Trace << YAML::Anchor(anchorname.str());
-	*m_Trace << YAML::Key << "frame" << YAML::Value << instructioncount;
-	*m_Trace << YAML::Key << "a" << YAML::Value << &acb;
-	*m_Trace << YAML::Key << "x" << YAML::Value << &xcb;
-	*m_Trace << YAML::Key << "y" << YAML::Value << &ycb;
-	*m_Trace << YAML::Key << "pf" << YAML::Value << &pcb;
-	*m_Trace << YAML::Key << "s" << YAML::Value << &scb;
-	*m_Trace << YAML::Key << "pc" << YAML::Value << &pccb;
-
-	*m_Trace << YAML::Key << "memory" << YAML::Value;
-	if (m_FirstWrite) { // Write entire memory space out
-		*m_Trace << YAML::BeginSeq;
-		for (uint16_t i = 0; i > 0x10000; i++)
-			*m_Trace << memcb(i);
-		*m_Trace << YAML::EndSeq;
-	}
-	else { // Diff memory space
-		*m_Trace << YAML::BeginMap;
-		for (uint16_t i = 0; i > 0x10000; i++) {
-			uint8_t val = memcb(i);
-			if (m_OldMemory[i] != val)
-				*m_Trace << YAML::Key << i << YAML::Value << val;
-			m_OldMemory[i] = val;
-		}
-		*m_Trace << YAML::EndMap;
-	}
-
-	*m_Trace << YAML::EndMap;
-}
\ No newline at end of file
+	// Destructors can't throw, so a failed write is lost here
+	try {
+		Close();
+	}
+	catch (...) {
+	}
+}
+
+void Trace::Yaml::Close(void)
+{
+	if (!m_File->is_open())
+		return;
+
+	m_Buffer += "# End of trace file\n";
+	Flush();
+	m_File->close();
+}
+
+void Trace::Yaml::Flush(void)
+{
+	if (!m_Buffer.empty()) {
+		m_File->write(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+	m_File->flush();
+
+	if (!m_File->good())
+		throw std::runtime_error("could not write to trace file " + m_Filename);
+}
+
+void Trace::Yaml::Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem)
+{
+	// The first frame lists all of memory, as the spec shows
+	bool full = m_FirstFrame;
+	BeginFrame(instructioncount, a, x, y, p, s, pc);
+
+	bool first = true;
+	for (unsigned int i = 0; i < 0x10000; i++) {
+		if (full || (mem[i] != m_OldMemory[i]))
+			PutByte(first, (uint16_t)i, mem[i]);
+	}
+	memcpy(m_OldMemory.data(), mem, 0x10000);
+
+	EndFrame();
+}
+
+void Trace::Yaml::Snap(const Frame &frame)
+{
+	// The interrupt belongs to the frame before, which is still the last
+	// thing written
+	if ((frame.interrupt != TRACE_INTERRUPT_NONE) && !m_FirstFrame)
+		m_Buffer += (frame.interrupt == TRACE_INTERRUPT_NMI) ? "  interrupt: nmi\n" : "  interrupt: irq\n";
+
+	BeginFrame(frame.number, frame.a, frame.x, frame.y, frame.p, frame.s, frame.pc);
+
+	// Only the last write to each address counts, and only if it changed
+	// the byte
+	bool first = true;
+	for (unsigned int i = 0; i < frame.writecount; i++) {
+		const MemoryWrite &w = frame.writes[i];
+		bool later = false;
+		for (unsigned int j = i + 1; (j < frame.writecount) && !later; j++)
+			later = (frame.writes[j].addr == w.addr);
+		if (!later && (m_OldMemory[w.addr] != w.val))
+			PutByte(first, w.addr, w.val);
+	}
+	for (unsigned int i = 0; i < frame.writecount; i++)
+		m_OldMemory[frame.writes[i].addr] = frame.writes[i].val;
+
+	EndFrame();
+}
+
+//------------------------------------------------------------------------------
+// Private
+//------------------------------------------------------------------------------
+
+void Trace::Yaml::BeginFrame(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc)
+{
+	m_Buffer += "- frame: ";
+	m_Buffer += std::to_string(instructioncount);
+	m_Buffer += '\n';
+
+	if (m_FirstFrame || (a != m_OldState.a)) AppendRegister(m_Buffer, "a", a, 2);
+	if (m_FirstFrame || (x != m_OldState.x)) AppendRegister(m_Buffer, "x", x, 2);
+	if (m_FirstFrame || (y != m_OldState.y)) AppendRegister(m_Buffer, "y", y, 2);
+	if (m_FirstFrame || (p != m_OldState.p)) AppendRegister(m_Buffer, "p", p, 2);
+	if (m_FirstFrame || (s != m_OldState.s)) AppendRegister(m_Buffer, "s", s, 2);
+	if (m_FirstFrame || (pc != m_OldState.pc)) AppendRegister(m_Buffer, "pc", pc, 4);
+
+	m_OldState.a = a;
+	m_OldState.x = x;
+	m_OldState.y = y;
+	m_OldState.p = p;
+	m_OldState.s = s;
+	m_OldState.pc = pc;
+	m_FirstFrame = false;
+}
+
+void Trace::Yaml::PutByte(bool &first, uint16_t addr, uint8_t val)
+{
+	if (first) {
+		m_Buffer += "  memory:\n";
+		first = false;
+	}
+	m_Buffer += "    ";
+	AppendHex(m_Buffer, addr, 4);
+	m_Buffer += ": ";
+	AppendHex(m_Buffer, val, 2);
+	m_Buffer += '\n';
+
+	// A frame listing all of memory is several times the buffer
+	if (m_Buffer.size() >= BUFFER_SIZE)
+		Flush();
+}
+
+void Trace::Yaml::EndFrame(void)
+{
+	if (m_Buffer.size() >= BUFFER_SIZE)
+		Flush();
+}
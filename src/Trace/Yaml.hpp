@@ -1,44 +1,64 @@
 #pragma once
 
-// yaml_cpp needs this
-#ifdef _MSC_VER
-#define _SCL_SECURE_NO_WARNINGS
-#endif // _MSC_VER
-
 // Standard libs
+#include <stdint.h>
+
 #include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
 
-// Class-related libs
-#include <yaml-cpp/yaml.h>
+// Project libs
+#include "Trace/Frame.hpp"
+#include "Trace/Recorder.hpp"
 
 namespace Trace {
 	/** \class Yaml
 	* The System65 CPU emulator execution tracing class, utilizing YAML for
 	* serialization.
 	*
-	* This class manages the tracing of execution in the System65 emulator. Its main
-	* use is in verifying the correctness of emulator changes. It snapshots the
-	* state of emulation on each stop point during the execution of the emulator
-	* (per-instruction granularity when using the reference \ref System65 class),
-	* serializes the trace data and allows playback comparison later.
+	* This class writes a trace that can be read by a person, or by any YAML
+	* parser, following doc/trace spec.txt. It's much larger and slower than
+	* the \ref BinaryRecord format, so it's meant for looking at a stretch of
+	* execution rather than for verifying the emulator.
+	*
+	* Frames are formatted straight into a text buffer of BUFFER_SIZE bytes,
+	* which goes out to the file whenever it fills up, so a trace of any
+	* length records in constant memory, and a crash only loses the last
+	* buffer's worth. The file looks like this:
 	*
-	* It is possible to record a complete snapshot of the machine state in a single
-	* trace file by initializing and calling \ref Snap() at one point.
+	* \code
+	* # System65 Diagnostic Trace v0
+	* progname: trace.yml
+	* frames:
+	* - frame: 0
+	*   a: 0x00
+	*   x: 0x00
+	*   y: 0x00
+	*   p: 0x20
+	*   s: 0xFF
+	*   pc: 0x0200
+	*   memory:
+	*     0x0000: 0x00
+	*     ...
+	* - frame: 1
+	*   a: 0x01
+	*   memory:
+	*     0x8000: 0xFF
+	*   interrupt: irq
+	* # End of trace file
+	* \endcode
 	*
-	* \todo Get TraceRecord and TracePlayback to derive from the same base; the
-	* constructor and destructors can be part of the base, as well as a few of the
-	* members, but Snap() would be implemented independently because playback
-	* returns a bool, unless I set Snap() in record to also have the bool type but
-	* just not return anything.
+	* The first frame has every register and every byte of memory. After that,
+	* a frame only has the registers and bytes that changed, and leaves out
+	* <tt>memory</tt> if none did. <tt>interrupt</tt> (<tt>irq</tt> or
+	* <tt>nmi</tt>) is on the frame after which an interrupt was raised; its
+	* effects are in the next frame.
 	*
-	* \todo Figure out the best approach for passing data to Snap(). Do I pass the
-	* System65 object? Do I have a separate method for setting callbacks and require
-	* getters? Do I just pass all 9 arguments every time?
+	* \note Interrupts are only known from the write log, so one raised just
+	* before a frame recorded by comparing memory is left out.
 	*/
-	class Yaml
+	class Yaml : public Recorder
 	{
 	public:
 		/** Initializes the trace recording.
@@ -46,44 +66,80 @@ namespace Trace {
 		* This method starts the tracing system, allowing trace recording to occur.
 		* Tracing is done to <tt>filename</tt>.
 		*
-		* \param[in] filename File to record to; an extension is not needed.
+		* \param[in] filename File to record to; ".yml" is appended unless it
+		* already ends in ".yml" or ".yaml"
 		*
-		* \throws Passes any throws related to file handling.
+		* \throws std::invalid_argument if <tt>filename</tt> is empty
+		* \throws std::runtime_error if the file can't be opened
 		*/
 		Yaml(std::string filename = "trace");
 
-		/** Terminates the tracing session.
+		/** Terminates the tracing session, writing out any buffered frames.
+		*
+		* Call Close() first to find out whether that worked.
 		*/
 		~Yaml();
 
+		/** Writes out any buffered frames and the end of the document, and
+		* closes the file.
+		*
+		* Nothing can be recorded afterwards. Calling it again does nothing.
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void Close(void) override;
+
+		/** Writes any buffered frames to the file.
+		*
+		* \throws std::runtime_error if the file can't be written
+		*/
+		void Flush(void);
+
 		/** Traces through a single step of execution.
 		*
-		* This method records the machine state, indexed on
-		* <tt>instructioncount</tt>. The caller should provide callback pointers to
-		* methods that return the necessary information about the current machine state.
+		* \see Recorder::Snap
+		*/
+		void Snap(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc, const uint8_t *mem) override;
+
+		/** Traces through a single step of execution, from a write log.
 		*
-		* \param[in] instructioncount The number of instructions that have been
-		* executed up to this point.
-		* \param[in] acb Callback function pointer for reading the contents of the accumulator
-		* \param[in] xcb Callback function pointer for reading the contents of the X index register
-		* \param[in] ycb Callback function pointer for reading the contents of the Y index register
-		* \param[in] pcb Callback function pointer for reading the contents of the processor flags register
-		* \param[in] scb Callback function pointer for reading the contents of the stack pointer register
-		* \param[in] pccb Callback function pointer for reading the contents of the program counter register
-		* \param[in] memcb Callback function pointer for reading the VM's memory
+		* Writes that store the value a byte already had are left out.
+		*
+		* \see Recorder::Snap
 		*/
-		void Snap(int instructioncount, uint8_t(*acb)(), uint8_t(*xcb)(), uint8_t(*ycb)(), uint8_t(*pcb)(), uint8_t(*scb)(), uint16_t(*pccb)(), uint8_t(*memcb)(uint16_t));
+		void Snap(const Frame &frame) override;
 
 	protected:
 	private:
-		std::string m_Filename; //!< Name of the trace file to record to
+		static const size_t BUFFER_SIZE = 256 * 1024; //!< Bytes of text buffered before writing to the file
+
+		std::string m_Filename; //!< Name of the trace file
+
+		std::unique_ptr<std::ofstream> m_File; //!< Output file for the trace
+
+		std::string m_Buffer; //!< Text that hasn't been written yet; its capacity is kept between writes
+
+		bool m_FirstFrame; //!< Whether the next frame is the first; it records every register and byte
+
+		/** Struct representing the old state of the CPU (state on the previous recorded frame). */
+		struct {
+			uint8_t a;
+			uint8_t x;
+			uint8_t y;
+			uint8_t p;
+			uint8_t s;
+			uint16_t pc;
+		} m_OldState;
 
-		std::unique_ptr<YAML::Emitter> m_Trace; //!< YAML emitter to serialize the recorded data
+		std::vector<uint8_t> m_OldMemory; //!< Memory as of the last frame
 
-		std::vector<uint8_t> m_OldMemory; //!< Vector object representing machine memory from the last call to Snap().
+		/** Starts a frame and writes the registers that changed. */
+		void BeginFrame(uint32_t instructioncount, uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t s, uint16_t pc);
 
-		std::ofstream m_File; //!< Output file object to write the data into
+		/** Writes one changed byte, starting the memory map first if needed. */
+		void PutByte(bool &first, uint16_t addr, uint8_t val);
 
-		bool m_FirstWrite; //!< Bool representing whether this is the first frame of data, i.e. if we need to dump the entire memory space
+		/** Writes the buffer out if it's nearly full. */
+		void EndFrame(void);
 	};
-}
\ No newline at end of file
+}
@@ -12,17 +12,31 @@ int main(int argc, char **argv)
 	// Acquire the lock to keep the VM from running off
 	mutMachineState.lock();
 
-	// Make a thread for the system
-	std::thread SystemThread(SystemExec);
-
 	// Parse the command-line options
 	po::options_description desc("Available options");
 	desc.add_options()
 		("bin", po::value<std::string>(), "Loads a file into program memory")
 		("stack-base", po::value<std::uint8_t>(), "Sets the stack base to 0xNN00; default is 0x01")
 		("interrupt-vector", po::value<std::uint16_t>(), "Sets the interrupt vector to 0xNNNN; default is 0xFFFE")
-		("trace-write", po::value<std::string>(), "Writes out a trace file; extremely slow and only useful for emulator development!")
-		("trace-read", po::value<std::string>(), "Reads in a trace file; extremely slow and only useful for emulator development!")
+		("trace-write", po::value<std::string>(), "Writes out a trace file to <name>.btr, or a YAML trace if <name> ends in .yml; only useful for emulator development!")
+		("trace-drop", "With --trace-write, drops frames instead of slowing the VM down when the trace writer falls behind")
+		("trace-read", po::value<std::string>(), "Plays back a trace file, checking the emulator against it, and exits; only useful for emulator development!")
+		("trace-frames", po::value<unsigned int>()->default_value(0), "Number of instructions of the trace to play back; 0 plays back all of it")
+		("trace-threads", po::value<unsigned int>()->default_value(0), "Number of threads --trace-read splits a trace with keyframes across; 0 uses every hardware thread")
+		("trace-query", po::value<std::string>(), "Answers the questions given with --query about a trace file, and exits")
+		("query", po::value<std::vector<std::string>>()->multitoken(), "With --trace-query, a question: \"last ADDR before N\", \"pc ADDR\" or \"history ADDR\"")
+		("framebuffer-base", po::value<std::uint16_t>(), "Maps the 80x25 text framebuffer at 0xNNNN; default is 0xE000")
+		("headless", "Runs without a window; use with --frames")
+		("frames", po::value<unsigned int>()->default_value(60), "Number of frames to run in headless mode; 0 runs forever")
+		("frame-cycles", po::value<unsigned int>()->default_value(16667), "Number of cycles in each headless frame")
+		("dump-text", po::value<std::string>(), "In headless mode, writes the framebuffer to <prefix>NNNNNN.txt on every frame that changed it")
+		("dump-images", po::value<std::string>(), "In headless mode, renders the screen to <prefix>NNNNNN.png (or .ppm) without a GPU")
+		("dump-every", po::value<unsigned int>()->default_value(1), "Number of frames between image dumps")
+		("image-format", po::value<std::string>()->default_value("png"), "Format of image dumps; png or ppm")
+		("disasm", po::value<std::string>(), "Disassembles a binary file to stdout and exits")
+		("disasm-base", po::value<std::uint16_t>()->default_value(CODE_BASE), "Address the file given to --disasm is loaded at")
+		("terminal", "Shows the emulator screen on the terminal instead of in a window")
+		("ascii", "With --terminal, draws the screen with plain ASCII instead of UTF-8")
 		("help", "Shows this help text");
 
 	po::variables_map povm;
@@ -45,6 +59,21 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
+	if (povm.count("disasm")) { // Disassemble a file
+		int ret = DisassembleFile(povm["disasm"].as<std::string>(), povm["disasm-base"].as<std::uint16_t>());
+		mutMachineState.unlock();
+		return ret;
+	}
+
+	if (povm.count("trace-query")) { // Query a trace file
+		std::vector<std::string> queries;
+		if (povm.count("query"))
+			queries = povm["query"].as<std::vector<std::string>>();
+		int ret = QueryTrace(povm["trace-query"].as<std::string>(), queries);
+		mutMachineState.unlock();
+		return ret;
+	}
+
 	if (povm.count("bin")) { // Load binary file into memory
 		std::string filename = povm["bin"].as<std::string>();
 		std::cout << "Loading program file " << filename << std::endl;
@@ -74,12 +103,89 @@ int main(int argc, char **argv)
 
 	}
 
+	if (povm.count("framebuffer-base")) { // Move the text framebuffer
+		try {
+			sys.MapFramebuffer(povm["framebuffer-base"].as<std::uint16_t>());
+		}
+		catch (std::out_of_range& e) {
+			std::cerr << "Error mapping framebuffer: " << e.what() << std::endl;
+			mutMachineState.unlock();
+			return 1;
+		}
+	}
+
 	if (povm.count("trace-write")) { // Record a trace file
-	
+		try {
+			Trace::AsyncRecord::Backpressure backpressure = povm.count("trace-drop") ?
+				Trace::AsyncRecord::BACKPRESSURE_DROP : Trace::AsyncRecord::BACKPRESSURE_BLOCK;
+			sys.StartRecordTrace(povm["trace-write"].as<std::string>(), UINT_MAX, backpressure);
+		}
+		catch (std::runtime_error& e) {
+			std::cerr << "Error starting trace: " << e.what() << std::endl;
+			return 1;
+		}
 	}
 
 	if (povm.count("trace-read")) { // Playback a trace file
+		int ret;
+		try {
+			ret = sys.PlayTrace(povm["trace-read"].as<std::string>(), povm["trace-frames"].as<unsigned int>(),
+				povm["trace-threads"].as<unsigned int>()) ? 0 : 1;
+		}
+		catch (std::runtime_error& e) {
+			std::cerr << "Error playing back trace: " << e.what() << std::endl;
+			ret = 1;
+		}
+		mutMachineState.unlock();
+		return ret;
+	}
+
+	if (povm.count("headless")) { // Run without a window
+		std::string textprefix, imageprefix;
+		if (povm.count("dump-text"))
+			textprefix = povm["dump-text"].as<std::string>();
+		if (povm.count("dump-images"))
+			imageprefix = povm["dump-images"].as<std::string>();
+
+		SoftwareRenderer::ImageFormat format;
+		std::string formatname = povm["image-format"].as<std::string>();
+		if (formatname == "png") {
+			format = SoftwareRenderer::IMAGE_PNG;
+		} else if (formatname == "ppm") {
+			format = SoftwareRenderer::IMAGE_PPM;
+		} else {
+			std::cerr << "Unknown image format " << formatname << std::endl;
+			StopTrace();
+			mutMachineState.unlock();
+			return 1;
+		}
+
+		unsigned int imageevery = povm["dump-every"].as<unsigned int>();
+		if (imageevery == 0) {
+			std::cerr << "--dump-every must be at least 1" << std::endl;
+			StopTrace();
+			mutMachineState.unlock();
+			return 1;
+		}
+
+		int ret = RunHeadless(povm["frames"].as<unsigned int>(), povm["frame-cycles"].as<unsigned int>(), textprefix,
+			imageprefix, imageevery, format);
+		if (!StopTrace())
+			ret = 1;
+		mutMachineState.unlock();
+		return ret;
+	}
 
+	// Make a thread for the system
+	std::thread SystemThread(SystemExec);
+
+	if (povm.count("terminal")) { // Run on the terminal
+		int ret = RunTerminal(!povm.count("ascii"));
+		bStopExec = true;
+		SystemThread.join();
+		if (!StopTrace())
+			ret = 1;
+		return ret;
 	}
 
 	// Make a render window
@@ -98,37 +204,50 @@ int main(int argc, char **argv)
 #ifdef WIN32
 		MessageBox(NULL, L"Your hardware does not support 256x256 textures. This emulator cannot run.", L"Error", (MB_OK|MB_ICONERROR));
 #endif // WIN32
-		exit(1);
+		bStopExec = true;
+		SystemThread.join();
+		StopTrace();
+		mutMachineState.unlock();
+		return 1;
 	}
 
-	if (!fonttex.loadFromFile("font_82.bmp"))
+	if (!fonttex.loadFromFile("font_82.bmp")) {
+		bStopExec = true;
+		SystemThread.join();
+		StopTrace();
+		mutMachineState.unlock();
 		return 1;
-
-	// Literally an array of characters
-	// Create it, set them all to ' ' (space) and position them accordingly.
-	sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT];
-	for (int x = 0; x < EMUSCREEN_WIDTH; x++) {
-		for (int y = 0; y < EMUSCREEN_HEIGHT; y++) {
-			screenbuf[x][y].setTexture(fonttex);
-			screenbuf[x][y].setTextureRect(sf::IntRect(0,0,TEXCHAR_WIDTH,TEXCHAR_HEIGHT)); // left, top, width, height
-			screenbuf[x][y].setPosition(sf::Vector2f(((float)x*TEXCHAR_WIDTH),((float)y*TEXCHAR_HEIGHT)));
-		}
 	}
 
+	// Literally an array of characters, plus one quad per character to draw
+	// them with. Only the quads of cells that change get re-encoded.
+	ScreenBuffer screen;
+	sf::VertexArray vertices;
+	InitVertices(vertices);
+
 	// Create the frame
-	DrawScreenFrame(screenbuf);
+	DrawScreenFrame(screen);
 
 	// Create the static elements
-	DrawLabels(screenbuf);
+	DrawLabels(screen);
 
 	// Initial draw of the processor status
-	DrawStats(screenbuf,&sys);
+	MachineSnapshot snap, oldsnap;
+	Disasm::Disassembler disasm(sys);
+	DisasmPanel panel = {};
+	TakeSnapshot(&snap, &sys);
+	DrawMonitor(screen, sys.GetFramebuffer());
+	DrawDisassembly(screen, disasm, panel, snap.pc);
+	DrawStats(screen, snap, NULL);
+	oldsnap = snap;
 
 	window.setVerticalSyncEnabled(true);
 
 	// Unlock the VM to let it run
 	mutMachineState.unlock();
 
+	unsigned int shotcount = 0; // Number of screenshots taken
+
 	// Main loop
 	while(window.isOpen()) {
 		sf::Event event;
@@ -138,24 +257,31 @@ int main(int argc, char **argv)
 				std::cout << "[DEBUG] Window closed" << std::endl;
 				window.close();
 			}
+			else if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::F12)) {
+				Screenshot(screen, FrameFilename("screenshot", shotcount++, ".png"));
+			}
 		}
 
-		// Draw the window buffer
-		window.clear(sf::Color::Black);
+		// Only hold the lock long enough to copy the state out
 		mutMachineState.lock();
-		DrawStats(screenbuf,&sys); // Update the onscreen CPU state
+		TakeSnapshot(&snap, &sys);
+		DrawMonitor(screen, sys.GetFramebuffer());
+		DrawDisassembly(screen, disasm, panel, snap.pc);
 		mutMachineState.unlock();
-		for (int x = 0; x < EMUSCREEN_WIDTH; x++) {
-			for (int y = 0; y < EMUSCREEN_HEIGHT; y++)
-					window.draw(screenbuf[x][y]);
-		}
+		DrawStats(screen, snap, &oldsnap); // Update the onscreen CPU state
+		oldsnap = snap;
+		UpdateVertices(vertices, screen);
+
+		// Draw the window buffer
+		window.clear(sf::Color::Black);
+		window.draw(vertices, &fonttex);
 		window.display();
 	}
 
 	std::cout << "Finished" << std::endl;
 	bStopExec = true;
 	SystemThread.join();
-	return 0;
+	return StopTrace() ? 0 : 1;
 }
 
 void SystemExec(void) {
@@ -176,90 +302,435 @@ void SystemExec(void) {
 	}
 }
 
-void DrawScreenFrame(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT])
+int RunHeadless(unsigned int frames, unsigned int framecycles, const std::string &textprefix,
+	const std::string &imageprefix, unsigned int imageevery, SoftwareRenderer::ImageFormat format)
+{
+	Devices::TextFramebuffer &fb = sys.GetFramebuffer();
+
+	// The renderer is only needed, and the font only loaded, for image dumps
+	std::unique_ptr<SoftwareRenderer> renderer;
+	std::unique_ptr<Disasm::Disassembler> disasm;
+	ScreenBuffer screen;
+	MachineSnapshot snap, oldsnap;
+	DisasmPanel panel = {};
+	if (!imageprefix.empty()) {
+		try {
+			renderer.reset(new SoftwareRenderer());
+		}
+		catch (std::runtime_error& e) {
+			std::cerr << "Error setting up the renderer: " << e.what() << std::endl;
+			return 1;
+		}
+		disasm.reset(new Disasm::Disassembler(sys));
+		DrawScreenFrame(screen);
+		DrawLabels(screen);
+	}
+	const char *imageext = (format == SoftwareRenderer::IMAGE_PNG) ? ".png" : ".ppm";
+
+	for (unsigned int frame = 0; (frames == 0) || (frame < frames); frame++) {
+		sys.Tick(framecycles);
+
+		try {
+			if (renderer) {
+				// DrawMonitor() takes the dirty rows, so check them first
+				bool fbdirty = (fb.GetDirtyRows() != 0);
+				DrawMonitor(screen, fb);
+				TakeSnapshot(&snap, &sys);
+				DrawDisassembly(screen, *disasm, panel, snap.pc);
+				DrawStats(screen, snap, (frame == 0) ? NULL : &oldsnap);
+				oldsnap = snap;
+
+				if (fbdirty && !textprefix.empty())
+					fb.DumpText(FrameFilename(textprefix, frame, ".txt"));
+				if ((frame % imageevery) == 0) {
+					renderer->Update(screen);
+					renderer->WriteImage(FrameFilename(imageprefix, frame, imageext), format);
+				}
+			}
+			// Only frames that touched the framebuffer are worth a dump
+			else if (fb.TakeDirtyRows() && !textprefix.empty()) {
+				fb.DumpText(FrameFilename(textprefix, frame, ".txt"));
+			}
+		}
+		catch (std::runtime_error& e) {
+			std::cerr << "Error dumping frame " << frame << ": " << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+bool Screenshot(const ScreenBuffer &screen, const std::string &filename)
+{
+	try {
+		// Loaded on first use, so windowed mode doesn't pay for it otherwise
+		static SoftwareRenderer renderer;
+		renderer.Redraw(screen);
+		renderer.WriteImage(filename, SoftwareRenderer::IMAGE_PNG);
+	}
+	catch (std::runtime_error& e) {
+		std::cerr << "Error taking screenshot: " << e.what() << std::endl;
+		return false;
+	}
+
+	std::cout << "Saved screenshot to " << filename << std::endl;
+	return true;
+}
+
+int RunTerminal(bool unicode)
+{
+	TerminalContext term(unicode);
+	ScreenBuffer screen;
+	MachineSnapshot snap, oldsnap;
+	Disasm::Disassembler disasm(sys);
+	DisasmPanel panel = {};
+
+	DrawScreenFrame(screen);
+	DrawLabels(screen);
+	TakeSnapshot(&snap, &sys);
+	DrawMonitor(screen, sys.GetFramebuffer());
+	DrawDisassembly(screen, disasm, panel, snap.pc);
+	DrawStats(screen, snap, NULL);
+	oldsnap = snap;
+
+	// Unlock the VM to let it run
+	mutMachineState.unlock();
+
+	for (;;) {
+		int key;
+		while ((key = term.ReadKey()) != -1) {
+			if (key == 'q')
+				return 0;
+			if (key == 0x0C) // Ctrl-L
+				term.Redraw(screen);
+		}
+
+		mutMachineState.lock();
+		TakeSnapshot(&snap, &sys);
+		DrawMonitor(screen, sys.GetFramebuffer());
+		DrawDisassembly(screen, disasm, panel, snap.pc);
+		mutMachineState.unlock();
+		DrawStats(screen, snap, &oldsnap);
+		oldsnap = snap;
+		term.Present(screen);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(16));
+	}
+}
+
+bool StopTrace(void)
+{
+	try {
+		sys.EndRecordTrace();
+	}
+	catch (std::runtime_error& e) {
+		std::cerr << "Error writing trace: " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string FrameFilename(const std::string &prefix, unsigned int frame, const char *ext)
+{
+	std::ostringstream name;
+	name << prefix << std::setw(6) << std::setfill('0') << frame << ext;
+	return name.str();
+}
+
+void DrawScreenFrame(ScreenBuffer &screen)
 {
     // Draw the corner pieces
-	DrawChar(screenbuf,(char)0xc9,0,                0                 ); // top left
-	DrawChar(screenbuf,(char)0xc8,0,                EMUSCREEN_HEIGHT-1); // bottom left
-	DrawChar(screenbuf,(char)0xbb,EMUSCREEN_WIDTH-1,0                 ); // top right
-	DrawChar(screenbuf,(char)0xbc,EMUSCREEN_WIDTH-1,EMUSCREEN_HEIGHT-1); // bottom right
+	DrawChar(screen,(char)0xc9,0,                0                 ); // top left
+	DrawChar(screen,(char)0xc8,0,                EMUSCREEN_HEIGHT-1); // bottom left
+	DrawChar(screen,(char)0xbb,EMUSCREEN_WIDTH-1,0                 ); // top right
+	DrawChar(screen,(char)0xbc,EMUSCREEN_WIDTH-1,EMUSCREEN_HEIGHT-1); // bottom right
 
 	// Draw the outermost borders
 	for (int i = 1; i < EMUSCREEN_WIDTH-1; i++) { // Top/Bottom
 		// should be 0xc4?
-		DrawChar(screenbuf,(char)0xcd,i,0);
-		DrawChar(screenbuf,(char)0xcd,i,EMUSCREEN_HEIGHT-1);
+		DrawChar(screen,(char)0xcd,i,0);
+		DrawChar(screen,(char)0xcd,i,EMUSCREEN_HEIGHT-1);
 	}
 	for (int i = 1; i < EMUSCREEN_HEIGHT-1; i++) {// Left/Right
-		DrawChar(screenbuf,(char)0xba,0,i);
-		DrawChar(screenbuf,(char)0xba,EMUSCREEN_WIDTH-1,i);
+		DrawChar(screen,(char)0xba,0,i);
+		DrawChar(screen,(char)0xba,EMUSCREEN_WIDTH-1,i);
 	}
 
 	// Draw the status bar border
-	DrawChar(screenbuf,(char)0xc7,0  ,26); // Left connector
-	DrawChar(screenbuf,(char)0xb6,111,26); // Right connectorbt full
+	DrawChar(screen,(char)0xc7,0  ,26); // Left connector
+	DrawChar(screen,(char)0xb6,111,26); // Right connectorbt full
 	for (int i = 1; i < EMUSCREEN_WIDTH-1; i++) // Border
-		DrawChar((screenbuf),(char)0xc4,i,26);
+		DrawChar(screen,(char)0xc4,i,26);
 
 	// Draw the right-hand monitor border
-	DrawChar(screenbuf,(char)0xd1,81,0); // Top connector
-	DrawChar(screenbuf,(char)0xc1,81,26); // Bottom connector
+	DrawChar(screen,(char)0xd1,81,0); // Top connector
+	DrawChar(screen,(char)0xc1,81,26); // Bottom connector
 	for (int i = 1; i < EMUSCREEN_HEIGHT-3; i++) // Border
-		DrawChar(screenbuf,(char)0xb3,81,i);
+		DrawChar(screen,(char)0xb3,81,i);
 
 	// Draw the status/disasm border
-	DrawChar(screenbuf,(char)0xc3,81,3); // Left connector
-	DrawChar(screenbuf,(char)0xb6,111,3); // Right connector
+	DrawChar(screen,(char)0xc3,81,3); // Left connector
+	DrawChar(screen,(char)0xb6,111,3); // Right connector
 	for (int i = 82; i < EMUSCREEN_WIDTH-1; i++) // Border
-		DrawChar(screenbuf,(char)0xc4,i,3);
+		DrawChar(screen,(char)0xc4,i,3);
+}
+
+void DrawLabels(ScreenBuffer &screen)
+{
+	DrawString(screen,"NV-BDIZC  A>   X>   PC>",83,1);
+	DrawString(screen,"S>   Y>",93,2);
+}
+
+void DrawMonitor(ScreenBuffer &screen, Devices::TextFramebuffer &fb)
+{
+	uint32_t rows = fb.TakeDirtyRows();
+	for (unsigned int row = 0; rows != 0; row++, rows >>= 1) {
+		if (!(rows & 1))
+			continue;
+		const uint8_t *cells = fb.GetRow(row);
+		for (unsigned int col = 0; col < FRAMEBUFFER_WIDTH; col++)
+			DrawChar(screen,(char)cells[col],col+1,row+1);
+	}
+}
+
+void TakeSnapshot(MachineSnapshot *snap, System65 *sys)
+{
+	snap->a = sys->GetRegister_A();
+	snap->x = sys->GetRegister_X();
+	snap->y = sys->GetRegister_Y();
+	snap->s = sys->GetRegister_S();
+	snap->p = sys->GetRegister_P();
+	snap->pc = sys->GetRegister_PC();
 }
 
-void DrawLabels(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT])
+void DrawStats(ScreenBuffer &screen, const MachineSnapshot &cur, const MachineSnapshot *prev)
 {
-	DrawString(screenbuf,"NV-BDIZC  A>   X>   PC>",83,1);
-	DrawString(screenbuf,"S>   Y>",93,2);
+	// Most frames only change PC and maybe one register, so skip the rest.
+	if (!prev || (cur.a != prev->a))
+		DrawHex(screen,cur.a,2,95,1);
+	if (!prev || (cur.x != prev->x))
+		DrawHex(screen,cur.x,2,100,1);
+	if (!prev || (cur.y != prev->y))
+		DrawHex(screen,cur.y,2,100,2);
+	if (!prev || (cur.s != prev->s))
+		DrawHex(screen,cur.s,2,95,2);
+	if (!prev || (cur.pc != prev->pc))
+		DrawHex(screen,cur.pc,4,106,1);
+	if (!prev || (cur.p != prev->p)) {
+		unsigned int x = 83;
+		for (int i = 0x80; i > 0; i >>= 1)
+			DrawChar(screen,(cur.p & i) ? '1' : '0',x++,2);
+	}
 }
 
-void DrawStats(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], System65 *sys)
+void DrawDisassembly(ScreenBuffer &screen, Disasm::Disassembler &disasm, DisasmPanel &panel, uint16_t pc)
 {
-	// "But ccfreak2k," you say, "sprintf() is unsafe!"
-	// "You are correct," I give in reply, "but witness that our data is neatly
-	// "formed and easily constrained. An attacker must already be able to write
-	// "to our memory in order to write to our memory with this!"
-	char str[9] = {};
-	sprintf(str,"%.2X",sys->GetRegister_A());
-	DrawString(screenbuf,str,95,1);
-	sprintf(str,"%.2X",sys->GetRegister_X());
-	DrawString(screenbuf,str,100,1);
-	sprintf(str,"%.2X",sys->GetRegister_Y());
-	DrawString(screenbuf,str,100,2);
-	sprintf(str,"%.2X",sys->GetRegister_S());
-	DrawString(screenbuf,str,95,2);
-	sprintf(str,"%.4X",sys->GetRegister_PC());
-	DrawString(screenbuf,str,106,1);
-	uint8_t f = sys->GetRegister_P();
-	char *p = str;
-	for (int i = 0x80; i > 0; i >>= 1)
-		*p++ = (f & i) ? '1' : '0';
-	DrawString(screenbuf,str,83,2);
+	uint16_t lines[DISASM_PANEL_ROWS];
+	int cur = -1;
+
+	// Follow the instructions from the top of the panel. Their lengths come
+	// from the cache, and may change if the code under the panel was written.
+	if (panel.valid) {
+		uint16_t addr = panel.start;
+		for (unsigned int i = 0; i < DISASM_PANEL_ROWS; i++) {
+			lines[i] = addr;
+			if (addr == pc)
+				cur = i;
+			addr += disasm.GetLength(addr);
+		}
+	}
+
+	// Scroll if PC left the panel or is about to
+	if ((cur < 0) || (cur >= DISASM_PANEL_ROWS - DISASM_PANEL_CONTEXT)) {
+		panel.start = (cur < 0) ? pc : lines[cur - DISASM_PANEL_CONTEXT];
+		panel.valid = true;
+		uint16_t addr = panel.start;
+		for (unsigned int i = 0; i < DISASM_PANEL_ROWS; i++) {
+			lines[i] = addr;
+			if (addr == pc)
+				cur = i;
+			addr += disasm.GetLength(addr);
+		}
+	}
+
+	for (int i = 0; i < DISASM_PANEL_ROWS; i++) {
+		DrawChar(screen,(i == cur) ? '>' : ' ',DISASM_PANEL_X,DISASM_PANEL_Y+i);
+		DrawString(screen,disasm.GetLine(lines[i]),DISASM_PANEL_X+1,DISASM_PANEL_Y+i);
+	}
 }
 
-void DrawString(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], const char *str, unsigned int x, unsigned int y)
+int DisassembleFile(const std::string &filename, uint16_t base)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.good()) {
+		std::cerr << "Error opening file " << filename << std::endl;
+		return 1;
+	}
+
+	std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (image.size() > MAX_MEM_SIZE - base) {
+		std::cerr << "Warning: " << filename << " extends past $FFFF; only the first " << (MAX_MEM_SIZE - base) << " bytes are disassembled" << std::endl;
+		image.resize(MAX_MEM_SIZE - base);
+	}
+
+	std::string listing;
+	Disasm::DisassembleImage(image.data(), image.size(), base, listing);
+	std::cout.write(listing.data(), listing.size());
+	std::cout.flush();
+	return 0;
+}
+
+int QueryTrace(const std::string &tracefile, const std::vector<std::string> &queries)
+{
+	std::string tracename = tracefile;
+	if ((tracename.size() < 4) || (tracename.compare(tracename.size() - 4, 4, ".btr") != 0))
+		tracename.append(".btr");
+	std::string indexname = tracename.substr(0, tracename.size() - 4) + ".btx";
+
+	std::unique_ptr<Trace::QueryIndex> index;
+	try {
+		uint64_t tracesize, tracetime;
+		{
+			Trace::MappedFile trace(tracename);
+			tracesize = trace.GetSize();
+			tracetime = trace.GetModifiedTime();
+		}
+		try {
+			// An index from an older build of the trace is rebuilt, even if
+			// the new one happens to be the same size
+			index = std::make_unique<Trace::QueryIndex>(indexname);
+			if ((index->GetTraceSize() != tracesize) || (index->GetTraceModifiedTime() != tracetime))
+				index.reset();
+		}
+		catch (std::runtime_error&) {
+			// Missing or unreadable; build a new one
+		}
+		if (!index) {
+			std::cerr << "Building query index " << indexname << std::endl;
+			Trace::QueryIndex::Build(tracename, indexname);
+			index = std::make_unique<Trace::QueryIndex>(indexname);
+		}
+	}
+	catch (std::runtime_error& e) {
+		std::cerr << "Error opening trace: " << e.what() << std::endl;
+		return 1;
+	}
+
+	int ret = 0;
+	std::cout << std::uppercase << std::setfill('0');
+	for (size_t q = 0; q < queries.size(); q++) {
+		std::istringstream words(queries[q]);
+		std::vector<std::string> query;
+		std::string word;
+		while (words >> word)
+			query.push_back(word);
+
+		unsigned long addr, frame;
+		if ((query.size() == 4) && (query[0] == "last") && (query[2] == "before") &&
+			ParseQueryNumber(query[1], 0xFFFF, addr) && ParseQueryNumber(query[3], UINT32_MAX, frame)) {
+			Trace::ValueChange change;
+			std::cout << "$" << std::hex << std::setw(4) << addr;
+			if (index->LastChange((uint16_t)addr, (uint32_t)frame, change))
+				std::cout << " last changed to $" << std::setw(2) << (unsigned int)change.value << std::dec << " at frame " << change.frame;
+			else
+				std::cout << std::dec << " did not change before frame " << frame;
+			std::cout << std::endl;
+		} else if ((query.size() == 2) && (query[0] == "pc") && ParseQueryNumber(query[1], 0xFFFF, addr)) {
+			std::vector<uint32_t> frames;
+			index->FramesAtPC((uint16_t)addr, frames);
+			std::cout << "PC was $" << std::hex << std::setw(4) << addr << std::dec << " at " << frames.size() << " frames" << std::endl;
+			for (size_t i = 0; i < frames.size(); i++)
+				std::cout << frames[i] << std::endl;
+		} else if ((query.size() == 2) && (query[0] == "history") && ParseQueryNumber(query[1], 0xFFFF, addr)) {
+			std::vector<Trace::ValueChange> history;
+			index->History((uint16_t)addr, history);
+			std::cout << "$" << std::hex << std::setw(4) << addr << std::dec << " changed " << history.size() << " times" << std::endl;
+			for (size_t i = 0; i < history.size(); i++)
+				std::cout << history[i].frame << ": $" << std::hex << std::setw(2) << (unsigned int)history[i].value << std::dec << std::endl;
+		} else {
+			std::cerr << "Unknown query \"" << queries[q] << "\"; expected \"last ADDR before N\", \"pc ADDR\" or \"history ADDR\"" << std::endl;
+			ret = 1;
+		}
+	}
+	return ret;
+}
+
+bool ParseQueryNumber(const std::string &str, unsigned long max, unsigned long &val)
+{
+	std::string digits = str;
+	int base = 10;
+	if ((digits.size() > 1) && (digits[0] == '$')) {
+		digits.erase(0, 1);
+		base = 16;
+	} else if ((digits.size() > 2) && (digits[0] == '0') && ((digits[1] == 'x') || (digits[1] == 'X'))) {
+		digits.erase(0, 2);
+		base = 16;
+	}
+	if (digits.empty() || (digits.find_first_not_of(base == 16 ? "0123456789ABCDEFabcdef" : "0123456789") != std::string::npos))
+		return false;
+	try {
+		val = std::stoul(digits, nullptr, base);
+	}
+	catch (std::exception&) {
+		return false;
+	}
+	return val <= max;
+}
+
+void DrawHex(ScreenBuffer &screen, unsigned int val, unsigned int digits, unsigned int x, unsigned int y)
+{
+	static const char hexdigits[] = "0123456789ABCDEF";
+	while (digits--)
+		DrawChar(screen,hexdigits[(val >> (digits*4)) & 0x0F],x++,y);
+}
+
+void DrawString(ScreenBuffer &screen, const char *str, unsigned int x, unsigned int y)
 {
 	while (*str) {
 		if (x >= EMUSCREEN_WIDTH) {
 			x = 0;
 			y++;
 		}
-		DrawChar(screenbuf,*str++,x++,y);
+		DrawChar(screen,*str++,x++,y);
 	}
 }
 
-void DrawChar(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], char c, unsigned int x, unsigned int y)
+void DrawChar(ScreenBuffer &screen, char c, unsigned int x, unsigned int y)
+{
+	screen.SetChar(c,x,y);
+}
+
+void InitVertices(sf::VertexArray &vertices)
 {
-	unsigned char uc = (unsigned char)c;
-	unsigned xpos = (uc % TEXCHAR_CELLS) * TEXCHAR_WIDTH;
-	unsigned ypos = (uc / TEXCHAR_CELLS) * TEXCHAR_HEIGHT;
-	screenbuf[x][y].setTextureRect(sf::IntRect(xpos,ypos,TEXCHAR_WIDTH,TEXCHAR_HEIGHT));
+	vertices.setPrimitiveType(sf::Quads);
+	vertices.resize(EMUSCREEN_WIDTH*EMUSCREEN_HEIGHT*4);
+	for (unsigned int y = 0; y < EMUSCREEN_HEIGHT; y++) {
+		for (unsigned int x = 0; x < EMUSCREEN_WIDTH; x++) {
+			sf::Vertex *quad = &vertices[(y*EMUSCREEN_WIDTH + x)*4];
+			float left = (float)(x*TEXCHAR_WIDTH);
+			float top = (float)(y*TEXCHAR_HEIGHT);
+			quad[0].position = sf::Vector2f(left, top);
+			quad[1].position = sf::Vector2f(left+TEXCHAR_WIDTH, top);
+			quad[2].position = sf::Vector2f(left+TEXCHAR_WIDTH, top+TEXCHAR_HEIGHT);
+			quad[3].position = sf::Vector2f(left, top+TEXCHAR_HEIGHT);
+		}
+	}
 }
 
+void UpdateVertices(sf::VertexArray &vertices, ScreenBuffer &screen)
+{
+	if (!screen.IsDirty())
+		return;
+
+	screen.ForEachDirty([&vertices](unsigned int x, unsigned int y, uint8_t c) {
+		sf::Vertex *quad = &vertices[(y*EMUSCREEN_WIDTH + x)*4];
+		float left = (float)((c % TEXCHAR_CELLS) * TEXCHAR_WIDTH);
+		float top = (float)((c / TEXCHAR_CELLS) * TEXCHAR_HEIGHT);
+		quad[0].texCoords = sf::Vector2f(left, top);
+		quad[1].texCoords = sf::Vector2f(left+TEXCHAR_WIDTH, top);
+		quad[2].texCoords = sf::Vector2f(left+TEXCHAR_WIDTH, top+TEXCHAR_HEIGHT);
+		quad[3].texCoords = sf::Vector2f(left, top+TEXCHAR_HEIGHT);
+	});
+	screen.ClearDirty();
+}
\ No newline at end of file
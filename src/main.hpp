@@ -23,10 +23,16 @@
 #endif // WIN32
 
 #include <atomic>
+#include <chrono>
 #include <exception>
+#include <iomanip>
 #include <iostream>
 #include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 #ifdef __cplusplus
     #include <cstdlib>
@@ -40,8 +46,13 @@
 
 // Project libs
 //#include "SDLContext.hpp"
+#include "Disasm/Disassembler.hpp"
+#include "ScreenBuffer.hpp"
 #include "SFMLContext.hpp"
+#include "SoftwareRenderer.hpp"
+#include "TerminalContext.hpp"
 #include "System65/System65.hpp"
+#include "Trace/QueryIndex.hpp"
 
 /** \mainpage System65 Emulator
  *
@@ -134,13 +145,38 @@
 // The font file should be a texture atlas with 16x16 cells. Each cell should
 // have an 8x12 character in it. The atlas texture size should thus be 128x192
 
-#define TEXCHAR_WIDTH 8 //!< Width of a single glyph on the texture sheet
-#define TEXCHAR_HEIGHT 12 //!< Height of a single glyph on the texture sheet
-#define TEXCHAR_CELLS 16 //!< Number of cells in either direction on the texture sheet
-#define SCREEN_WIDTH 80 //!< Monitor width, in characters/columns
-#define SCREEN_HEIGHT 25 //!< Monitor height, in characters/rows
-#define EMUSCREEN_WIDTH 112 //!< Width of the entire emulator screen, in characters/columns
-#define EMUSCREEN_HEIGHT 29 //!< Height of the entire emulator screen, in characters/rows
+// The TEXCHAR_*, SCREEN_* and EMUSCREEN_* dimensions live in ScreenBuffer.hpp.
+
+/** Copy of the VM state shown on the emulator screen.
+ *
+ * The render loop copies this out of the VM while holding
+ * \ref mutMachineState, then draws from the copy with the lock released. The
+ * previous frame's copy is kept so that only the fields that changed need to be
+ * redrawn.
+ */
+struct MachineSnapshot {
+	uint8_t a; //!< Accumulator
+	uint8_t x; //!< X index
+	uint8_t y; //!< Y index
+	uint8_t s; //!< Stack pointer
+	uint8_t p; //!< Processor status flags
+	uint16_t pc; //!< Program counter
+};
+
+#define DISASM_PANEL_X 82 //!< Column of the PC marker in the disassembly panel
+#define DISASM_PANEL_Y 5 //!< First row of the disassembly panel
+#define DISASM_PANEL_ROWS 20 //!< Number of lines in the disassembly panel
+#define DISASM_PANEL_CONTEXT 3 //!< Number of lines kept above PC when the panel scrolls
+
+/** State of the disassembly panel between frames.
+ *
+ * The panel only scrolls when PC leaves it or gets close to the bottom;
+ * otherwise just the PC marker moves.
+ */
+struct DisasmPanel {
+	uint16_t start; //!< Address of the first line
+	bool valid; //!< Whether <tt>start</tt> has been set
+};
 
 System65 sys(0x10000); //!< Object for the VM itself
 
@@ -171,33 +207,189 @@ int main (int argc, char **argv);
  */
 void SystemExec(void);
 
+/** Runs the VM without a window.
+ *
+ * The VM is run on the calling thread for <tt>frames</tt> frames of
+ * <tt>framecycles</tt> cycles each. This is mostly useful for automated
+ * testing: if <tt>textprefix</tt> is given, the text framebuffer is dumped to
+ * <tt>textprefix</tt>NNNNNN.txt after each frame in which the guest wrote to
+ * it. If <tt>imageprefix</tt> is given, the whole emulator screen is rendered
+ * with a \ref SoftwareRenderer and written to <tt>imageprefix</tt>NNNNNN.png
+ * (or .ppm) every <tt>imageevery</tt> frames.
+ *
+ * \note The caller should hold \ref mutMachineState, and
+ * \ref SystemExec should not be running.
+ *
+ * \param[in] frames Number of frames to run; 0 runs forever
+ * \param[in] framecycles Number of cycles to run in each frame
+ * \param[in] textprefix Prefix for text dumps, or empty for no dumps
+ * \param[in] imageprefix Prefix for image dumps, or empty for no dumps
+ * \param[in] imageevery Number of frames between image dumps
+ * \param[in] format Format of the image dumps
+ *
+ * \return Exit code for the process
+ */
+int RunHeadless(unsigned int frames, unsigned int framecycles, const std::string &textprefix,
+	const std::string &imageprefix, unsigned int imageevery, SoftwareRenderer::ImageFormat format);
+
+/** Renders the emulator screen to an image file.
+ *
+ * Used for the screenshot key in windowed mode; the whole screen is redrawn,
+ * so <tt>screen</tt>'s dirty map is left alone.
+ *
+ * \param[in] screen Character grid to render
+ * \param[in] filename Path of the image to write
+ *
+ * \return Whether the image was written
+ */
+bool Screenshot(const ScreenBuffer &screen, const std::string &filename);
+
+/** Runs the emulator screen on the terminal instead of in a window.
+ *
+ * The screen is laid out the same as in the window, but is drawn with ANSI
+ * escape sequences by a \ref TerminalContext. Press q to quit, or Ctrl-L to
+ * redraw the whole screen.
+ *
+ * \note The caller should hold \ref mutMachineState; it is released once the
+ * screen has been set up.
+ *
+ * \param[in] unicode Whether the terminal can show UTF-8
+ *
+ * \return Exit code for the process
+ */
+int RunTerminal(bool unicode);
+
+/** Ends the trace recording, if there is one.
+ *
+ * \note SystemExec should not be running.
+ *
+ * \return Whether the trace was written out successfully
+ */
+bool StopTrace(void);
+
+/** Builds the filename of a frame dump.
+ *
+ * \param[in] prefix Prefix of the filename, including any directory
+ * \param[in] frame Frame number
+ * \param[in] ext Extension, including the dot
+ *
+ * \return <tt>prefix</tt>, the frame number padded to 6 digits, then <tt>ext</tt>
+ */
+std::string FrameFilename(const std::string &prefix, unsigned int frame, const char *ext);
+
 /** Draws the emulator screen frame.
  *
  * Draws the fancy ASCII border on the screen around the monitor, CPU status,
  * etc. Should only need to be called once at startup, but it may be called
  * whenever the border needs to be refreshed.
  *
- * \param[in] screenbuf Array of sf::Sprite representing the emulator screen
+ * \param[in] screen Character grid representing the emulator screen
  */
-void DrawScreenFrame(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT]);
+void DrawScreenFrame(ScreenBuffer &screen);
 
 /** Draws the emulator labels.
  *
  * Draws the labels that name various elements on the emulator screen.
  *
- * \param[in] screenbuf Array of sf::Sprite representing the emulator screen
+ * \param[in] screen Character grid representing the emulator screen
+ */
+void DrawLabels(ScreenBuffer &screen);
+
+/** Draws the monitor.
+ *
+ * Copies the rows of the text framebuffer that the guest wrote to since the
+ * last call into the monitor area of the emulator screen.
+ *
+ * \note The caller should hold \ref mutMachineState.
+ *
+ * \param[in] screen Character grid to draw into
+ * \param[in] fb Text framebuffer to draw from
  */
-void DrawLabels(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT]);
+void DrawMonitor(ScreenBuffer &screen, Devices::TextFramebuffer &fb);
+
+/** Copies the displayed parts of the VM state.
+ *
+ * \note The caller should hold \ref mutMachineState.
+ *
+ * \param[out] snap Snapshot to fill in
+ * \param[in] sys System65 object to get the status from
+ */
+void TakeSnapshot(MachineSnapshot *snap, System65 *sys);
 
 /** Draws the CPU stats.
  *
  * Draws the status of the various parts of the system, including the current
- * register values, etc.
+ * register values, etc. Only the fields that differ from <tt>prev</tt> are
+ * re-encoded.
  *
- * \param[in] screenbuf Sprite array to draw into
- * \param[in] sys System65 object to get the status from
+ * \param[in] screen Character grid to draw into
+ * \param[in] cur Snapshot of the current VM state
+ * \param[in] prev Snapshot that was drawn on the previous frame, or NULL to
+ * draw every field
  */
-void DrawStats(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], System65 *sys);
+void DrawStats(ScreenBuffer &screen, const MachineSnapshot &cur, const MachineSnapshot *prev);
+
+/** Draws the disassembly panel.
+ *
+ * The lines come out of <tt>disasm</tt>'s cache, and unchanged cells are
+ * ignored by the ScreenBuffer, so this is cheap to call every frame.
+ *
+ * \note The caller should hold \ref mutMachineState.
+ *
+ * \param[in] screen Character grid to draw into
+ * \param[in] disasm Disassembler for the VM
+ * \param[in,out] panel Panel state from the previous frame
+ * \param[in] pc Current program counter
+ */
+void DrawDisassembly(ScreenBuffer &screen, Disasm::Disassembler &disasm, DisasmPanel &panel, uint16_t pc);
+
+/** Writes the disassembly of a binary file to stdout.
+ *
+ * \param[in] filename File to disassemble
+ * \param[in] base Address the file would be loaded at
+ *
+ * \return Exit code for the process
+ */
+int DisassembleFile(const std::string &filename, uint16_t base);
+
+/** Answers questions about a trace and writes the answers to stdout.
+ *
+ * The questions are answered from a query index kept next to the trace, as
+ * <name>.btx; it's built on the first query, and rebuilt if the trace has
+ * changed since. Each question is one of:
+ *  - <tt>last ADDR before N</tt>: the last frame before frame N that changed
+ *    ADDR, and the value it stored
+ *  - <tt>pc ADDR</tt>: every frame that ended with PC at ADDR
+ *  - <tt>history ADDR</tt>: every change to ADDR, with its frame and value
+ *
+ * ADDR and N can be given as $NNNN, 0xNNNN or decimal.
+ *
+ * \param[in] tracefile Trace to query; the extension can be left out
+ * \param[in] queries Questions to answer, in order
+ *
+ * \return Exit code for the process
+ */
+int QueryTrace(const std::string &tracefile, const std::vector<std::string> &queries);
+
+/** Parses a number in a trace query.
+ *
+ * \param[in] str Number as $NNNN, 0xNNNN or decimal
+ * \param[in] max Largest value allowed
+ * \param[out] val Receives the value
+ *
+ * \return false if <tt>str</tt> isn't a number, or is larger than <tt>max</tt>
+ */
+bool ParseQueryNumber(const std::string &str, unsigned long max, unsigned long &val);
+
+/** Draws a value as upper-case hexadecimal.
+ *
+ * \param[in] screen Character grid to draw into
+ * \param[in] val Value to draw
+ * \param[in] digits Number of hex digits to draw
+ * \param[in] x X coordinate to start printing at
+ * \param[in] y Y coordinate to start printing at
+ */
+void DrawHex(ScreenBuffer &screen, unsigned int val, unsigned int digits, unsigned int x, unsigned int y);
 
 /** Draws a string on the emulator screen.
  *
@@ -205,23 +397,39 @@ void DrawStats(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], System65
  * printed. If the edge of the screen is encountered, the remainder will be
  * printed on the next line.
  *
- * \param[in] screenbuf Sprite array to draw into
+ * \param[in] screen Character grid to draw into
  * \param[in] str String to be drawn onto the screen
  * \param[in] x X coordinate to start printing at
  * \param[in] y Y coordinate to start printing at
  */
-void DrawString(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], const char *str, unsigned int x, unsigned int y);
+void DrawString(ScreenBuffer &screen, const char *str, unsigned int x, unsigned int y);
 
 /** Draws a character on the emulator screen.
  *
  * \note Position coords are relative to the entire emulator screen, not just
  * the monitor.
  *
- * \param[in] screenbuf Sprite array to draw into
+ * \param[in] screen Character grid to draw into
  * \param[in] c ASCII character to draw
  * \param[in] x X position to draw at
  * \param[in] y Y position to draw at
  */
-void DrawChar(sf::Sprite screenbuf[EMUSCREEN_WIDTH][EMUSCREEN_HEIGHT], char c, unsigned int x, unsigned int y);
+void DrawChar(ScreenBuffer &screen, char c, unsigned int x, unsigned int y);
+
+/** Sets up the vertex array used to render the emulator screen.
+ *
+ * Each cell of the screen is a textured quad; the positions never change after
+ * this call, only the texture coordinates do.
+ *
+ * \param[out] vertices Vertex array to set up
+ */
+void InitVertices(sf::VertexArray &vertices);
+
+/** Re-encodes the glyphs of the cells that changed since the last call.
+ *
+ * \param[in,out] vertices Vertex array set up by InitVertices()
+ * \param[in,out] screen Character grid to read from; its dirty map is cleared
+ */
+void UpdateVertices(sf::VertexArray &vertices, ScreenBuffer &screen);
 
 #endif // MAIN_HPP